@@ -1,136 +1,155 @@
 //cpp AmazonChess!\AmazonAI.h
 #pragma once
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include <limits>
+#include <memory>
+#include "AmazonAnalysisCache.h"
+#include "AmazonDfpn.h"
+#include "AmazonSearch.h"
 
 namespace AmazonChess
 {
+    // ȨļĿ¼£ AmazonTune ɣʱʹĬϿŶ
+    static const char* const EVAL_PARAMS_FILE = "AmazonEval.txt";
+
+    // ״εʱȡһȨļ
+    inline std::shared_ptr<const EvalParams> StartupEvalParams()
+    {
+        static const std::shared_ptr<const EvalParams> params = LoadEvalParams(EVAL_PARAMS_FILE);
+        return params;
+    }
+
     // ֵ˵
     // pair.first = movePacked, pair.second = arrowIndex
     // movePacked = fromIndex * (BOARD_SIZE*BOARD_SIZE) + toIndex
     // fromIndex = fromY * BOARD_SIZE + fromX
     // toIndex   = toY   * BOARD_SIZE + toX
     // arrowIndex = arrowY * BOARD_SIZE + arrowX  ޼λΪ -1
+    // ڲʹ Engine  1 ֵ = Ŷ - ԷŶȣͬȡö˳ǰߣ
+    // ĳһֱӷԷѡ֡ EVAL_PARAMS_FILE ʱеȨء
     inline std::pair<int, int> GetBestMove(const std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE>& board, Player currentPlayer)
     {
-        auto IsWithin = [](int x, int y) -> bool {
-            return x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE;
-        };
+        Engine engine(1);
+        engine.SetEvalParams(StartupEvalParams());
+        SearchLimits limits;
+        limits.maxDepth = 1;
+        SearchResult r = engine.Search(Position::FromBoard(board, currentPlayer), limits);
+        if (!r.hasMove) return { -1, -1 };
+        return { r.bestMove.MovePacked(), r.bestMove.ArrowIndex() };
+    }
 
-        auto IsCellEmpty = [&](int x, int y, const auto& b) -> bool {
-            return IsWithin(x, y) && b[y][x] == PieceType::None;
-        };
+    //  AI ĶԾʱӣ AI_GAME_TIME_MSÿּʱ AI_INCREMENT_MS
+    static constexpr int64_t AI_GAME_TIME_MS = 60000;
+    static constexpr int64_t AI_INCREMENT_MS = 1000;
 
-        static const int dirs[8][2] = {
-            {1,0},{-1,0},{0,1},{0,-1},
-            {1,1},{1,-1},{-1,1},{-1,-1}
-        };
+    static constexpr size_t AI_HASH_MB = 32;
 
-        // ĳ b ϵĿɴ񣨲ռ
-        auto GetReachable = [&](int sx, int sy, const auto& b) {
-            std::vector<std::pair<int,int>> res;
-            for (int d = 0; d < 8; ++d)
-            {
-                int dx = dirs[d][0], dy = dirs[d][1];
-                int x = sx + dx, y = sy + dy;
-                while (IsWithin(x, y) && IsCellEmpty(x, y, b))
-                {
-                    res.emplace_back(x, y);
-                    x += dx; y += dy;
-                }
-            }
-            return res;
-        };
+    //  AI 棺ֱûӦ֣̺һչĶӦ
+    // ϣֱУΪһ㣻¶Ծʱ ResetAI 
+    inline Engine& GameEngine()
+    {
+        static Engine engine(AI_HASH_MB);
+        return engine;
+    }
 
-        //  p  b ϵĿŶȣ Amazon Ŀɴ֮ͣ
-        auto Openness = [&](Player p, const auto& b) -> int {
-            PieceType at = (p == Player::White) ? PieceType::WhiteAmazon : PieceType::BlackAmazon;
-            int sum = 0;
-            for (int y = 0; y < BOARD_SIZE; ++y)
-            {
-                for (int x = 0; x < BOARD_SIZE; ++x)
-                {
-                    if (b[y][x] == at)
-                    {
-                        auto r = GetReachable(x, y, b);
-                        sum += static_cast<int>(r.size());
-                    }
-                }
-            }
-            return sum;
-        };
+    // Ựķ棨Ŀ¼£ AmazonAnalysisCache.h¶ԾûԤȣ
+    // ÿ ANALYSIS_CACHE_SAVE_SEARCHES  AI ¶Ծǰ˳ʱûȲ ANALYSIS_CACHE_MIN_DEPTH Ŀд
+    static const char* const ANALYSIS_CACHE_FILE = "AmazonCache.acc";
+    static constexpr size_t ANALYSIS_CACHE_MB = 16;
+    static constexpr int ANALYSIS_CACHE_MIN_DEPTH = 2;
+    static constexpr int ANALYSIS_CACHE_SAVE_SEARCHES = 8;
+
+    // ״εʱ򿪻棻ʧܣһʵռãʱʹû
+    inline AnalysisCache& GameAnalysisCache()
+    {
+        static AnalysisCache cache;
+        static bool opened = false;
+        if (!opened)
+        {
+            opened = true;
+            cache.Open(ANALYSIS_CACHE_FILE, ANALYSIS_CACHE_MB, EvalFingerprint(StartupEvalParams().get()));
+        }
+        return cache;
+    }
 
-        PieceType myType = (currentPlayer == Player::White) ? PieceType::WhiteAmazon : PieceType::BlackAmazon;
-        Player oppPlayer = (currentPlayer == Player::White) ? Player::Black : Player::White;
+    inline int& SearchesSinceCacheSave()
+    {
+        static int count = 0;
+        return count;
+    }
 
-        int bestScore = std::numeric_limits<int>::min();
-        std::pair<int,int> bestMove = {-1, -1};
+    inline void SaveAnalysisCache()
+    {
+        AnalysisCache& cache = GameAnalysisCache();
+        if (!cache.IsOpen()) return;
+        cache.Absorb(GameEngine().Table(), ANALYSIS_CACHE_MIN_DEPTH);
+        cache.Flush();
+        SearchesSinceCacheSave() = 0;
+    }
 
-        const int squareCount = BOARD_SIZE * BOARD_SIZE;
+    // к⣺ AI_SOLVER_MIN_ARROWS ʱǰ df-pn ֤ʤAmazonDfpn.h
+    // ԤΪ AI_SOLVER_NODES ڵȥһʱ䣻֤ʤֱ߱ʤһ֡
+    // ֱǰ֤ںֱ
+    static constexpr int AI_SOLVER_MIN_ARROWS = 30;
+    static constexpr uint64_t AI_SOLVER_NODES = 1000000;
+    static constexpr size_t AI_SOLVER_MB = 32;
 
-        // öҷÿ Amazon ÿƶĿ꣬ƶöпɷżλãտŶȲ
-        for (int y = 0; y < BOARD_SIZE; ++y)
+    inline ProofNumberSolver& GameSolver()
+    {
+        static ProofNumberSolver solver(AI_SOLVER_MB);
+        return solver;
+    }
+
+    inline void ResetAI()
+    {
+        SaveAnalysisCache();
+        GameSolver().Clear();
+        GameEngine().NewGame();
+        GameAnalysisCache().WarmTable(GameEngine().Table());
+    }
+
+    // ͬϣ clockAI һʣʱʱ䱾ʱʱڵ
+    // ʹ GameEngineinfo ǿʱд뱾ȡڵ㡢ָñȣ
+    inline std::pair<int, int> GetBestMove(const std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE>& board, Player currentPlayer, const TimeControl& clock, SearchResult* info = nullptr)
+    {
+        Engine& engine = GameEngine();
+        engine.SetEvalParams(StartupEvalParams());
+        Position pos = Position::FromBoard(board, currentPlayer);
+        SearchLimits limits;
+        limits.maxDepth = MAX_PLY;
+        limits.time = AllocateTime(clock, pos);
+        if (limits.time.softMs == 0) limits.maxDepth = 1; // ʱ꣺ֻһ
+        else if (PopCount(pos.arrows) >= AI_SOLVER_MIN_ARROWS)
         {
-            for (int x = 0; x < BOARD_SIZE; ++x)
+            SolverLimits solveLimits;
+            solveLimits.maxNodes = AI_SOLVER_NODES;
+            solveLimits.maxTimeMs = limits.time.softMs / 2;
+            SolverOutcome o = GameSolver().Solve(pos, solveLimits);
+            if (o.hasMove)
             {
-                if (board[y][x] != myType) continue;
-                auto moveTargets = GetReachable(x, y, board);
-                for (auto &mv : moveTargets)
+                if (info)
                 {
-                    int tx = mv.first, ty = mv.second;
-                    // ģƶb2
-                    auto b2 = board;
-                    b2[ty][tx] = b2[y][x];
-                    b2[y][x] = PieceType::None;
-
-                    // öټλãλó
-                    auto arrowTargets = GetReachable(tx, ty, b2);
-                    if (arrowTargets.empty())
-                    {
-                        // ûмλֱ b2
-                        int myOpen = Openness(currentPlayer, b2);
-                        int oppOpen = Openness(oppPlayer, b2);
-                        int score = myOpen - oppOpen;
-                        if (score > bestScore)
-                        {
-                            int fromIndex = y * BOARD_SIZE + x;
-                            int toIndex = ty * BOARD_SIZE + tx;
-                            int movePacked = fromIndex * squareCount + toIndex;
-                            bestScore = score;
-                            bestMove.first = movePacked;
-                            bestMove.second = -1;
-                        }
-                    }
-                    else
-                    {
-                        for (auto &at : arrowTargets)
-                        {
-                            int ax = at.first, ay = at.second;
-                            // ģżb3
-                            auto b3 = b2;
-                            b3[ay][ax] = PieceType::Arrow;
-
-                            int myOpen = Openness(currentPlayer, b3);
-                            int oppOpen = Openness(oppPlayer, b3);
-                            int score = myOpen - oppOpen;
-                            if (score > bestScore)
-                            {
-                                int fromIndex = y * BOARD_SIZE + x;
-                                int toIndex = ty * BOARD_SIZE + tx;
-                                int movePacked = fromIndex * squareCount + toIndex;
-                                int arrowIndex = ay * BOARD_SIZE + ax;
-                                bestScore = score;
-                                bestMove.first = movePacked;
-                                bestMove.second = arrowIndex;
-                            }
-                        }
-                    }
+                    *info = SearchResult();
+                    info->hasMove = true;
+                    info->bestMove = o.bestMove;
+                    info->score = MATE_BOUND; // ֤ʤδ֪
+                    info->nodes = o.nodes;
+                    info->timeMs = o.timeMs;
                 }
+                return { o.bestMove.MovePacked(), o.bestMove.ArrowIndex() };
             }
+            // δȥʱӱԤп۳
+            int64_t used = static_cast<int64_t>(o.timeMs);
+            limits.time.softMs = std::max<int64_t>(1, limits.time.softMs - used);
+            limits.time.hardMs = std::max<int64_t>(1, limits.time.hardMs - used);
         }
-
-        return bestMove;
+        SearchResult r = engine.Search(pos, limits);
+        if (++SearchesSinceCacheSave() >= ANALYSIS_CACHE_SAVE_SEARCHES) SaveAnalysisCache();
+        if (info) *info = r;
+        if (!r.hasMove) return { -1, -1 };
+        return { r.bestMove.MovePacked(), r.bestMove.ArrowIndex() };
     }
 } // namespace AmazonChess
\ No newline at end of file
@@ -0,0 +1,369 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "AmazonEvalParams.h"
+#include "AmazonJournal.h"
+#include "AmazonSearch.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 跨会话的分析缓存（.acc）：局面哈希 -> (最佳走法, 分值, 深度, 界)，以内存映射文件保存，大小固定。
+// 启动 / 新对局时把缓存条目灌入置换表（WarmTable），搜索后把置换表中足够深的条目写回（Absorb），
+// 昨天分析过的局面今天在置换表中直接命中，不再从头搜索。
+// 文件头 64 字节：magic "ACAC"、版本、评估指纹、桶数（2 的幂）、会话号、保留，末 4 字节为前 60 字节的 CRC-32；
+// 之后为 桶数 × CACHE_BUCKET_WAYS 个 16 字节条目，格式与置换表槽相同：check = key ^ data、data（小端 u64），
+// data 依次为 走法 u32、分值 i16、深度 i8、界 2 位 + 写入时的会话号 6 位。
+// 文件大小、头部校验、版本或评估指纹（权重文件变化后旧分值不再可信）不符时整个文件视为过期并清空重建；
+// 写到一半的条目（进程崩溃）check 对不上，等同于空槽。
+// 替换：同一局面只有不更浅的结果才覆盖（同深度时精确值优先）；桶满时淘汰 价值 = 深度 - CACHE_AGE_PENALTY × 会话龄 最低者。
+
+namespace AmazonChess
+{
+    static constexpr uint32_t CACHE_MAGIC = 0x43414341; // "ACAC"
+    static constexpr uint32_t CACHE_VERSION = 1;
+    static constexpr size_t CACHE_HEADER_BYTES = 64;
+    static constexpr size_t CACHE_ENTRY_BYTES = 16;
+    static constexpr size_t CACHE_BUCKET_WAYS = 4; // 一个桶 64 字节，恰为一条缓存行
+    static constexpr int CACHE_AGE_PENALTY = 2;
+
+    // 评估指纹：同一份权重得到相同的值；nullptr（开放度评估）为 0
+    inline uint32_t EvalFingerprint(const EvalParams* params)
+    {
+        if (!params) return 0;
+        uint32_t crc = 0;
+        for (int w : params->weights)
+        {
+            unsigned char b[4];
+            JournalDetail::PutU32(b, static_cast<uint32_t>(w));
+            crc = Crc32(b, sizeof(b), crc);
+        }
+        return crc | 1;
+    }
+
+    namespace CacheDetail
+    {
+        inline uint64_t GetU64(const unsigned char* p)
+        {
+            return static_cast<uint64_t>(JournalDetail::GetU32(p)) | static_cast<uint64_t>(JournalDetail::GetU32(p + 4)) << 32;
+        }
+
+        inline void PutU64(unsigned char* p, uint64_t v)
+        {
+            JournalDetail::PutU32(p, static_cast<uint32_t>(v));
+            JournalDetail::PutU32(p + 4, static_cast<uint32_t>(v >> 32));
+        }
+
+        // 可读写的共享文件映射；Open 把文件调整为 size 字节，resized 表示原文件大小不同（含新建）
+        class FileMapping
+        {
+        public:
+            FileMapping() = default;
+            ~FileMapping() { Close(); }
+
+            FileMapping(const FileMapping&) = delete;
+            FileMapping& operator=(const FileMapping&) = delete;
+
+            bool Open(const std::string& path, size_t size, bool& resized)
+            {
+                Close();
+#if defined(_WIN32)
+                file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) return false;
+                LARGE_INTEGER current;
+                if (!GetFileSizeEx(file, &current)) return Fail();
+                resized = static_cast<uint64_t>(current.QuadPart) != size;
+                if (resized)
+                {
+                    LARGE_INTEGER target;
+                    target.QuadPart = static_cast<LONGLONG>(size);
+                    if (!SetFilePointerEx(file, target, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) return Fail();
+                }
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+                if (!mapping) return Fail();
+                void* p = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+                if (!p) return Fail();
+#else
+                int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+                if (fd < 0) return false;
+                struct stat st;
+                if (fstat(fd, &st) != 0)
+                {
+                    close(fd);
+                    return false;
+                }
+                resized = static_cast<uint64_t>(st.st_size) != size;
+                if (resized && ftruncate(fd, static_cast<off_t>(size)) != 0)
+                {
+                    close(fd);
+                    return false;
+                }
+                void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd); // 映射在关闭描述符后仍然有效
+                if (p == MAP_FAILED) return false;
+#endif
+                data = static_cast<unsigned char*>(p);
+                length = size;
+                return true;
+            }
+
+            // 把已修改的页写回文件
+            bool Flush()
+            {
+                if (!data) return false;
+#if defined(_WIN32)
+                return FlushViewOfFile(data, length) != 0;
+#else
+                return msync(data, length, MS_ASYNC) == 0;
+#endif
+            }
+
+            void Close()
+            {
+#if defined(_WIN32)
+                if (data) UnmapViewOfFile(data);
+                if (mapping) CloseHandle(mapping);
+                if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+                mapping = nullptr;
+                file = INVALID_HANDLE_VALUE;
+#else
+                if (data) munmap(data, length);
+#endif
+                data = nullptr;
+                length = 0;
+            }
+
+            unsigned char* Data() const { return data; }
+            size_t Size() const { return length; }
+
+        private:
+#if defined(_WIN32)
+            bool Fail()
+            {
+                Close();
+                return false;
+            }
+
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#endif
+            unsigned char* data = nullptr;
+            size_t length = 0;
+        };
+    } // namespace CacheDetail
+
+    class AnalysisCache
+    {
+    public:
+        enum class OpenResult { Failed, Loaded, Created, Discarded };
+
+        AnalysisCache() = default;
+        ~AnalysisCache() { Close(); }
+
+        AnalysisCache(const AnalysisCache&) = delete;
+        AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+        // 打开或新建缓存文件（大小按 megabytes 取不超过它的 2 的幂个桶）；
+        // 已有文件与大小 / 版本 / fingerprint 不符或头部损坏时返回 Discarded 并清空重建
+        OpenResult Open(const std::string& path, size_t megabytes, uint32_t fingerprint)
+        {
+            Close();
+            size_t buckets = 1;
+            size_t wanted = std::max<size_t>(1, megabytes) * 1024 * 1024 / (CACHE_BUCKET_WAYS * CACHE_ENTRY_BYTES);
+            while (buckets * 2 <= wanted) buckets *= 2;
+            bool resized = false;
+            if (!file.Open(path, CACHE_HEADER_BYTES + buckets * CACHE_BUCKET_WAYS * CACHE_ENTRY_BYTES, resized)) return OpenResult::Failed;
+            bucketMask = buckets - 1;
+            entries = file.Data() + CACHE_HEADER_BYTES;
+
+            OpenResult result = OpenResult::Loaded;
+            if (resized || !HeaderMatches(buckets, fingerprint))
+            {
+                // 新建的文件全为 0，不是 0 的说明是过期或损坏的旧文件
+                result = OpenResult::Created;
+                const unsigned char* p = file.Data();
+                for (size_t i = 0; i < file.Size(); ++i)
+                {
+                    if (p[i])
+                    {
+                        result = OpenResult::Discarded;
+                        break;
+                    }
+                }
+                if (result == OpenResult::Discarded) std::memset(file.Data(), 0, file.Size());
+                session = 0;
+            }
+            else
+            {
+                session = (JournalDetail::GetU32(file.Data() + 16) + 1) & TranspositionTable::GENERATION_MASK;
+            }
+            WriteHeader(buckets, fingerprint);
+            return result;
+        }
+
+        bool IsOpen() const { return file.Data() != nullptr; }
+        size_t Capacity() const { return IsOpen() ? (bucketMask + 1) * CACHE_BUCKET_WAYS : 0; }
+
+        bool Probe(uint64_t key, TranspositionTable::Entry& out) const
+        {
+            if (!IsOpen()) return false;
+            const unsigned char* bucket = Bucket(key);
+            for (size_t w = 0; w < CACHE_BUCKET_WAYS; ++w)
+            {
+                TranspositionTable::Entry e;
+                if (ReadEntry(bucket + w * CACHE_ENTRY_BYTES, e) && e.key == key)
+                {
+                    out = e;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 写入一条搜索结果（score 为置换表中的存储值，杀棋分按“距该局面”计）；返回是否写入
+        bool Store(uint64_t key, int depth, int score, uint8_t bound, uint32_t move)
+        {
+            if (!IsOpen() || depth <= 0 || bound == TranspositionTable::BoundNone) return false;
+            unsigned char* bucket = Bucket(key);
+            unsigned char* victim = nullptr;
+            int victimWorth = 0;
+            for (size_t w = 0; w < CACHE_BUCKET_WAYS; ++w)
+            {
+                unsigned char* slot = bucket + w * CACHE_ENTRY_BYTES;
+                TranspositionTable::Entry e;
+                if (!ReadEntry(slot, e))
+                {
+                    if (!victim || victimWorth > INT32_MIN)
+                    {
+                        victim = slot;
+                        victimWorth = INT32_MIN;
+                    }
+                    continue;
+                }
+                if (e.key == key)
+                {
+                    if (depth < e.depth) return false;
+                    if (depth == e.depth && bound != TranspositionTable::BoundExact && e.bound == TranspositionTable::BoundExact) return false;
+                    if (move == NULL_MOVE_CODE) move = e.move;
+                    WriteEntry(slot, key, depth, score, bound, move);
+                    return true;
+                }
+                int age = static_cast<int>((session - e.generation) & TranspositionTable::GENERATION_MASK);
+                int worth = e.depth - CACHE_AGE_PENALTY * age;
+                if (!victim || worth < victimWorth)
+                {
+                    victim = slot;
+                    victimWorth = worth;
+                }
+            }
+            if (depth < victimWorth) return false;
+            WriteEntry(victim, key, depth, score, bound, move);
+            return true;
+        }
+
+        // 把置换表中深度不低于 minDepth 的条目写入缓存，返回写入条数
+        size_t Absorb(const TranspositionTable& tt, int minDepth)
+        {
+            size_t stored = 0;
+            tt.ForEach([&](const TranspositionTable::Entry& e) {
+                if (e.depth >= minDepth && Store(e.key, e.depth, e.score, e.bound, e.move)) ++stored;
+            });
+            return stored;
+        }
+
+        // 把全部有效条目灌入置换表，返回条数
+        size_t WarmTable(TranspositionTable& tt) const
+        {
+            if (!IsOpen()) return 0;
+            size_t loaded = 0;
+            for (size_t i = 0; i < Capacity(); ++i)
+            {
+                TranspositionTable::Entry e;
+                if (!ReadEntry(entries + i * CACHE_ENTRY_BYTES, e)) continue;
+                tt.Store(e.key, e.depth, e.score, static_cast<TranspositionTable::Bound>(e.bound), e.move);
+                ++loaded;
+            }
+            return loaded;
+        }
+
+        bool Flush() { return file.Flush(); }
+
+        void Close()
+        {
+            if (IsOpen()) file.Flush();
+            file.Close();
+            entries = nullptr;
+            bucketMask = 0;
+        }
+
+    private:
+        bool HeaderMatches(size_t buckets, uint32_t fingerprint) const
+        {
+            const unsigned char* h = file.Data();
+            return JournalDetail::GetU32(h) == CACHE_MAGIC
+                && JournalDetail::GetU32(h + 4) == CACHE_VERSION
+                && JournalDetail::GetU32(h + 8) == fingerprint
+                && JournalDetail::GetU32(h + 12) == buckets
+                && JournalDetail::GetU32(h + 60) == Crc32(h, 60);
+        }
+
+        void WriteHeader(size_t buckets, uint32_t fingerprint)
+        {
+            unsigned char* h = file.Data();
+            std::memset(h, 0, CACHE_HEADER_BYTES);
+            JournalDetail::PutU32(h, CACHE_MAGIC);
+            JournalDetail::PutU32(h + 4, CACHE_VERSION);
+            JournalDetail::PutU32(h + 8, fingerprint);
+            JournalDetail::PutU32(h + 12, static_cast<uint32_t>(buckets));
+            JournalDetail::PutU32(h + 16, session);
+            JournalDetail::PutU32(h + 60, Crc32(h, 60));
+        }
+
+        unsigned char* Bucket(uint64_t key) const
+        {
+            return entries + (key & bucketMask) * CACHE_BUCKET_WAYS * CACHE_ENTRY_BYTES;
+        }
+
+        // 读出一个槽；空槽、写坏的槽（check 不符导致的随机键极少命中）以及字段越界的槽返回 false
+        static bool ReadEntry(const unsigned char* slot, TranspositionTable::Entry& out)
+        {
+            uint64_t data = CacheDetail::GetU64(slot + 8);
+            if (data == 0) return false;
+            out.key = CacheDetail::GetU64(slot) ^ data;
+            out.move = static_cast<uint32_t>(data);
+            out.score = static_cast<int16_t>(data >> 32);
+            out.depth = static_cast<int8_t>(data >> 48);
+            out.bound = static_cast<uint8_t>(data >> 56) & 3;
+            out.generation = static_cast<uint8_t>(data >> 58);
+            if (out.bound == TranspositionTable::BoundNone || out.depth <= 0 || out.depth > MAX_PLY) return false;
+            if (out.move != NULL_MOVE_CODE)
+            {
+                Move m = Move::FromCode(out.move);
+                if ((out.move >> 24) || m.from >= SQUARE_COUNT || m.to >= SQUARE_COUNT || m.arrow >= SQUARE_COUNT) return false;
+            }
+            return true;
+        }
+
+        void WriteEntry(unsigned char* slot, uint64_t key, int depth, int score, uint8_t bound, uint32_t move) const
+        {
+            uint64_t data = static_cast<uint64_t>(move)
+                | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 32
+                | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+                | static_cast<uint64_t>(bound | session << 2) << 56;
+            CacheDetail::PutU64(slot, key ^ data);
+            CacheDetail::PutU64(slot + 8, data);
+        }
+
+        CacheDetail::FileMapping file;
+        unsigned char* entries = nullptr;
+        size_t bucketMask = 0;
+        uint32_t session = 0;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,181 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AmazonMobilityKernel.h"
+#include "AmazonSearch.h"
+
+// 批量开放度评估：N 个局面按结构数组（白 Amazon / 黑 Amazon / 箭 / 走子方各一列）存放，
+// AVX2 内核每个寄存器的 4 个 64 位通道各放一个局面，以 Kogge-Stone 填充同时求 4 个局面的女王可达格，
+// 不支持 AVX2 时逐局面计算。结果与 Evaluate(pos, ply)（开放度评估）完全一致。
+// 用于 MCTS 叶节点批量、数据集标注、调优等一次评估大量局面的场合。
+
+namespace AmazonChess
+{
+    struct PositionBatch
+    {
+        std::vector<Bitboard> white;
+        std::vector<Bitboard> black;
+        std::vector<Bitboard> arrows;
+        std::vector<uint8_t> sideToMove; // Player 下标
+
+        size_t Size() const { return white.size(); }
+
+        void Clear()
+        {
+            white.clear();
+            black.clear();
+            arrows.clear();
+            sideToMove.clear();
+        }
+
+        void Reserve(size_t n)
+        {
+            white.reserve(n);
+            black.reserve(n);
+            arrows.reserve(n);
+            sideToMove.reserve(n);
+        }
+
+        void Add(const Position& pos)
+        {
+            white.push_back(pos.amazons[0]);
+            black.push_back(pos.amazons[1]);
+            arrows.push_back(pos.arrows);
+            sideToMove.push_back(static_cast<uint8_t>(pos.sideToMove));
+        }
+    };
+
+    // 逐局面计算双方开放度（batch 中第 begin..end-1 个）
+    inline void BatchMobilityScalar(const PositionBatch& batch, size_t begin, size_t end, int* white, int* black)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Bitboard occ = batch.white[i] | batch.black[i] | batch.arrows[i];
+            int sums[2] = { 0, 0 };
+            Bitboard sides[2] = { batch.white[i], batch.black[i] };
+            for (int p = 0; p < 2; ++p)
+            {
+                while (sides[p])
+                {
+                    int sq = PopLowest(sides[p]);
+                    sums[p] += PopCount(QueenReach(sq, occ));
+                }
+            }
+            white[i] = sums[0];
+            black[i] = sums[1];
+        }
+    }
+
+#if defined(AMAZON_MOBILITY_X86)
+    namespace BatchDetail
+    {
+        static constexpr uint64_t NOT_FILE_A = ~0x0101010101010101ull; // 目标格 x != 0（向 x 增大方向移动时）
+        static constexpr uint64_t NOT_FILE_H = ~0x8080808080808080ull; // 目标格 x != 7
+
+        template <int S>
+        AMAZON_TARGET_AVX2 inline __m256i Shift(__m256i v)
+        {
+            return S > 0 ? _mm256_slli_epi64(v, S > 0 ? S : 0) : _mm256_srli_epi64(v, S < 0 ? -S : 0);
+        }
+
+        // 沿一个方向的可达空格：Kogge-Stone 遮挡填充（三步覆盖七格），再移一步并去掉阻挡格
+        template <int S>
+        AMAZON_TARGET_AVX2 inline __m256i DirectionReach(__m256i gen, __m256i empty, __m256i fileMask)
+        {
+            __m256i pro = _mm256_and_si256(empty, fileMask);
+            gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<S>(gen)));
+            pro = _mm256_and_si256(pro, Shift<S>(pro));
+            gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<2 * S>(gen)));
+            pro = _mm256_and_si256(pro, Shift<2 * S>(pro));
+            gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<4 * S>(gen)));
+            return _mm256_and_si256(Shift<S>(gen), _mm256_and_si256(empty, fileMask));
+        }
+
+        // 每个 64 位通道的 popcount（半字节查表 + SAD）
+        AMAZON_TARGET_AVX2 inline __m256i PopCount64(__m256i v)
+        {
+            const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low = _mm256_set1_epi8(0x0F);
+            __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+            __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+            return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+        }
+
+        // 一方全部 Amazon 的可达格数之和：每轮取出各通道最低位的一个 Amazon，直到所有通道取空
+        AMAZON_TARGET_AVX2 inline __m256i SideMobility(__m256i amazons, __m256i empty)
+        {
+            const __m256i notA = _mm256_set1_epi64x(static_cast<long long>(NOT_FILE_A));
+            const __m256i notH = _mm256_set1_epi64x(static_cast<long long>(NOT_FILE_H));
+            const __m256i all = _mm256_set1_epi64x(-1);
+            __m256i total = _mm256_setzero_si256();
+            while (!_mm256_testz_si256(amazons, amazons))
+            {
+                __m256i one = _mm256_and_si256(amazons, _mm256_sub_epi64(_mm256_setzero_si256(), amazons));
+                amazons = _mm256_xor_si256(amazons, one);
+                __m256i reach = _mm256_or_si256(
+                    _mm256_or_si256(DirectionReach<1>(one, empty, notA), DirectionReach<-1>(one, empty, notH)),
+                    _mm256_or_si256(DirectionReach<8>(one, empty, all), DirectionReach<-8>(one, empty, all)));
+                reach = _mm256_or_si256(reach, _mm256_or_si256(
+                    _mm256_or_si256(DirectionReach<9>(one, empty, notA), DirectionReach<7>(one, empty, notH)),
+                    _mm256_or_si256(DirectionReach<-7>(one, empty, notA), DirectionReach<-9>(one, empty, notH))));
+                total = _mm256_add_epi64(total, PopCount64(reach));
+            }
+            return total;
+        }
+
+        AMAZON_TARGET_AVX2 inline void BatchMobilityAvx2(const PositionBatch& batch, size_t count, int* white, int* black)
+        {
+            size_t i = 0;
+            alignas(32) uint64_t w[4], b[4];
+            for (; i + 4 <= count; i += 4)
+            {
+                __m256i wa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.white[i]));
+                __m256i ba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.black[i]));
+                __m256i ar = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.arrows[i]));
+                __m256i empty = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(wa, ba), ar), _mm256_set1_epi64x(-1));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(w), SideMobility(wa, empty));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(b), SideMobility(ba, empty));
+                for (int k = 0; k < 4; ++k)
+                {
+                    white[i + k] = static_cast<int>(w[k]);
+                    black[i + k] = static_cast<int>(b[k]);
+                }
+            }
+            BatchMobilityScalar(batch, i, count, white, black);
+        }
+    } // namespace BatchDetail
+#endif
+
+    // 双方开放度（white / black 各 batch.Size() 个）；useSimd 为 false 时强制逐局面计算（用于对比）
+    inline void BatchMobility(const PositionBatch& batch, int* white, int* black, bool useSimd = true)
+    {
+#if defined(AMAZON_MOBILITY_X86)
+        if (useSimd && ActiveMobilityKernel() == MobilityKernel::Avx2)
+        {
+            BatchDetail::BatchMobilityAvx2(batch, batch.Size(), white, black);
+            return;
+        }
+#endif
+        (void)useSimd;
+        BatchMobilityScalar(batch, 0, batch.Size(), white, black);
+    }
+
+    // 批量静态评估：scores[i] == Evaluate(第 i 个局面, ply)。scratch 由调用方复用，避免每批分配
+    inline void EvaluateBatch(const PositionBatch& batch, int ply, int* scores, std::vector<int>& scratch, bool useSimd = true)
+    {
+        size_t n = batch.Size();
+        scratch.resize(2 * n);
+        int* white = scratch.data();
+        int* black = white + n;
+        BatchMobility(batch, white, black, useSimd);
+        for (size_t i = 0; i < n; ++i)
+        {
+            int mine = batch.sideToMove[i] == 0 ? white[i] : black[i];
+            int theirs = batch.sideToMove[i] == 0 ? black[i] : white[i];
+            scores[i] = mine == 0 ? -MATE_SCORE + ply : mine - theirs;
+        }
+    }
+} // namespace AmazonChess
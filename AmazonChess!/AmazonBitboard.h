@@ -0,0 +1,411 @@
+﻿#pragma once
+
+#include <array>
+#include <cstdint>
+#include "AmazonCore.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 位棋盘局面表示与走法生成（与平台无关，供 AI 与无界面工具使用）
+// 格子编号 square = y * BOARD_SIZE + x，与 GetBestMove 返回值中的 index 编码一致。
+
+namespace AmazonChess
+{
+    using Bitboard = uint64_t;
+
+    static constexpr int SQUARE_COUNT = BOARD_SIZE * BOARD_SIZE;
+
+    // 单个 Amazon 最多 27 个可达格，箭同理，4 个 Amazon 的走法总数上限
+    static constexpr int MAX_MOVES = 4 * 27 * 27;
+
+    // 八个方向，顺序与 Game::GetReachableFrom / GetBestMove 保持一致
+    static constexpr int DIRECTION_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    static constexpr int DIRECTION_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+    inline int SquareOf(int x, int y) { return y * BOARD_SIZE + x; }
+    inline int SquareOf(const Pos& p) { return SquareOf(p.x, p.y); }
+    inline Pos PosOf(int square) { return Pos(square % BOARD_SIZE, square / BOARD_SIZE); }
+    inline Bitboard SquareBit(int square) { return Bitboard(1) << square; }
+
+    inline int PopCount(Bitboard b)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(b));
+#elif defined(__GNUC__)
+        return __builtin_popcountll(b);
+#else
+        b = b - ((b >> 1) & 0x5555555555555555ULL);
+        b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+        b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((b * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // 最低位 1 的格子编号（b 不能为 0）
+    inline int LowestSquare(Bitboard b)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long idx;
+        _BitScanForward64(&idx, b);
+        return static_cast<int>(idx);
+#elif defined(__GNUC__)
+        return __builtin_ctzll(b);
+#else
+        return PopCount((b & (0 - b)) - 1);
+#endif
+    }
+
+    // 最高位 1 的格子编号（b 不能为 0）
+    inline int HighestSquare(Bitboard b)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long idx;
+        _BitScanReverse64(&idx, b);
+        return static_cast<int>(idx);
+#elif defined(__GNUC__)
+        return 63 - __builtin_clzll(b);
+#else
+        int idx = 0;
+        while (b >>= 1) ++idx;
+        return idx;
+#endif
+    }
+
+    inline int PopLowest(Bitboard& b)
+    {
+        int sq = LowestSquare(b);
+        b &= b - 1;
+        return sq;
+    }
+
+    // 射线表：rays[d][sq] 为从 sq 出发沿方向 d（不含 sq）直到棋盘边缘的所有格子
+    struct RayTable
+    {
+        Bitboard rays[8][SQUARE_COUNT];
+    };
+
+    constexpr RayTable MakeRayTable()
+    {
+        RayTable t{};
+        for (int d = 0; d < 8; ++d)
+        {
+            for (int sq = 0; sq < SQUARE_COUNT; ++sq)
+            {
+                Bitboard r = 0;
+                int x = sq % BOARD_SIZE + DIRECTION_DX[d];
+                int y = sq / BOARD_SIZE + DIRECTION_DY[d];
+                while (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE)
+                {
+                    r |= Bitboard(1) << (y * BOARD_SIZE + x);
+                    x += DIRECTION_DX[d];
+                    y += DIRECTION_DY[d];
+                }
+                t.rays[d][sq] = r;
+            }
+        }
+        return t;
+    }
+
+    static constexpr RayTable RAYS = MakeRayTable();
+
+    // 方向是否朝编号增大的一侧（决定阻挡格取最低位还是最高位）
+    inline bool IsPositiveDirection(int d)
+    {
+        return DIRECTION_DY[d] > 0 || (DIRECTION_DY[d] == 0 && DIRECTION_DX[d] > 0);
+    }
+
+    // 从 sq 出发按女王走法、被 occupied 阻挡时的可达格集合（不含阻挡格本身）
+    inline Bitboard QueenReach(int sq, Bitboard occupied)
+    {
+        Bitboard reach = 0;
+        for (int d = 0; d < 8; ++d)
+        {
+            Bitboard ray = RAYS.rays[d][sq];
+            Bitboard blockers = ray & occupied;
+            if (blockers)
+            {
+                int b = IsPositiveDirection(d) ? LowestSquare(blockers) : HighestSquare(blockers);
+                ray ^= RAYS.rays[d][b] | SquareBit(b);
+            }
+            reach |= ray;
+        }
+        return reach;
+    }
+
+    // Zobrist 键：每格三种占用（白 Amazon / 黑 Amazon / 箭）与轮到黑方
+    struct ZobristTable
+    {
+        uint64_t piece[3][SQUARE_COUNT];
+        uint64_t blackToMove;
+    };
+
+    constexpr uint64_t SplitMix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr ZobristTable MakeZobristTable()
+    {
+        ZobristTable t{};
+        uint64_t state = 0x416D617A6F6E4368ULL;
+        for (int k = 0; k < 3; ++k)
+            for (int sq = 0; sq < SQUARE_COUNT; ++sq)
+                t.piece[k][sq] = SplitMix64(state);
+        t.blackToMove = SplitMix64(state);
+        return t;
+    }
+
+    static constexpr ZobristTable ZOBRIST = MakeZobristTable();
+
+    // 一手完整走子：移动 Amazon 后发箭
+    struct Move
+    {
+        uint8_t from;
+        uint8_t to;
+        uint8_t arrow;
+
+        bool operator==(const Move& o) const { return from == o.from && to == o.to && arrow == o.arrow; }
+        bool operator!=(const Move& o) const { return !(*this == o); }
+
+        // 与 GetBestMove 相同的编码：first = from*64+to，second = arrow
+        int MovePacked() const { return from * SQUARE_COUNT + to; }
+        int ArrowIndex() const { return arrow; }
+
+        // 紧凑 24 位编码（用于置换表等）
+        uint32_t Code() const { return uint32_t(from) | (uint32_t(to) << 8) | (uint32_t(arrow) << 16); }
+        static Move FromCode(uint32_t code)
+        {
+            Move m;
+            m.from = uint8_t(code & 0xFF);
+            m.to = uint8_t((code >> 8) & 0xFF);
+            m.arrow = uint8_t((code >> 16) & 0xFF);
+            return m;
+        }
+    };
+
+    // 紧凑编码中表示“无走法”
+    static constexpr uint32_t NULL_MOVE_CODE = 0xFFFFFFFFu;
+
+    inline Move MoveOf(int from, int to, int arrow)
+    {
+        Move m;
+        m.from = uint8_t(from);
+        m.to = uint8_t(to);
+        m.arrow = uint8_t(arrow);
+        return m;
+    }
+
+    struct MoveList
+    {
+        std::array<Move, MAX_MOVES> moves;
+        int count = 0;
+
+        void Add(const Move& m) { moves[count++] = m; }
+        const Move& operator[](int i) const { return moves[i]; }
+        Move& operator[](int i) { return moves[i]; }
+    };
+
+    // 位棋盘局面：两方 Amazon、箭与轮到哪方，附带增量维护的 Zobrist 键
+    struct Position
+    {
+        Bitboard amazons[2] = { 0, 0 };
+        Bitboard arrows = 0;
+        Player sideToMove = Player::White;
+        uint64_t hash = 0;
+
+        Bitboard Occupied() const { return amazons[0] | amazons[1] | arrows; }
+        Bitboard AmazonsOf(Player p) const { return amazons[static_cast<int>(p)]; }
+
+        PieceType PieceAt(int sq) const
+        {
+            Bitboard bit = SquareBit(sq);
+            if (amazons[0] & bit) return PieceType::WhiteAmazon;
+            if (amazons[1] & bit) return PieceType::BlackAmazon;
+            if (arrows & bit) return PieceType::Arrow;
+            return PieceType::None;
+        }
+
+        // 放置 / 移除单个棋子（同时维护 hash），调用方保证目标格状态正确
+        void Put(PieceType type, int sq)
+        {
+            Bitboard bit = SquareBit(sq);
+            switch (type)
+            {
+            case PieceType::WhiteAmazon: amazons[0] |= bit; hash ^= ZOBRIST.piece[0][sq]; break;
+            case PieceType::BlackAmazon: amazons[1] |= bit; hash ^= ZOBRIST.piece[1][sq]; break;
+            case PieceType::Arrow:       arrows |= bit;     hash ^= ZOBRIST.piece[2][sq]; break;
+            default: break;
+            }
+        }
+
+        void Remove(int sq)
+        {
+            Bitboard bit = SquareBit(sq);
+            if (amazons[0] & bit) { amazons[0] &= ~bit; hash ^= ZOBRIST.piece[0][sq]; }
+            else if (amazons[1] & bit) { amazons[1] &= ~bit; hash ^= ZOBRIST.piece[1][sq]; }
+            else if (arrows & bit) { arrows &= ~bit; hash ^= ZOBRIST.piece[2][sq]; }
+        }
+
+        void SetSideToMove(Player p)
+        {
+            if ((sideToMove == Player::Black) != (p == Player::Black)) hash ^= ZOBRIST.blackToMove;
+            sideToMove = p;
+        }
+
+        // 执行一手：sideToMove 的 Amazon from->to，再在 arrow 放箭，之后交换走子方
+        void Play(const Move& m)
+        {
+            int side = static_cast<int>(sideToMove);
+            Bitboard fromTo = SquareBit(m.from) | SquareBit(m.to);
+            amazons[side] ^= fromTo;
+            arrows |= SquareBit(m.arrow);
+            hash ^= ZOBRIST.piece[side][m.from] ^ ZOBRIST.piece[side][m.to] ^ ZOBRIST.piece[2][m.arrow] ^ ZOBRIST.blackToMove;
+            sideToMove = Opponent(sideToMove);
+        }
+
+        // 撤销 Play（m 必须是最近一次执行的走子）
+        void Undo(const Move& m)
+        {
+            sideToMove = Opponent(sideToMove);
+            int side = static_cast<int>(sideToMove);
+            Bitboard fromTo = SquareBit(m.from) | SquareBit(m.to);
+            amazons[side] ^= fromTo;
+            arrows &= ~SquareBit(m.arrow);
+            hash ^= ZOBRIST.piece[side][m.from] ^ ZOBRIST.piece[side][m.to] ^ ZOBRIST.piece[2][m.arrow] ^ ZOBRIST.blackToMove;
+        }
+
+        // 对局开始时的默认布局（与 Game::Reset 相同），白方先走
+        static Position Initial()
+        {
+            Position pos;
+            static const int white[4][2] = { {0,2},{2,0},{5,0},{7,2} };
+            static const int black[4][2] = { {0,5},{2,7},{5,7},{7,5} };
+            for (int i = 0; i < 4; ++i)
+            {
+                pos.Put(PieceType::WhiteAmazon, SquareOf(white[i][0], white[i][1]));
+                pos.Put(PieceType::BlackAmazon, SquareOf(black[i][0], black[i][1]));
+            }
+            return pos;
+        }
+
+        // 由 board[y][x] 形式的 PieceType 数组构造（AI 接口使用的棋盘格式）
+        static Position FromBoard(const std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE>& board, Player toMove)
+        {
+            Position pos;
+            for (int y = 0; y < BOARD_SIZE; ++y)
+                for (int x = 0; x < BOARD_SIZE; ++x)
+                    pos.Put(board[y][x], SquareOf(x, y));
+            pos.SetSideToMove(toMove);
+            return pos;
+        }
+
+        void ToBoard(std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE>& board) const
+        {
+            for (int y = 0; y < BOARD_SIZE; ++y)
+                for (int x = 0; x < BOARD_SIZE; ++x)
+                    board[y][x] = PieceAt(SquareOf(x, y));
+        }
+    };
+
+    // 开放度：玩家 p 所有 Amazon 的可达格数量之和（与 GetBestMove 的 Openness 相同）
+    inline int Mobility(const Position& pos, Player p)
+    {
+        Bitboard occ = pos.Occupied();
+        Bitboard mine = pos.AmazonsOf(p);
+        int sum = 0;
+        while (mine)
+        {
+            int sq = PopLowest(mine);
+            sum += PopCount(QueenReach(sq, occ));
+        }
+        return sum;
+    }
+
+    // 检查走子是否合法（以 pos.sideToMove 为走子方）
+    inline bool IsLegalMove(const Position& pos, const Move& m)
+    {
+        if (m.from >= SQUARE_COUNT || m.to >= SQUARE_COUNT || m.arrow >= SQUARE_COUNT) return false;
+        if (!(pos.AmazonsOf(pos.sideToMove) & SquareBit(m.from))) return false;
+        Bitboard occ = pos.Occupied();
+        if (!(QueenReach(m.from, occ) & SquareBit(m.to))) return false;
+        Bitboard occAfter = (occ ^ SquareBit(m.from)) | SquareBit(m.to);
+        return (QueenReach(m.to, occAfter) & SquareBit(m.arrow)) != 0;
+    }
+
+    // 枚举走子方全部合法走法。
+    // 枚举顺序与 GetBestMove 原实现一致：按格子编号遍历 Amazon，方向顺序同 DIRECTION_*，由近及远
+    inline void GenerateMoves(const Position& pos, MoveList& list)
+    {
+        list.count = 0;
+        Bitboard occ = pos.Occupied();
+        Bitboard mine = pos.AmazonsOf(pos.sideToMove);
+        while (mine)
+        {
+            int from = PopLowest(mine);
+            Bitboard occFrom = occ ^ SquareBit(from);
+            for (int d = 0; d < 8; ++d)
+            {
+                int tx = from % BOARD_SIZE + DIRECTION_DX[d];
+                int ty = from / BOARD_SIZE + DIRECTION_DY[d];
+                while (tx >= 0 && tx < BOARD_SIZE && ty >= 0 && ty < BOARD_SIZE)
+                {
+                    int to = SquareOf(tx, ty);
+                    if (occ & SquareBit(to)) break;
+                    Bitboard occTo = occFrom | SquareBit(to);
+                    for (int e = 0; e < 8; ++e)
+                    {
+                        int ax = tx + DIRECTION_DX[e];
+                        int ay = ty + DIRECTION_DY[e];
+                        while (ax >= 0 && ax < BOARD_SIZE && ay >= 0 && ay < BOARD_SIZE)
+                        {
+                            int arrow = SquareOf(ax, ay);
+                            if (occTo & SquareBit(arrow)) break;
+                            list.Add(MoveOf(from, to, arrow));
+                            ax += DIRECTION_DX[e];
+                            ay += DIRECTION_DY[e];
+                        }
+                    }
+                    tx += DIRECTION_DX[d];
+                    ty += DIRECTION_DY[d];
+                }
+            }
+        }
+    }
+
+    // 走子方是否至少有一手合法走法（Amazon 能移动即必然能发箭：原格已空出）
+    inline bool HasAnyMove(const Position& pos)
+    {
+        Bitboard occ = pos.Occupied();
+        Bitboard mine = pos.AmazonsOf(pos.sideToMove);
+        while (mine)
+        {
+            if (QueenReach(PopLowest(mine), occ)) return true;
+        }
+        return false;
+    }
+
+    // 玩家 p 的 Amazon 是否全部无路可走
+    inline bool IsTrapped(const Position& pos, Player p)
+    {
+        Bitboard occ = pos.Occupied();
+        Bitboard mine = pos.AmazonsOf(p);
+        while (mine)
+        {
+            if (QueenReach(PopLowest(mine), occ)) return false;
+        }
+        return true;
+    }
+
+    // 与 Game::GetWinner 相同：白方被封死则黑胜，否则黑方被封死则白胜，未结束返回 None
+    inline Player WinnerOf(const Position& pos)
+    {
+        if (IsTrapped(pos, Player::White)) return Player::Black;
+        if (IsTrapped(pos, Player::Black)) return Player::White;
+        return Player::None;
+    }
+} // namespace AmazonChess
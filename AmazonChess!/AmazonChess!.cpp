@@ -9,9 +9,9 @@
 #include <chrono>
 #include <string>
 #include <fstream>
-#include <sstream>
 #include <locale>
 #include <codecvt>
+#include <cstdio>
 #include <commdlg.h>
 #include <thread>           // 新增：用于 sleep_for
 #include "AmazonAI.h"
@@ -36,6 +36,9 @@ static ULONG_PTR g_gdiplusToken = 0;
 static bool g_isReplaying = false; // 当从记谱文件重放时设为 true，避免触发 AI
 static bool g_stepReplay = false;  // 如果为 true，表示处于按空格逐步显示的重放模式
 static size_t g_replayIndex = 0;   // 重放中下一个要执行的记谱索引
+static int64_t g_aiRemainingMs = AI_GAME_TIME_MS; // AI 对局时钟剩余时间，Game::Reset 时复位
+static const int64_t AI_DISPLAY_DELAY_MS = 1000; // AI 走子 / 发箭前的展示停顿（思考时间计入其中）
+static const char* const AUTOSAVE_JOURNAL = "Autosave.acj"; // 自动存档日志（工作目录下，与 Initialization.acp 相同）
 
 // 此代码模块中包含的函数的前向声明:
 ATOM                MyRegisterClass(HINSTANCE hInstance);
@@ -87,16 +90,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return FALSE;
     }
 
-    // 载入资源并重置游戏
+    // 载入资源
     GetGlobalGame().LoadResources(hInstance);
-    GetGlobalGame().Reset();
 
-    // 启动时立即执行一次 New：若存在 Initialization.acp 则作为初始局面载入（若失败则保持默认 Reset）
+    // 正常退出时会删除自动存档日志，日志仍在说明上次进程崩溃或被杀：从日志恢复未结束的对局；否则重置游戏并执行一次 New。
+    // 必须在 Reset 之前，Reset 会新建日志
+    if (GetGlobalGame().RecoverAutosave())
     {
-        // 尝试静默载入项目目录下的 Initialization.acp
-        std::wstring initFile = L"Initialization.acp";
-        // 使用 LoadFromFile，会在内部将 g_isReplaying 设置/清除
-        GetGlobalGame().LoadFromFile(initFile);
+        if (g_hMainWnd) InvalidateRect(g_hMainWnd, NULL, TRUE);
+    }
+    else
+    {
+        // 启动时立即执行一次 New：若存在 Initialization.acp 则作为初始局面载入（若失败则保持默认 Reset）
+        if (!GetGlobalGame().LoadInitialPosition(L"Initialization.acp")) GetGlobalGame().Reset();
         // 强制首次重绘，确保界面更新（若窗口已创建）
         if (g_hMainWnd) InvalidateRect(g_hMainWnd, NULL, TRUE);
     }
@@ -115,7 +121,9 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         }
     }
 
-    // 退出前清理
+    // 退出前清理：正常退出不恢复本局，删除自动存档日志；本局的搜索结果写回分析缓存
+    GetGlobalGame().DiscardAutosave();
+    SaveAnalysisCache();
     GdiPlusShutdown();
 
     return (int) msg.wParam;
@@ -198,29 +206,50 @@ namespace AmazonChess
         return *g_gameInstance;
     }
 
-    // 辅助：把 Pos 格式化为 "x,y"
-    static std::wstring PosToString(const Pos& p)
+    // 辅助：记谱行只含 ASCII，宽字符行转为窄字符后交给 ParseRecordLine（去掉 BOM，非 ASCII 字符使解析失败）
+    static std::string NarrowRecordLine(const std::wstring& line)
     {
-        std::wostringstream ss;
-        ss << p.x << L"," << p.y;
-        return ss.str();
+        std::string s;
+        s.reserve(line.size());
+        for (wchar_t c : line)
+        {
+            if (c == 0xFEFF) continue;
+            s += (c < 0x80) ? static_cast<char>(c) : '?';
+        }
+        return s;
     }
 
-    // 辅助：从 "x,y" 解析 Pos
-    static bool StringToPos(const std::wstring& s, Pos& out)
+    // 辅助：读取整个棋谱（宽字符流），格式错误返回 false
+    static bool ReadRecord(std::wistream& is, GameRecord& out)
     {
-        size_t comma = s.find(L',');
-        if (comma == std::wstring::npos) return false;
-        std::wstring sx = s.substr(0, comma);
-        std::wstring sy = s.substr(comma + 1);
-        try {
-            int x = std::stoi(sx);
-            int y = std::stoi(sy);
-            out = Pos(x, y);
-            return out.IsValid();
-        } catch (...) {
-            return false;
+        out.moves.clear();
+        out.finished = false;
+        out.start = Position::Initial();
+        std::wstring line;
+        bool first = true;
+        while (std::getline(is, line))
+        {
+            std::string narrow = NarrowRecordLine(line);
+            TrimRecordLine(narrow);
+            if (narrow.empty()) continue;
+            if (first && IsSetupLine(narrow))
+            {
+                first = false;
+                if (!ParseSetupLine(narrow, out.start)) return false;
+                continue;
+            }
+            first = false;
+            RecordedMove rm;
+            bool gameEnd, isEmpty;
+            if (!ParseRecordLine(narrow, rm, gameEnd, isEmpty))
+            {
+                if (isEmpty) continue;
+                return false;
+            }
+            out.moves.push_back(rm);
+            if (gameEnd) { out.finished = true; break; }
         }
+        return true;
     }
 
     // Game 方法
@@ -237,6 +266,7 @@ namespace AmazonChess
         for (int y = 0; y < BOARD_SIZE; ++y)
             for (int x = 0; x < BOARD_SIZE; ++x)
                 board[y][x] = Cell();
+        UpdateCachedState();
     }
 
     Game::~Game()
@@ -246,30 +276,28 @@ namespace AmazonChess
 
     void Game::Reset()
     {
-        // 清空
-        for (int y = 0; y < BOARD_SIZE; ++y)
-            for (int x = 0; x < BOARD_SIZE; ++x)
-                board[y][x].type = PieceType::None;
-
-        // 白 Amazon 初始位置: (0,2),(2,0),(5,0),(7,2)
-        AddPiece(PieceType::WhiteAmazon, Pos(0,2));
-        AddPiece(PieceType::WhiteAmazon, Pos(2,0));
-        AddPiece(PieceType::WhiteAmazon, Pos(5,0));
-        AddPiece(PieceType::WhiteAmazon, Pos(7,2));
+        // 白 Amazon 初始位置: (0,2),(2,0),(5,0),(7,2)；黑 Amazon 初始位置: (0,5),(2,7),(5,7),(7,5)
+        Reset(Position::Initial());
+    }
 
-        // 黑 Amazon 初始位置: (0,5),(2,7),(5,7),(7,5)
-        AddPiece(PieceType::BlackAmazon, Pos(0,5));
-        AddPiece(PieceType::BlackAmazon, Pos(2,7));
-        AddPiece(PieceType::BlackAmazon, Pos(5,7));
-        AddPiece(PieceType::BlackAmazon, Pos(7,5));
+    void Game::Reset(const Position& start)
+    {
+        PlacePieces(start);
 
-        currentPlayer = Player::White;
+        currentPlayer = start.sideToMove;
         phase = TurnPhase::SelectAmazon;
         selected = Pos(-1,-1);
         lastMoveFrom = Pos(-1,-1);
         lastMoveTo = Pos(-1,-1);
         ClearHighlights();
-        moves.clear();
+        history.moves.clear();
+        history.moves.reserve(BOARD_SIZE * BOARD_SIZE);
+        history.finished = false;
+        history.start = start;
+        if (!journalPaused) journal.Create(AUTOSAVE_JOURNAL, start);
+        g_aiRemainingMs = AI_GAME_TIME_MS;
+        ResetAI();
+        if (g_hMainWnd) SetWindowTextW(g_hMainWnd, szTitle);
     }
 
     void Game::LoadResources(HINSTANCE /*hInst*/)
@@ -582,17 +610,70 @@ namespace AmazonChess
     {
         if (!IsWithinBoard(p)) return false;
         if (!IsCellEmpty(p)) return false;
-        board[p.y][p.x].type = type;
+        SetCell(p, type);
+        UpdateCachedState();
         return true;
     }
 
     bool Game::RemovePiece(const Pos& p)
     {
         if (!IsWithinBoard(p)) return false;
-        board[p.y][p.x].type = PieceType::None;
+        SetCell(p, PieceType::None);
+        UpdateCachedState();
         return true;
     }
 
+    void Game::SetCell(const Pos& p, PieceType type)
+    {
+        int sq = SquareOf(p);
+        pieces.Remove(sq);
+        pieces.Put(type, sq);
+        board[p.y][p.x].type = type;
+    }
+
+    void Game::PlacePieces(const Position& pos)
+    {
+        pieces = Position();
+        for (int sq = 0; sq < SQUARE_COUNT; ++sq)
+        {
+            PieceType type = pos.PieceAt(sq);
+            board[sq / BOARD_SIZE][sq % BOARD_SIZE].type = type;
+            pieces.Put(type, sq);
+        }
+        UpdateCachedState();
+    }
+
+    size_t Game::LoadRecordPosition(const GameRecord& record)
+    {
+        Reset(record.start);
+        Position pos = record.start;
+        size_t applied = 0;
+        for (const RecordedMove& rm : record.moves)
+        {
+            if (!ApplyRecordedMove(pos, rm)) break;
+            RecordMove(rm.player, PosOf(rm.move.from), PosOf(rm.move.to), PosOf(rm.move.arrow), WinnerOf(pos) != Player::None);
+            lastMoveFrom = PosOf(rm.move.from);
+            lastMoveTo = PosOf(rm.move.to);
+            ++applied;
+        }
+        if (applied > 0)
+        {
+            PlacePieces(pos);
+            currentPlayer = pos.sideToMove;
+        }
+        return applied;
+    }
+
+    // 开放度由位棋盘直接计算（每个 Amazon 一次射线查表），不再经 GetReachableFrom 逐格分配
+    void Game::UpdateCachedState()
+    {
+        mobility[0] = Mobility(pieces, Player::White);
+        mobility[1] = Mobility(pieces, Player::Black);
+        if (mobility[0] == 0) winner = Player::Black;
+        else if (mobility[1] == 0) winner = Player::White;
+        else winner = Player::None;
+    }
+
     std::vector<Pos> Game::GetReachableFrom(const Pos& from) const
     {
         std::vector<Pos> result;
@@ -623,13 +704,12 @@ namespace AmazonChess
 
     void Game::RecordMove(Player player, const Pos& from, const Pos& to, const Pos& arrow, bool gameEnd)
     {
-        std::wostringstream ss;
-        ss << (player == Player::White ? L"W" : L"B") << L" "
-           << PosToString(from) << L" "
-           << PosToString(to) << L" "
-           << PosToString(arrow);
-        if (gameEnd) ss << L"*";
-        moves.push_back(ss.str());
+        RecordedMove rm;
+        rm.player = player;
+        rm.move = MoveOf(SquareOf(from), SquareOf(to), SquareOf(arrow));
+        history.moves.push_back(rm);
+        history.finished = gameEnd;
+        if (!journalPaused && !g_stepReplay) journal.Append(rm, gameEnd);
     }
 
     bool Game::MoveAmazon(const Pos& from, const Pos& to)
@@ -643,8 +723,9 @@ namespace AmazonChess
         auto it = std::find_if(reachable.begin(), reachable.end(), [&to](const Pos& p){ return p == to; });
         if (it == reachable.end()) return false;
 
-        board[to.y][to.x].type = src;
-        board[from.y][from.x].type = PieceType::None;
+        SetCell(to, src);
+        SetCell(from, PieceType::None);
+        UpdateCachedState();
 
         lastMoveFrom = from;
         lastMoveTo = to;
@@ -660,7 +741,8 @@ namespace AmazonChess
         if (!IsWithinBoard(target)) return false;
         if (!IsCellEmpty(target)) return false;
         // target 必须在 highlighted 中（调用处保证）
-        board[target.y][target.x].type = PieceType::Arrow;
+        SetCell(target, PieceType::Arrow);
+        UpdateCachedState();
 
         // 在切换玩家前记录本手：使用 currentPlayer（当前执行此发箭动作的玩家）
         bool gameEnd = (GetWinner() != Player::None); // 部署箭后可能导致对方被封死
@@ -673,94 +755,94 @@ namespace AmazonChess
         highlighted.clear();
 
         // 如果现在是黑方回合且不是在重放，从 AI 取得落子并执行
-        if (!g_isReplaying && currentPlayer == Player::Black)
+        if (!g_isReplaying && currentPlayer == Player::Black) PlayAITurn();
+
+        return true;
+    }
+
+    // AI（黑方）走完整一手：搜索、展示停顿、落子并发箭（发箭经 ShootArrow 记录并切换回人类）
+    void Game::PlayAITurn()
+    {
+        // 构造 PieceType 数组供 AI 使用
+        std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE> pboard;
+        for (int yy = 0; yy < BOARD_SIZE; ++yy)
+            for (int xx = 0; xx < BOARD_SIZE; ++xx)
+                pboard[yy][xx] = board[yy][xx].type;
+
+        TimeControl clock;
+        clock.remainingMs = g_aiRemainingMs;
+        clock.incrementMs = AI_INCREMENT_MS;
+        auto thinkStart = std::chrono::steady_clock::now();
+        SearchResult info;
+        auto best = GetBestMove(pboard, currentPlayer, clock, &info);
+        int64_t thinkMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - thinkStart).count();
+        g_aiRemainingMs = std::max<int64_t>(0, g_aiRemainingMs - thinkMs) + AI_INCREMENT_MS;
+        if (best.first != -1)
         {
-            // 构造 PieceType 数组供 AI 使用
-            std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE> pboard;
-            for (int yy = 0; yy < BOARD_SIZE; ++yy)
-                for (int xx = 0; xx < BOARD_SIZE; ++xx)
-                    pboard[yy][xx] = board[yy][xx].type;
-
-            auto best = GetBestMove(pboard, currentPlayer);
-            if (best.first != -1)
+            const int squareCount = BOARD_SIZE * BOARD_SIZE;
+            int movePacked = best.first;
+            int fromIndex = movePacked / squareCount;
+            int toIndex = movePacked % squareCount;
+            Pos fromPos(fromIndex % BOARD_SIZE, fromIndex / BOARD_SIZE);
+            Pos toPos(toIndex % BOARD_SIZE, toIndex / BOARD_SIZE);
+
+            // 在执行 AI 动作前停顿（让玩家看清回合切换）；思考已用去的时间不再重复等待
+            if (g_hMainWnd)
             {
-                const int squareCount = BOARD_SIZE * BOARD_SIZE;
-                int movePacked = best.first;
-                int fromIndex = movePacked / squareCount;
-                int toIndex = movePacked % squareCount;
-                Pos fromPos(fromIndex % BOARD_SIZE, fromIndex / BOARD_SIZE);
-                Pos toPos(toIndex % BOARD_SIZE, toIndex / BOARD_SIZE);
-
-                // 在执行 AI 动作前延迟 1 秒（让玩家看清回合切换）
+                // 标题栏显示本手搜索深度与从上一手搜索复用的比例
+                WCHAR title[MAX_LOADSTRING + 64];
+                swprintf_s(title, L"%s - AI 深度 %d，复用 %.0f%%", szTitle, info.depth, info.carriedOver * 100.0);
+                SetWindowTextW(g_hMainWnd, title);
+                InvalidateRect(g_hMainWnd, NULL, FALSE);
+                UpdateWindow(g_hMainWnd);
+            }
+            if (thinkMs < AI_DISPLAY_DELAY_MS)
+                std::this_thread::sleep_for(std::chrono::milliseconds(AI_DISPLAY_DELAY_MS - thinkMs));
+
+            // 执行 AI 的移动 - MoveAmazon 会设 lastMoveFrom/To
+            if (MoveAmazon(fromPos, toPos))
+            {
+                // 显示 AI 移动后的界面并停顿再发箭
                 if (g_hMainWnd)
                 {
                     InvalidateRect(g_hMainWnd, NULL, FALSE);
                     UpdateWindow(g_hMainWnd);
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                std::this_thread::sleep_for(std::chrono::milliseconds(AI_DISPLAY_DELAY_MS));
 
-                // 执行 AI 的移动 - MoveAmazon 会设 lastMoveFrom/To
-                if (MoveAmazon(fromPos, toPos))
+                // 若 AI 返回了箭位置则放箭；否则尝试选择第一个可达格作为箭（防防万一）
+                if (best.second >= 0)
                 {
-                    // 显示 AI 移动后的界面并暂停 1 秒再发箭
-                    if (g_hMainWnd)
-                    {
-                        InvalidateRect(g_hMainWnd, NULL, FALSE);
-                        UpdateWindow(g_hMainWnd);
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-                    // 若 AI 返回了箭位置则放箭；否则尝试选择第一个可达格作为箭（防防万一）
-                    if (best.second >= 0)
+                    int arrowIdx = best.second;
+                    Pos arrowPos(arrowIdx % BOARD_SIZE, arrowIdx / BOARD_SIZE);
+                    // 直接调用 ShootArrow —— 这将记录该手并切换回人类
+                    ShootArrow(arrowPos);
+                }
+                else
+                {
+                    // 如果没有箭位置（极少见），选择第一个 highlighted 作为箭
+                    if (!highlighted.empty())
                     {
-                        int arrowIdx = best.second;
-                        Pos arrowPos(arrowIdx % BOARD_SIZE, arrowIdx / BOARD_SIZE);
-                        // 直接调用 ShootArrow —— 这将记录该手并切换回人类
-                        ShootArrow(arrowPos);
+                        ShootArrow(highlighted.front());
                     }
                     else
                     {
-                        // 如果没有箭位置（极少见），选择第一个 highlighted 作为箭
-                        if (!highlighted.empty())
-                        {
-                            ShootArrow(highlighted.front());
-                        }
-                        else
-                        {
-                            // 没有合法箭位，直接切换回玩家（虽然规则上应不会发生）
-                            ToggleNextPlayer();
-                        }
+                        // 没有合法箭位，直接切换回玩家（虽然规则上应不会发生）
+                        ToggleNextPlayer();
                     }
                 }
             }
         }
-
-        return true;
     }
 
     bool Game::IsPlayerTrapped(Player player) const
     {
-        PieceType amazonType = (player == Player::White) ? PieceType::WhiteAmazon : PieceType::BlackAmazon;
-        for (int y = 0; y < BOARD_SIZE; ++y)
-        {
-            for (int x = 0; x < BOARD_SIZE; ++x)
-            {
-                if (board[y][x].type == amazonType)
-                {
-                    Pos p(x,y);
-                    auto reach = const_cast<Game*>(this)->GetReachableFrom(p);
-                    if (!reach.empty()) return false;
-                }
-            }
-        }
-        return true;
+        return mobility[static_cast<int>(player)] == 0;
     }
 
     Player Game::GetWinner() const
     {
-        if (IsPlayerTrapped(Player::White)) return Player::Black;
-        if (IsPlayerTrapped(Player::Black)) return Player::White;
-        return Player::None;
+        return winner;
     }
 
     bool Game::IsCellEmpty(const Pos& p) const
@@ -791,90 +873,97 @@ namespace AmazonChess
         std::wofstream ofs(path, std::ios::binary);
         if (!ofs.is_open()) return false;
         ofs.imbue(std::locale(ofs.getloc(), new std::codecvt_utf8<wchar_t>));
-        for (const auto& line : moves)
+        if (HasCustomStart(history))
+        {
+            std::string setup = FormatSetupLine(history.start);
+            ofs << std::wstring(setup.begin(), setup.end()) << L"\n";
+        }
+        for (size_t i = 0; i < history.moves.size(); ++i)
         {
-            ofs << line << L"\n";
+            bool last = history.finished && i + 1 == history.moves.size();
+            std::string line = FormatRecordLine(history.moves[i], last);
+            ofs << std::wstring(line.begin(), line.end()) << L"\n";
         }
         ofs.close();
         return true;
     }
 
-    // 从文件读取并重放（从初始局面开始）
-    // 修改：如果是 "Initialization.acp"（启动时读取初始局面），保留原来立即应用的行为。
-    // 否则：加载所有记谱行到 moves，并进入按空格逐步重放模式（g_stepReplay=true）。
+    // 从文件读取记谱到 replayScript，摆出其起始局面，并进入按空格逐步重放模式（g_stepReplay=true）。
     bool Game::LoadFromFile(const std::wstring& path)
     {
         std::wifstream ifs(path, std::ios::binary);
         if (!ifs.is_open()) return false;
         ifs.imbue(std::locale(ifs.getloc(), new std::codecvt_utf8<wchar_t>));
 
-        // 特殊处理 Initialization.acp：立即执行（保持原行为）
-        if (path == L"Initialization.acp")
+        if (!ReadRecord(ifs, replayScript))
         {
-            // 标记为重放，防止在重放期触发 AI
-            g_isReplaying = true;
-
-            // 从初始局面开始重放
+            replayScript.moves.clear();
             Reset();
-            moves.clear();
-
-            std::wstring line;
-            bool success = true;
-            while (std::getline(ifs, line))
-            {
-                // trim CRLF and spaces
-                while (!line.empty() && (line.back() == L'\r' || line.back() == L'\n' || line.back() == L' ' || line.back() == L'\t')) line.pop_back();
-                if (line.empty()) continue;
-
-                bool hadStar = false;
-                if (!line.empty() && line.back() == L'*') { hadStar = true; line.pop_back(); }
-
-                std::wistringstream iss(line);
-                std::wstring playerToken, fromStr, toStr, arrowStr;
-                if (!(iss >> playerToken >> fromStr >> toStr >> arrowStr)) { success = false; break; }
-
-                Player p = (playerToken == L"W") ? Player::White : Player::Black;
+            return false;
+        }
+        Reset(replayScript.start);
 
-                Pos from, to, arrow;
-                if (!StringToPos(fromStr, from) || !StringToPos(toStr, to) || !StringToPos(arrowStr, arrow)) { success = false; break; }
+        // 进入逐步重放模式：设置全局标志，等待用户通过空格推进
+        g_isReplaying = true;   // 防止在重放过程中触发 AI
+        g_stepReplay = true;
+        g_replayIndex = 0;
 
-                // 为了让 MoveAmazon 校验正常，设置 currentPlayer 成为该行的玩家
-                currentPlayer = p;
+        return true;
+    }
 
-                if (!MoveAmazon(from, to)) { success = false; break; }
-                if (!ShootArrow(arrow)) { success = false; break; }
+    bool Game::LoadInitialPosition(const std::wstring& path)
+    {
+        std::wifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open()) return false;
+        ifs.imbue(std::locale(ifs.getloc(), new std::codecvt_utf8<wchar_t>));
 
-                if (hadStar) break;
-            }
+        // 与原实现相同：遇到错误行即停止，已读到的手保留；FEN 行本身错误则不载入
+        GameRecord record;
+        if (!ReadRecord(ifs, record) && record.moves.empty()) return false;
+        LoadRecordPosition(record);
+        return true;
+    }
 
-            g_isReplaying = false;
-            return true;
-        }
+    bool Game::RecoverAutosave()
+    {
+        GameRecord record;
+        if (!ReadJournal(AUTOSAVE_JOURNAL, record) || record.moves.empty() || record.finished) return false;
 
-        // 非 Initialization.acp：读取到 moves 中，进入按空格逐步显示模式
-        Reset();
-        moves.clear();
+        // 直接摆出日志中的局面，期间不写日志；非法的一手（不应出现）及其后内容丢弃
+        journalPaused = true;
+        LoadRecordPosition(record);
+        journalPaused = false;
 
-        std::wstring line;
-        while (std::getline(ifs, line))
+        // 在原日志上继续追加：只保留成功重放的手数，残缺尾部截掉
+        if (history.moves.empty() || !journal.Resume(AUTOSAVE_JOURNAL, history.moves.size()))
         {
-            // trim CRLF and spaces (保留 '*' 在末尾以便识别终局)
-            while (!line.empty() && (line.back() == L'\r' || line.back() == L'\n')) line.pop_back();
-            if (line.empty()) continue;
-            // 保留行（包含可能的 '*'）
-            moves.push_back(line);
+            Reset();
+            return false;
         }
 
-        // 进入逐步重放模式：设置全局标志，等待用户通过空格推进
-        g_isReplaying = true;   // 防止在重放过程中触发 AI
-        g_stepReplay = true;
-        g_replayIndex = 0;
-
+        // 崩溃发生在人类走完、AI 尚未走完时：由 AI 接着走
+        if (currentPlayer == Player::Black && GetWinner() == Player::None) PlayAITurn();
         return true;
     }
 
-    const std::vector<std::wstring>& Game::GetMoveList() const { return moves; }
-    void Game::ClearMoveList() { moves.clear(); }
+    void Game::RestartAutosave()
+    {
+        if (journalPaused || !journal.Create(AUTOSAVE_JOURNAL, history.start)) return;
+        for (size_t i = 0; i < history.moves.size(); ++i)
+            journal.Append(history.moves[i], history.finished && i + 1 == history.moves.size());
+    }
+
+    void Game::DiscardAutosave()
+    {
+        journal.Close();
+        std::remove(AUTOSAVE_JOURNAL);
+    }
+
+    void Game::ClearMoveList()
+    {
+        history.moves.clear();
+        history.finished = false;
+    }
 } // namespace AmazonChess
 
 //
@@ -939,9 +1028,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 break;
             case IDM_NEW:
                 {
-                    GetGlobalGame().Reset();
                     // 尝试加载 Initialization.acp（若不存在则保持 Reset）
-                    GetGlobalGame().LoadFromFile(std::wstring(L"Initialization.acp"));
+                    if (!GetGlobalGame().LoadInitialPosition(L"Initialization.acp")) GetGlobalGame().Reset();
                     InvalidateRect(hWnd, NULL, FALSE);
                 }
                 break;
@@ -956,54 +1044,41 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             // 逐步重放：按空格执行下一手
             if (wParam == VK_SPACE && g_isReplaying && g_stepReplay)
             {
-                auto &moves = GetGlobalGame().GetMoveList();
-                if (g_replayIndex < moves.size())
+                const GameRecord& script = GetGlobalGame().GetReplayScript();
+                if (g_replayIndex < script.moves.size())
                 {
-                    // 解析当前行
-                    std::wstring line = moves[g_replayIndex];
-                    // trim trailing spaces and CR/LF
-                    while (!line.empty() && (line.back() == L'\r' || line.back() == L'\n' || line.back() == L' ' || line.back() == L'\t')) line.pop_back();
-                    bool hadStar = false;
-                    if (!line.empty() && line.back() == L'*') { hadStar = true; line.pop_back(); }
-
-                    std::wistringstream iss(line);
-                    std::wstring playerToken, fromStr, toStr, arrowStr;
-                    if (iss >> playerToken >> fromStr >> toStr >> arrowStr)
+                    const RecordedMove& rm = script.moves[g_replayIndex];
+                    bool hadStar = script.finished && g_replayIndex + 1 == script.moves.size();
+
+                    // 设置当前玩家以通过 MoveAmazon 的校验
+                    GetGlobalGame().SetCurrentPlayer(rm.player); // 使用新增加的公有 setter
+                    // 执行落子（显示后暂停 1s），然后发箭（显示后暂停 1s）
+                    if (GetGlobalGame().MoveAmazon(PosOf(rm.move.from), PosOf(rm.move.to)))
                     {
-                        Player p = (playerToken == L"W") ? Player::White : Player::Black;
-                        Pos from, to, arrow;
-                        if (StringToPos(fromStr, from) && StringToPos(toStr, to) && StringToPos(arrowStr, arrow))
+                        if (g_hMainWnd)
+                        {
+                            InvalidateRect(g_hMainWnd, NULL, FALSE);
+                            UpdateWindow(g_hMainWnd);
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                        GetGlobalGame().ShootArrow(PosOf(rm.move.arrow)); // ShootArrow 内会记录并切换玩家
+                        if (g_hMainWnd)
                         {
-                            // 设置当前玩家以通过 MoveAmazon 的校验
-                            GetGlobalGame().SetCurrentPlayer(p); // 使用新增加的公有 setter
-                            // 执行落子（显示后暂停 1s），然后发箭（显示后暂停 1s）
-                            if (GetGlobalGame().MoveAmazon(from, to))
-                            {
-                                if (g_hMainWnd)
-                                {
-                                    InvalidateRect(g_hMainWnd, NULL, FALSE);
-                                    UpdateWindow(g_hMainWnd);
-                                }
-                                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-                                GetGlobalGame().ShootArrow(arrow); // ShootArrow 内会记录并切换玩家
-                                if (g_hMainWnd)
-                                {
-                                    InvalidateRect(g_hMainWnd, NULL, FALSE);
-                                    UpdateWindow(g_hMainWnd);
-                                }
-                                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-                            }
+                            InvalidateRect(g_hMainWnd, NULL, FALSE);
+                            UpdateWindow(g_hMainWnd);
                         }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
                     }
 
                     ++g_replayIndex;
 
                     // 如果这是终局（hadStar）或已无更多步骤，则退出逐步重放模式
-                    if (hadStar || g_replayIndex >= moves.size())
+                    if (hadStar || g_replayIndex >= script.moves.size())
                     {
                         g_isReplaying = false;
                         g_stepReplay = false;
                         g_replayIndex = 0;
+                        GetGlobalGame().RestartAutosave();
                     }
                 }
                 else
@@ -1012,6 +1087,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     g_isReplaying = false;
                     g_stepReplay = false;
                     g_replayIndex = 0;
+                    GetGlobalGame().RestartAutosave();
                 }
 
                 InvalidateRect(hWnd, NULL, FALSE);
@@ -7,6 +7,10 @@
 #include <functional>
 #include <string>
 #include "resource.h"
+#include "AmazonCore.h"
+#include "AmazonBitboard.h"
+#include "AmazonRecord.h"
+#include "AmazonJournal.h"
 
 // ѷӿڣC++14
 // ʵռλΪԺ .cpp ʵϷ߼Ⱦ괦ӿڡ
@@ -19,37 +23,6 @@
 
 namespace AmazonChess
 {
-    // ̳ߴ
-    static constexpr int BOARD_SIZE = 8;
-
-    // ͣArrow 
-    enum class PieceType : uint8_t
-    {
-        None = 0,
-        WhiteAmazon,
-        BlackAmazon,
-        Arrow
-    };
-
-    // Ҳ
-    enum class Player : int8_t
-    {
-        None = -1,
-        White = 0,
-        Black = 1
-    };
-
-    // ꣺ (x,y) ʾ0<=x,y<8ע⣺½Ϊ (0,0)
-    struct Pos
-    {
-        int x;
-        int y;
-        Pos() : x(-1), y(-1) {}
-        Pos(int _x, int _y) : x(_x), y(_y) {}
-        bool operator==(const Pos& o) const { return x == o.x && y == o.y; }
-        bool IsValid() const { return x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE; }
-    };
-
     // Ϣ洢ͣҪʱչ
     struct Cell
     {
@@ -87,6 +60,8 @@ namespace AmazonChess
 
         // ʼ/õʼ֣ʹĬλã
         void Reset();
+        // õ棨Ǻż AmazonNotation.hֱӰڷӣO() ɣ״Ӹþ濪ʼ
+        void Reset(const Position& start);
 
         //  UI Դռλӿڣⲿ WinMain/Init е
         // hInst: ӦʵGetModuleHandle  hInst
@@ -141,6 +116,11 @@ namespace AmazonChess
         // ϷʤߣNone ʾδ
         Player GetWinner() const;
 
+        // ľ״̬ AddPiece / RemovePiece / MoveAmazon / ShootArrow / Reset ͬ£
+        // ѯΪ O(1) Ҳڴ棨ҲֱӶȡ棩
+        const Position& PieceState() const { return pieces; } // Amazon λ̼˫бsideToMove ʹ
+        int MobilityOf(Player player) const { return mobility[static_cast<int>(player)]; }
+
         // Ϸֱӷʣֻ
         const std::array<std::array<Cell, BOARD_SIZE>, BOARD_SIZE>& BoardGrid() const { return board; }
 
@@ -151,13 +131,27 @@ namespace AmazonChess
         // -----  -----
         // ǰױ浽ָļutf-8Ƿɹ
         bool SaveToFile(const std::wstring& path) const;
-        // ָļȡײطţӳʼ濪ʼǷɹ
+        // ָļȡײ밴ոطģʽӼ׵ʼ濪ʼǷɹ
         bool LoadFromFile(const std::wstring& path);
+        // ʼļInitialization.acpFEN ֱλִкһΰڳ
+        //  MoveAmazon / ShootArrowҲ AIļڻʽʱ false Ҳı䵱ǰԾ
+        bool LoadInitialPosition(const std::wstring& path);
 
-        //  / 
-        const std::vector<std::wstring>& GetMoveList() const;
+        //  / ףռ¼ıֻڱʱɣ
+        const GameRecord& GetHistory() const { return history; }
         void ClearMoveList();
 
+        // Զ浵ÿһ׷ӵ Autosave.acj AmazonJournal.hReset ʱ½طڼִеĸֲд־
+        // ʱã־δĶԾصȱβطŲþ֣ true򷵻 false÷ճ֣
+        bool RecoverAutosave();
+        // طŽʱã history д־˺ճ׷
+        void RestartAutosave();
+        // ˳ʱãرղɾ־´ٻָ
+        void DiscardAutosave();
+
+        // طţLoadFromFile 롢δִеļף history ֿطʱִеÿһճ history
+        const GameRecord& GetReplayScript() const { return replayScript; }
+
     private:
         // ڲ
         bool IsCellEmpty(const Pos& p) const;
@@ -165,12 +159,28 @@ namespace AmazonChess
         void ClearHighlights();
         void ToggleNextPlayer();
 
+        // ޸ĵͬλ̣һ޸ɺ UpdateCachedState ˢ¿Ŷʤ
+        void SetCell(const Pos& p, PieceType type);
+        void UpdateCachedState();
+        // λ̰ڳ̣ӷ뽻״̬䣩
+        void PlacePieces(const Position& pos);
+        //  record.start ʼλִи֣Ƿһֹͣһΰڳּ historyִе
+        size_t LoadRecordPosition(const GameRecord& record);
+
         // ¼һ֣ڷʱ ShootArrow ã
         void RecordMove(Player player, const Pos& from, const Pos& to, const Pos& arrow, bool gameEnd);
 
+        // ֵ AIڷʱһ
+        void PlayAITurn();
+
         std::array<std::array<Cell, BOARD_SIZE>, BOARD_SIZE> board;
         UIResources resources;
 
+        //  board ͬĻ
+        Position pieces;
+        std::array<int, 2> mobility;
+        Player winner;
+
         // غϿ
         Player currentPlayer;
         TurnPhase phase;
@@ -182,8 +192,14 @@ namespace AmazonChess
         // ת
         RECT boardRect; // pixel rect of the whole board (left, top, right, bottom)
 
-        // ݣÿУ "W 0,2 2,0 3,3"ĩ '*'
-        std::vector<std::wstring> moves;
+        // ݣÿһ RecordedMove + ţfinished ʾһվ֣
+        // Reset ʱԤԾм¼һֲڴ
+        GameRecord history;
+        GameRecord replayScript;
+
+        // Զ浵־journalPaused ʱָطڼ䣩Reset / RecordMove д־طڼ RecordMove д־
+        JournalWriter journal;
+        bool journalPaused = false;
 
         // Ϊ˼¼һ֣MoveAmazon  from/toShootArrow ʹ + arrow
         Pos lastMoveFrom;
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// 亚马逊棋核心类型（与平台无关，不依赖 windows.h）
+// 界面（AmazonChess!.h）、AI 与无界面工具（AmazonTools/）共用这些定义。
+
+namespace AmazonChess
+{
+    // 棋盘尺寸
+    static constexpr int BOARD_SIZE = 8;
+
+    // 棋子类型（Arrow 无所属方）
+    enum class PieceType : uint8_t
+    {
+        None = 0,
+        WhiteAmazon,
+        BlackAmazon,
+        Arrow
+    };
+
+    // 玩家侧
+    enum class Player : int8_t
+    {
+        None = -1,
+        White = 0,
+        Black = 1
+    };
+
+    // 坐标：以 (x,y) 表示，0<=x,y<8。注意：左下角为 (0,0)
+    struct Pos
+    {
+        int x;
+        int y;
+        Pos() : x(-1), y(-1) {}
+        Pos(int _x, int _y) : x(_x), y(_y) {}
+        bool operator==(const Pos& o) const { return x == o.x && y == o.y; }
+        bool IsValid() const { return x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE; }
+    };
+
+    // 对手
+    inline Player Opponent(Player p)
+    {
+        return (p == Player::White) ? Player::Black : Player::White;
+    }
+
+    // 玩家对应的 Amazon 棋子类型
+    inline PieceType AmazonOf(Player p)
+    {
+        return (p == Player::White) ? PieceType::WhiteAmazon : PieceType::BlackAmazon;
+    }
+} // namespace AmazonChess
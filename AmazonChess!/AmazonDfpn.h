@@ -0,0 +1,299 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "AmazonBitboard.h"
+#include "AmazonTableMemory.h"
+
+// 证明数搜索求解器（df-pn，深度优先证明数搜索），用于箭数较多的中后盘局面的胜负证明。
+// 以走子方视角记每个节点的 (phi, delta)：phi 为证明“走子方必胜”还需展开的叶节点数的估计，delta 为证明“走子方必败”的估计。
+//   phi(n) = min(delta(c))，delta(n) = sum(phi(c))；走子方无棋可走即负：phi = INF、delta = 0。
+// 节点在阈值 (thPhi, thDelta) 内反复选 delta 最小的子节点深入，直到 phi 或 delta 越过阈值再把结果写入表中返回。
+// 子节点阈值采用 1+ε 技巧（次优值放宽 PROOF_EPSILON 倍），减少在两个相近子树之间来回切换的重复展开。
+// Amazons 每手都多一支箭，局面不会重复，搜索图无环，无需处理 GHI 问题（转置仍按局面键合并）。
+// 求解器使用独立的表（不与 αβ 搜索的置换表混用），表大小即内存预算；另可设节点数与时间上限，超出时返回 Unknown。
+
+namespace AmazonChess
+{
+    // 走子方视角的求解结果
+    enum class SolveResult
+    {
+        Unknown,
+        Win,
+        Loss
+    };
+
+    inline const char* SolveResultName(SolveResult r)
+    {
+        switch (r)
+        {
+        case SolveResult::Win: return "win";
+        case SolveResult::Loss: return "loss";
+        default: return "unknown";
+        }
+    }
+
+    struct SolverLimits
+    {
+        uint64_t maxNodes = 0;  // 展开的内部节点数上限，0 = 不限
+        int64_t maxTimeMs = 0;  // 0 = 不限
+        const std::atomic<bool>* cancel = nullptr; // 可选：由调用方置位以中止本次求解
+    };
+
+    struct SolverOutcome
+    {
+        SolveResult result = SolveResult::Unknown;
+        bool hasMove = false;    // 仅在 Win 时给出必胜的一手
+        Move bestMove = MoveOf(0, 0, 0);
+        uint32_t phi = 1;        // 根的证明数 / 反证数（未解出时反映剩余难度）
+        uint32_t delta = 1;
+        uint64_t nodes = 0;
+        double timeMs = 0.0;
+    };
+
+    // 证明数表：每项 16 字节，4 项一桶（一个缓存行）。桶由键的低位选出，项内保存键的高 32 位用于校验；
+    // 桶满时替换展开量（work，该节点子树内展开的节点数）最小的一项，保留花费最多的中间结果
+    class ProofTable
+    {
+    public:
+        static constexpr uint32_t INF = 0x3FFFFFFFu;
+
+        explicit ProofTable(size_t mb, const TableMemoryOptions& memoryOptions = TableMemoryOptions())
+        {
+            size_t bytes = std::max<size_t>(mb, 1) * 1024 * 1024;
+            size_t count = 1;
+            while (count * 2 * sizeof(Bucket) <= bytes) count *= 2;
+            void* raw = memory.Allocate(count * sizeof(Bucket), memoryOptions);
+            if (!raw) throw std::bad_alloc();
+            buckets = new (raw) Bucket[count]; // 内存已清零，Bucket 为平凡类型
+            mask = count - 1;
+        }
+
+        void Clear()
+        {
+            std::fill(buckets, buckets + mask + 1, Bucket());
+        }
+
+        size_t Capacity() const { return (mask + 1) * BUCKET_ENTRIES; }
+
+        bool Probe(uint64_t key, uint32_t& phi, uint32_t& delta) const
+        {
+            const Bucket& b = buckets[key & mask];
+            uint32_t check = Check(key);
+            for (const Entry& e : b.entries)
+            {
+                if (e.work != 0 && e.check == check)
+                {
+                    phi = e.phi;
+                    delta = e.delta;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void Store(uint64_t key, uint32_t phi, uint32_t delta, uint64_t work)
+        {
+            Bucket& b = buckets[key & mask];
+            uint32_t check = Check(key);
+            uint32_t w = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(work, 1), 0xFFFFFFFFu));
+            Entry* victim = &b.entries[0];
+            for (Entry& e : b.entries)
+            {
+                if (e.work != 0 && e.check == check)
+                {
+                    victim = &e;
+                    break;
+                }
+                if (e.work < victim->work) victim = &e;
+            }
+            victim->check = check;
+            victim->work = w;
+            victim->phi = phi;
+            victim->delta = delta;
+        }
+
+    private:
+        static constexpr int BUCKET_ENTRIES = 4;
+
+        struct Entry
+        {
+            uint32_t check;
+            uint32_t work;   // 0 表示空项
+            uint32_t phi;
+            uint32_t delta;
+        };
+
+        struct alignas(64) Bucket
+        {
+            Entry entries[BUCKET_ENTRIES] = {};
+        };
+
+        static uint32_t Check(uint64_t key) { return static_cast<uint32_t>(key >> 32); }
+
+        TableMemory memory;
+        Bucket* buckets = nullptr;
+        size_t mask = 0;
+    };
+
+    class ProofNumberSolver
+    {
+    public:
+        static constexpr uint32_t INF = ProofTable::INF;
+        static constexpr double PROOF_EPSILON = 0.25;
+
+        explicit ProofNumberSolver(size_t mb, const TableMemoryOptions& memoryOptions = TableMemoryOptions())
+            : table(mb, memoryOptions), moveLists(MAX_DEPTH + 1)
+        {
+        }
+
+        // 清空表（换到无关的局面时调用；同一局面链上保留表可复用已证明的子树）
+        void Clear() { table.Clear(); }
+
+        // 可从其它线程调用，使当前 Solve 尽快返回 Unknown。Solve 开始时会清除该请求，只对已在进行的求解有效；
+        // 可能在求解开始前就要取消时应改用 SolverLimits::cancel
+        void Stop() { stopRequested.store(true, std::memory_order_relaxed); }
+
+        const ProofTable& Table() const { return table; }
+
+        SolverOutcome Solve(const Position& root, const SolverLimits& limits = SolverLimits())
+        {
+            start = Clock::now();
+            stopRequested.store(false, std::memory_order_relaxed);
+            this->limits = limits;
+            nodes = 0;
+            aborted = false;
+
+            SolverOutcome out;
+            Position pos = root;
+            proofMove = MoveOf(0, 0, 0);
+            uint32_t phi, delta;
+            if (!HasAnyMove(pos))
+            {
+                phi = INF;
+                delta = 0;
+            }
+            else
+            {
+                // 根的阈值设为 INF - 1：越过即已解出（phi 或 delta 为 0 时另一个为 INF）
+                Mid(pos, INF - 1, INF - 1, 0);
+                if (!table.Probe(pos.hash, phi, delta)) phi = delta = 1;
+            }
+            out.phi = phi;
+            out.delta = delta;
+            if (phi == 0)
+            {
+                out.result = SolveResult::Win;
+                out.hasMove = true;
+                out.bestMove = proofMove;
+            }
+            else if (delta == 0)
+            {
+                out.result = SolveResult::Loss;
+            }
+            out.nodes = nodes;
+            out.timeMs = ElapsedMs();
+            return out;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        static constexpr int MAX_DEPTH = SQUARE_COUNT - 8; // 每手占一个空格，深度不超过除 8 个 Amazon 外的空格数
+
+        static uint32_t Add(uint32_t a, uint32_t b) { return static_cast<uint32_t>(std::min<uint64_t>(uint64_t(a) + b, INF)); }
+
+        double ElapsedMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+        bool OutOfBudget()
+        {
+            if (aborted) return true;
+            if (stopRequested.load(std::memory_order_relaxed)
+                || (limits.cancel && limits.cancel->load(std::memory_order_relaxed))) aborted = true;
+            else if (limits.maxNodes && nodes >= limits.maxNodes) aborted = true;
+            else if (limits.maxTimeMs > 0 && (nodes & 1023) == 0 && ElapsedMs() >= static_cast<double>(limits.maxTimeMs)) aborted = true;
+            return aborted;
+        }
+
+        // 读出子局面（已走入）的 (phi, delta)：表中没有时，对方无棋可走即已证明，否则按 (1, 1) 初始化
+        void ChildNumbers(const Position& child, uint32_t& phi, uint32_t& delta) const
+        {
+            if (table.Probe(child.hash, phi, delta)) return;
+            if (!HasAnyMove(child))
+            {
+                phi = INF;
+                delta = 0;
+                return;
+            }
+            phi = 1;
+            delta = 1;
+        }
+
+        // 在阈值内展开 pos（走子方至少有一手），返回时把 pos 的 (phi, delta) 写入表中
+        void Mid(Position& pos, uint32_t thPhi, uint32_t thDelta, int ply)
+        {
+            uint64_t startNodes = nodes++;
+            MoveList& moves = moveLists[ply];
+            GenerateMoves(pos, moves);
+            uint32_t phi = 0, delta = 0;
+            for (;;)
+            {
+                // phi = min delta(c)，delta = sum phi(c)；同时找出 delta 最小与次小的子节点
+                phi = INF;
+                delta = 0;
+                int best = 0;
+                uint32_t bestPhi = 0, secondDelta = INF;
+                for (int i = 0; i < moves.count; ++i)
+                {
+                    uint32_t cPhi, cDelta;
+                    pos.Play(moves[i]);
+                    ChildNumbers(pos, cPhi, cDelta);
+                    pos.Undo(moves[i]);
+                    delta = Add(delta, cPhi);
+                    if (cDelta < phi)
+                    {
+                        secondDelta = phi;
+                        phi = cDelta;
+                        best = i;
+                        bestPhi = cPhi;
+                    }
+                    else if (cDelta < secondDelta)
+                    {
+                        secondDelta = cDelta;
+                    }
+                    if (phi == 0) break; // 已找到必胜的一手
+                }
+                if (phi == 0)
+                {
+                    delta = INF;
+                    if (ply == 0) proofMove = moves[best];
+                }
+                if (phi >= thPhi || delta >= thDelta || OutOfBudget()) break;
+
+                // 子节点阈值：其 phi 计入本节点 delta 的和，其 delta 须低于次优值（放宽 1+ε）才继续
+                uint32_t childThPhi = Add(thDelta - delta, bestPhi);
+                uint64_t widened = std::max<uint64_t>(uint64_t(secondDelta) + 1,
+                    static_cast<uint64_t>(secondDelta * (1.0 + PROOF_EPSILON)));
+                uint32_t childThDelta = static_cast<uint32_t>(std::min<uint64_t>(thPhi, widened));
+                const Move m = moves[best];
+                pos.Play(m);
+                Mid(pos, childThPhi, childThDelta, ply + 1);
+                pos.Undo(m);
+            }
+            table.Store(pos.hash, phi, delta, nodes - startNodes);
+        }
+
+        ProofTable table;
+        std::vector<MoveList> moveLists; // 按层复用
+        SolverLimits limits;
+        Clock::time_point start;
+        std::atomic<bool> stopRequested{ false };
+        uint64_t nodes = 0;
+        bool aborted = false;
+        Move proofMove = MoveOf(0, 0, 0);
+    };
+} // namespace AmazonChess
@@ -0,0 +1,204 @@
+﻿#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "AmazonBitboard.h"
+
+// 参数化静态评估：若干局面特征的加权和（走子方视角）。
+// 特征：
+//   mobility        开放度差（与默认评估相同）
+//   queenTerritory  女王距离领地差：按女王走法比对方更早到达的空格数之差
+//   kingTerritory   国王距离领地差：按一步一格（八方向）比对方更早到达的空格数之差
+//   ownedRegion     独占区域差：只有一方能到达的空格数之差（封闭区域的归属）
+// 权重以 1/EVAL_WEIGHT_SCALE 为单位的定点整数保存，默认权重 { mobility = 1 } 与原评估完全一致。
+// 权重文件为文本，每行 "<特征名> <权重>"，'#' 开头为注释；由 AmazonTune 生成。
+
+namespace AmazonChess
+{
+    enum EvalFeature
+    {
+        FeatureMobility = 0,
+        FeatureQueenTerritory,
+        FeatureKingTerritory,
+        FeatureOwnedRegion,
+        EVAL_FEATURE_COUNT
+    };
+
+    static constexpr int EVAL_WEIGHT_SCALE = 256;
+    static constexpr unsigned EVAL_ALL_FEATURES = (1u << EVAL_FEATURE_COUNT) - 1;
+
+    inline const char* EvalFeatureName(int feature)
+    {
+        static const char* const names[EVAL_FEATURE_COUNT] = {
+            "mobility", "queenTerritory", "kingTerritory", "ownedRegion"
+        };
+        return names[feature];
+    }
+
+    using EvalFeatures = std::array<int, EVAL_FEATURE_COUNT>;
+
+    // 八邻域扩张一步（不跨越棋盘左右边缘）
+    inline Bitboard KingExpand(Bitboard b)
+    {
+        const Bitboard notFileA = 0xFEFEFEFEFEFEFEFEULL; // x != 0
+        const Bitboard notFileH = 0x7F7F7F7F7F7F7F7FULL; // x != 7
+        Bitboard row = b | ((b << 1) & notFileA) | ((b >> 1) & notFileH);
+        return row | (row << 8) | (row >> 8);
+    }
+
+    // 双方同步逐层扩张，领地为先于对方到达的空格（同层到达为中立）
+    inline void QueenTerritory(const Position& pos, Player me, int& mine, int& theirs)
+    {
+        Bitboard occ = pos.Occupied();
+        Bitboard empty = ~occ;
+        Bitboard frontier[2] = { pos.AmazonsOf(me), pos.AmazonsOf(Opponent(me)) };
+        Bitboard reached[2] = { 0, 0 };
+        Bitboard owned[2] = { 0, 0 };
+        while (frontier[0] | frontier[1])
+        {
+            Bitboard next[2];
+            for (int s = 0; s < 2; ++s)
+            {
+                Bitboard n = 0;
+                Bitboard f = frontier[s];
+                while (f) n |= QueenReach(PopLowest(f), occ);
+                next[s] = n & empty & ~reached[s];
+            }
+            owned[0] |= next[0] & ~(reached[1] | next[1]);
+            owned[1] |= next[1] & ~(reached[0] | next[0]);
+            for (int s = 0; s < 2; ++s)
+            {
+                reached[s] |= next[s];
+                frontier[s] = next[s];
+            }
+        }
+        mine = PopCount(owned[0]);
+        theirs = PopCount(owned[1]);
+    }
+
+    // 国王距离领地与独占区域（同一轮扩张得到）
+    inline void KingTerritory(const Position& pos, Player me, int& territory, int& region)
+    {
+        Bitboard empty = ~pos.Occupied();
+        Bitboard frontier[2] = { pos.AmazonsOf(me), pos.AmazonsOf(Opponent(me)) };
+        Bitboard reached[2] = { 0, 0 };
+        Bitboard owned[2] = { 0, 0 };
+        while (frontier[0] | frontier[1])
+        {
+            Bitboard next[2];
+            for (int s = 0; s < 2; ++s) next[s] = KingExpand(frontier[s]) & empty & ~reached[s];
+            owned[0] |= next[0] & ~(reached[1] | next[1]);
+            owned[1] |= next[1] & ~(reached[0] | next[0]);
+            for (int s = 0; s < 2; ++s)
+            {
+                reached[s] |= next[s];
+                frontier[s] = next[s];
+            }
+        }
+        territory = PopCount(owned[0]) - PopCount(owned[1]);
+        region = PopCount(reached[0] & ~reached[1]) - PopCount(reached[1] & ~reached[0]);
+    }
+
+    // 计算走子方视角的特征；mask 指定需要的特征，其余置 0
+    inline EvalFeatures ComputeFeatures(const Position& pos, unsigned mask = EVAL_ALL_FEATURES)
+    {
+        EvalFeatures f{};
+        Player me = pos.sideToMove;
+        if (mask & (1u << FeatureMobility))
+            f[FeatureMobility] = Mobility(pos, me) - Mobility(pos, Opponent(me));
+        if (mask & (1u << FeatureQueenTerritory))
+        {
+            int mine = 0, theirs = 0;
+            QueenTerritory(pos, me, mine, theirs);
+            f[FeatureQueenTerritory] = mine - theirs;
+        }
+        if (mask & ((1u << FeatureKingTerritory) | (1u << FeatureOwnedRegion)))
+            KingTerritory(pos, me, f[FeatureKingTerritory], f[FeatureOwnedRegion]);
+        return f;
+    }
+
+    class EvalParams
+    {
+    public:
+        std::array<int, EVAL_FEATURE_COUNT> weights{};
+
+        // 默认权重：仅开放度，等同于原评估
+        static EvalParams Default()
+        {
+            EvalParams p;
+            p.weights[FeatureMobility] = EVAL_WEIGHT_SCALE;
+            return p;
+        }
+
+        // 非零权重对应的特征集合
+        unsigned FeatureMask() const
+        {
+            unsigned mask = 0;
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+                if (weights[i]) mask |= 1u << i;
+            return mask;
+        }
+
+        int Score(const EvalFeatures& f) const
+        {
+            int sum = 0;
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i) sum += weights[i] * f[i];
+            return sum / EVAL_WEIGHT_SCALE;
+        }
+
+        int Score(const Position& pos) const
+        {
+            return Score(ComputeFeatures(pos, FeatureMask()));
+        }
+
+        // 读取权重文件：未出现的特征权重为 0；出现未知特征名或格式错误时返回 false
+        bool Load(const std::string& path)
+        {
+            std::ifstream ifs(path);
+            if (!ifs.is_open()) return false;
+            std::array<int, EVAL_FEATURE_COUNT> loaded{};
+            bool any = false;
+            std::string line;
+            while (std::getline(ifs, line))
+            {
+                std::istringstream iss(line);
+                std::string name;
+                double value;
+                if (!(iss >> name) || name[0] == '#') continue;
+                if (!(iss >> value)) return false;
+                int index = -1;
+                for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+                    if (name == EvalFeatureName(i)) index = i;
+                if (index < 0) return false;
+                loaded[index] = static_cast<int>(std::lround(value * EVAL_WEIGHT_SCALE));
+                any = true;
+            }
+            if (!any) return false;
+            weights = loaded;
+            return true;
+        }
+
+        bool Save(const std::string& path) const
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            if (!ofs.is_open()) return false;
+            ofs << "# Amazon evaluation weights (score = sum(weight * feature), side-to-move view)\n";
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+                ofs << EvalFeatureName(i) << " " << static_cast<double>(weights[i]) / EVAL_WEIGHT_SCALE << "\n";
+            return static_cast<bool>(ofs);
+        }
+    };
+
+    // 读取权重文件，失败（含文件不存在）返回 nullptr
+    inline std::shared_ptr<const EvalParams> LoadEvalParams(const std::string& path)
+    {
+        std::shared_ptr<EvalParams> params = std::make_shared<EvalParams>();
+        if (!params->Load(path)) return nullptr;
+        return params;
+    }
+} // namespace AmazonChess
@@ -0,0 +1,264 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "AmazonRecord.h"
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// 对局日志（.acj，二进制、只追加）：每走完一手追加一条定长记录并按批 fflush，进程崩溃或被杀时最多丢失未刷盘的几手。
+// 文件头 32 字节：magic "ACJL"、版本、起始局面（箭位掩码 u64、白黑各 4 个 Amazon 格（缺失为 0xFF）、走子方 u8、保留 3 字节）、
+// 起始局面的 CRC-32；之后每手 8 字节：
+//   flags   u8   bit0 = 黑方，bit1 = 终局一手（对应 .acp 行尾 '*'）
+//   from    u8   起点格号
+//   to      u8   落点格号
+//   arrow   u8   箭格号
+//   check   u32  CRC-32（前 4 字节 + 该手序号，序号参与校验，错位或重复的记录也会被识别）
+// 所有多字节字段为小端。恢复时从头校验，第一条不完整或校验失败的记录及其后内容视为残缺尾部并截掉。
+// 与整局重写 .acp 相比，每手只写 8 字节，代价与对局长度无关（AmazonBench journal 给出对比）。
+
+namespace AmazonChess
+{
+    static constexpr uint32_t JOURNAL_MAGIC = 0x4C4A4341; // "ACJL"
+    static constexpr uint32_t JOURNAL_VERSION = 1;
+    static constexpr long JOURNAL_HEADER_BYTES = 32;
+    static constexpr long JOURNAL_RECORD_BYTES = 8;
+
+    // CRC-32（IEEE 802.3 多项式，反射），表在首次使用时生成
+    inline uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+    {
+        static const struct Table
+        {
+            uint32_t v[256];
+            Table()
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    v[i] = c;
+                }
+            }
+        } table;
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) crc = table.v[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    namespace JournalDetail
+    {
+        inline void PutU32(unsigned char* p, uint32_t v)
+        {
+            for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+
+        inline uint32_t GetU32(const unsigned char* p)
+        {
+            uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        inline uint32_t RecordCheck(const unsigned char* record, uint32_t ply)
+        {
+            unsigned char data[8];
+            for (int i = 0; i < 4; ++i) data[i] = record[i];
+            PutU32(data + 4, ply);
+            return Crc32(data, sizeof(data));
+        }
+
+        inline void EncodeRecord(const RecordedMove& rm, bool gameEnd, uint32_t ply, unsigned char* out)
+        {
+            out[0] = static_cast<unsigned char>((rm.player == Player::Black ? 1 : 0) | (gameEnd ? 2 : 0));
+            out[1] = rm.move.from;
+            out[2] = rm.move.to;
+            out[3] = rm.move.arrow;
+            PutU32(out + 4, RecordCheck(out, ply));
+        }
+
+        inline bool DecodeRecord(const unsigned char* in, uint32_t ply, RecordedMove& rm, bool& gameEnd)
+        {
+            if (GetU32(in + 4) != RecordCheck(in, ply)) return false;
+            if ((in[0] & ~3) != 0 || in[1] >= SQUARE_COUNT || in[2] >= SQUARE_COUNT || in[3] >= SQUARE_COUNT) return false;
+            rm.player = (in[0] & 1) ? Player::Black : Player::White;
+            rm.move = MoveOf(in[1], in[2], in[3]);
+            gameEnd = (in[0] & 2) != 0;
+            return true;
+        }
+
+        inline void EncodeHeader(const Position& start, unsigned char* out)
+        {
+            PutU32(out, JOURNAL_MAGIC);
+            PutU32(out + 4, JOURNAL_VERSION);
+            for (int i = 0; i < 8; ++i) out[8 + i] = static_cast<unsigned char>(start.arrows >> (8 * i));
+            for (int side = 0; side < 2; ++side)
+            {
+                Bitboard a = start.amazons[side];
+                for (int k = 0; k < 4; ++k)
+                    out[16 + side * 4 + k] = a ? static_cast<unsigned char>(PopLowest(a)) : 0xFF;
+            }
+            out[24] = start.sideToMove == Player::Black ? 1 : 0;
+            out[25] = out[26] = out[27] = 0;
+            PutU32(out + 28, Crc32(out + 8, 20));
+        }
+
+        inline bool DecodeHeader(const unsigned char* in, Position& start)
+        {
+            if (GetU32(in) != JOURNAL_MAGIC || GetU32(in + 4) != JOURNAL_VERSION || GetU32(in + 28) != Crc32(in + 8, 20)) return false;
+            Position pos;
+            for (int i = 0; i < 8; ++i)
+            {
+                Bitboard byte = in[8 + i];
+                while (byte) pos.Put(PieceType::Arrow, 8 * i + PopLowest(byte));
+            }
+            for (int side = 0; side < 2; ++side)
+                for (int k = 0; k < 4; ++k)
+                    if (in[16 + side * 4 + k] < SQUARE_COUNT)
+                        pos.Put(side == 0 ? PieceType::WhiteAmazon : PieceType::BlackAmazon, in[16 + side * 4 + k]);
+            pos.SetSideToMove((in[24] & 1) ? Player::Black : Player::White);
+            start = pos;
+            return true;
+        }
+
+        // 把文件截到 size 字节（用于去掉残缺尾部）
+        inline bool Truncate(std::FILE* file, long size)
+        {
+            std::fflush(file);
+#if defined(_WIN32)
+            return _chsize_s(_fileno(file), size) == 0;
+#else
+            return ftruncate(fileno(file), size) == 0;
+#endif
+        }
+    } // namespace JournalDetail
+
+    // 读取日志：out 为起始局面与通过校验的各手（遇到终局记录即停止），plies 为有效记录数。
+    // 文件不存在或文件头不符返回 false；残缺尾部不算错误
+    inline bool ReadJournal(const std::string& path, GameRecord& out, size_t* plies = nullptr)
+    {
+        out.moves.clear();
+        out.finished = false;
+        out.start = Position::Initial();
+        if (plies) *plies = 0;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        unsigned char header[JOURNAL_HEADER_BYTES];
+        if (std::fread(header, 1, sizeof(header), file) != sizeof(header) || !JournalDetail::DecodeHeader(header, out.start))
+        {
+            std::fclose(file);
+            return false;
+        }
+        unsigned char record[JOURNAL_RECORD_BYTES];
+        while (std::fread(record, 1, sizeof(record), file) == sizeof(record))
+        {
+            RecordedMove rm;
+            bool gameEnd;
+            if (!JournalDetail::DecodeRecord(record, static_cast<uint32_t>(out.moves.size()), rm, gameEnd)) break;
+            out.moves.push_back(rm);
+            if (gameEnd) { out.finished = true; break; }
+        }
+        std::fclose(file);
+        if (plies) *plies = out.moves.size();
+        return true;
+    }
+
+    // 日志写出器（单线程使用）：每 flushPlies 手 fflush 一次；syncToDisk 时同时 fsync，断电也不丢已刷盘的手
+    class JournalWriter
+    {
+    public:
+        JournalWriter() = default;
+        ~JournalWriter() { Close(); }
+
+        JournalWriter(const JournalWriter&) = delete;
+        JournalWriter& operator=(const JournalWriter&) = delete;
+
+        void SetFlushPlies(int n) { flushPlies = n > 0 ? n : 1; }
+        void SetSyncToDisk(bool on) { syncToDisk = on; }
+
+        bool IsOpen() const { return file != nullptr; }
+        uint32_t Plies() const { return plies; }
+
+        // 新建（覆盖）日志，记下起始局面
+        bool Create(const std::string& path, const Position& start = Position::Initial())
+        {
+            Close();
+            file = std::fopen(path.c_str(), "wb");
+            if (!file) return false;
+            unsigned char header[JOURNAL_HEADER_BYTES];
+            JournalDetail::EncodeHeader(start, header);
+            if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header) || !Sync())
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        // 打开已有日志继续追加：保留前 keepPlies 手（通常为 ReadJournal 得到的有效手数），其后的残缺尾部被截掉
+        bool Resume(const std::string& path, size_t keepPlies)
+        {
+            Close();
+            file = std::fopen(path.c_str(), "r+b");
+            if (!file) return false;
+            long size = JOURNAL_HEADER_BYTES + static_cast<long>(keepPlies) * JOURNAL_RECORD_BYTES;
+            if (!JournalDetail::Truncate(file, size) || std::fseek(file, size, SEEK_SET) != 0)
+            {
+                Close();
+                return false;
+            }
+            plies = static_cast<uint32_t>(keepPlies);
+            return true;
+        }
+
+        // 追加一手；达到 flushPlies 或终局时刷盘
+        bool Append(const RecordedMove& rm, bool gameEnd)
+        {
+            if (!file) return false;
+            unsigned char record[JOURNAL_RECORD_BYTES];
+            JournalDetail::EncodeRecord(rm, gameEnd, plies, record);
+            if (std::fwrite(record, 1, sizeof(record), file) != sizeof(record)) return false;
+            ++plies;
+            if (++pending >= flushPlies || gameEnd) return Flush();
+            return true;
+        }
+
+        bool Flush()
+        {
+            if (!file) return false;
+            pending = 0;
+            return Sync();
+        }
+
+        void Close()
+        {
+            if (!file) return;
+            Flush();
+            std::fclose(file);
+            file = nullptr;
+            plies = 0;
+            pending = 0;
+        }
+
+    private:
+        bool Sync()
+        {
+            if (std::fflush(file) != 0) return false;
+            if (!syncToDisk) return true;
+#if defined(_WIN32)
+            return _commit(_fileno(file)) == 0;
+#else
+            return fsync(fileno(file)) == 0;
+#endif
+        }
+
+        std::FILE* file = nullptr;
+        uint32_t plies = 0;
+        int pending = 0;
+        int flushPlies = 1;
+        bool syncToDisk = false;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,258 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "AmazonBatchEval.h"
+
+// 蒙特卡洛树搜索（UCT），叶节点不做随机走子，以一层静态评估代替，并采用渐进展开：
+//   - 节点首次被访问时生成全部走法，把所有子局面放进一个 PositionBatch，用 EvaluateBatch 一次算出开放度差
+//     （AVX2 下 4 个局面一组并行），作为每手的先验，按先验从高到低排序；
+//     同一次计算的最大值（一层 negamax）就是该节点的叶节点估值，不需要再单独评估。
+//   - 已访问 n 次的节点只允许从排序靠前的 widenBase * n^widenExponent 个子节点中选择，随访问次数逐步放宽；
+//     开局每个局面约两千手，若一次全部展开，UCT 要先把每个子节点各访问一次，预算大多花在明显较差的走法上。
+//   - 根以外的节点只保留先验最高的 innerMoveCap 手（渐进展开下这之后的走法几乎不会被放开），内存随节点数线性增长。
+// 价值以胜率表示（0..1）：估值 s 映射为 1 / (1 + exp(-s / valueScale))，被封死为 0，封死对方为 1。
+
+namespace AmazonChess
+{
+    struct MctsOptions
+    {
+        double exploration = 0.5;       // UCT 探索系数（价值为 0..1）
+        bool progressiveWidening = true;
+        double widenBase = 2.0;
+        double widenExponent = 0.5;
+        int innerMoveCap = 128;         // 根以外节点保留的候选手数，0 = 全部保留
+        double valueScale = 8.0;
+    };
+
+    struct MctsResult
+    {
+        bool hasMove = false;
+        Move bestMove = MoveOf(0, 0, 0);
+        uint64_t playouts = 0;
+        uint32_t bestVisits = 0;
+        double value = 0.5;  // 根走子方视角的最佳子节点平均价值
+        size_t treeNodes = 0;
+        double timeMs = 0.0;
+    };
+
+    class Mcts
+    {
+    public:
+        explicit Mcts(const MctsOptions& options = MctsOptions()) : options(options), moveList(new MoveList()) {}
+
+        void SetOptions(const MctsOptions& o) { options = o; }
+        const MctsOptions& Options() const { return options; }
+
+        // 以 root 为根重新建树
+        void SetRoot(const Position& root)
+        {
+            rootPosition = root;
+            nodes.clear();
+            movePool.clear();
+            nodes.emplace_back();
+            best = NO_CHILD;
+            playouts = 0;
+        }
+
+        // 再做 count 次模拟
+        void Run(uint64_t count)
+        {
+            for (uint64_t i = 0; i < count; ++i) Playout();
+        }
+
+        // 访问次数最多的根子节点（同访问数时取先达到者）；根无棋可走时 hasMove 为 false
+        MctsResult Result() const
+        {
+            MctsResult r;
+            r.playouts = playouts;
+            r.treeNodes = nodes.size();
+            if (best == NO_CHILD) return r;
+            const Node& n = nodes[best];
+            r.hasMove = true;
+            r.bestMove = n.move;
+            r.bestVisits = n.visits;
+            r.value = n.visits ? n.valueSum / n.visits : 0.5;
+            return r;
+        }
+
+        // 以模拟次数与时间（ms，0 = 不限）为限搜索 root
+        MctsResult Search(const Position& root, uint64_t maxPlayouts, int64_t maxTimeMs = 0)
+        {
+            using Clock = std::chrono::steady_clock;
+            Clock::time_point start = Clock::now();
+            SetRoot(root);
+            auto elapsedMs = [&] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+            while (playouts < maxPlayouts)
+            {
+                Playout();
+                if (maxTimeMs > 0 && (playouts & 63) == 0 && elapsedMs() >= static_cast<double>(maxTimeMs)) break;
+                if (nodes[0].terminal) break;
+            }
+            MctsResult r = Result();
+            r.timeMs = elapsedMs();
+            return r;
+        }
+
+        // 一次模拟：选择 -> 展开叶节点（评估全部子局面得到先验与估值）-> 回传
+        void Playout()
+        {
+            Position pos = rootPosition;
+            path.clear();
+            path.push_back(0);
+            uint32_t index = 0;
+            double value; // pos 的走子方视角
+            for (;;)
+            {
+                if (!nodes[index].expanded)
+                {
+                    value = Expand(index, pos);
+                    break;
+                }
+                if (nodes[index].terminal)
+                {
+                    value = nodes[index].leafValue;
+                    break;
+                }
+                index = SelectChild(index);
+                pos.Play(nodes[index].move);
+                path.push_back(index);
+            }
+            // 节点的 valueSum 以走入该节点的一方（父节点走子方）为视角
+            for (size_t i = path.size(); i-- > 0;)
+            {
+                value = 1.0 - value;
+                Node& n = nodes[path[i]];
+                ++n.visits;
+                n.valueSum += value;
+            }
+            ++playouts;
+            if (path.size() > 1)
+            {
+                uint32_t child = path[1];
+                if (best == NO_CHILD || nodes[child].visits > nodes[best].visits) best = child;
+            }
+        }
+
+    private:
+        static constexpr uint32_t NO_CHILD = 0xFFFFFFFFu;
+
+        struct Node
+        {
+            Move move = MoveOf(0, 0, 0); // 从父节点走到此处的一手
+            uint32_t visits = 0;
+            double valueSum = 0.0;
+            double leafValue = 0.5;       // 展开时的一层估值（走子方视角）
+            uint32_t firstMove = 0;       // 在 movePool 中的起点
+            uint32_t moveCount = 0;       // 保留的候选手数（按先验降序）
+            bool expanded = false;
+            bool terminal = false;
+            std::vector<uint32_t> children; // 已放开的子节点，即 movePool 中前 children.size() 手
+        };
+
+        double ToValue(int score) const
+        {
+            if (score >= MATE_BOUND) return 1.0;
+            if (score <= -MATE_BOUND) return 0.0;
+            return 1.0 / (1.0 + std::exp(-score / options.valueScale));
+        }
+
+        double Expand(uint32_t index, Position& pos)
+        {
+            GenerateMoves(pos, *moveList);
+            Node& node = nodes[index];
+            node.expanded = true;
+            int count = moveList->count;
+            if (count == 0)
+            {
+                node.terminal = true;
+                node.leafValue = 0.0;
+                return node.leafValue;
+            }
+            batch.Clear();
+            batch.Reserve(static_cast<size_t>(count));
+            for (int i = 0; i < count; ++i)
+            {
+                const Move& m = (*moveList)[i];
+                pos.Play(m);
+                batch.Add(pos);
+                pos.Undo(m);
+            }
+            scores.resize(static_cast<size_t>(count));
+            EvaluateBatch(batch, 1, scores.data(), scratch);
+
+            order.resize(static_cast<size_t>(count));
+            for (int i = 0; i < count; ++i) order[i] = i;
+            size_t keep = static_cast<size_t>(count);
+            if (index != 0 && options.innerMoveCap > 0) keep = std::min(keep, static_cast<size_t>(options.innerMoveCap));
+            // 子局面分值为对方视角，取负即本方先验；同分保持生成顺序
+            auto better = [this](int a, int b) { return scores[a] != scores[b] ? scores[a] < scores[b] : a < b; };
+            if (keep < order.size())
+            {
+                std::nth_element(order.begin(), order.begin() + keep, order.end(), better);
+                order.resize(keep);
+            }
+            std::sort(order.begin(), order.end(), better);
+
+            node.firstMove = static_cast<uint32_t>(movePool.size());
+            node.moveCount = static_cast<uint32_t>(order.size());
+            for (int i : order) movePool.push_back((*moveList)[i]);
+            node.leafValue = ToValue(-scores[order[0]]);
+            return node.leafValue;
+        }
+
+        size_t AllowedChildren(const Node& n) const
+        {
+            if (!options.progressiveWidening) return n.moveCount;
+            double k = options.widenBase * std::pow(static_cast<double>(n.visits) + 1.0, options.widenExponent);
+            return std::min(static_cast<size_t>(n.moveCount), std::max<size_t>(1, static_cast<size_t>(k)));
+        }
+
+        uint32_t SelectChild(uint32_t index)
+        {
+            size_t allowed = AllowedChildren(nodes[index]);
+            while (nodes[index].children.size() < allowed)
+            {
+                uint32_t child = static_cast<uint32_t>(nodes.size());
+                Move m = movePool[nodes[index].firstMove + nodes[index].children.size()];
+                nodes.emplace_back(); // 可能使 nodes 中的引用失效，之后按下标访问
+                nodes.back().move = m;
+                nodes[index].children.push_back(child);
+            }
+            const Node& parent = nodes[index];
+            double logN = std::log(static_cast<double>(std::max<uint32_t>(1, parent.visits)));
+            uint32_t chosen = parent.children[0];
+            double bestScore = -1.0;
+            for (uint32_t c : parent.children)
+            {
+                const Node& n = nodes[c];
+                if (n.visits == 0) return c; // 未访问过的按先验顺序优先
+                double s = n.valueSum / n.visits + options.exploration * std::sqrt(logN / n.visits);
+                if (s > bestScore)
+                {
+                    bestScore = s;
+                    chosen = c;
+                }
+            }
+            return chosen;
+        }
+
+        MctsOptions options;
+        Position rootPosition;
+        std::vector<Node> nodes;
+        std::vector<Move> movePool;   // 各节点按先验降序保留的候选手
+        std::vector<uint32_t> path;
+        uint32_t best = NO_CHILD;
+        uint64_t playouts = 0;
+        // 展开用的临时缓冲区，跨节点复用
+        std::unique_ptr<MoveList> moveList;
+        PositionBatch batch;
+        std::vector<int> scores;
+        std::vector<int> scratch;
+        std::vector<int> order;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,317 @@
+﻿#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include "AmazonBitboard.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define AMAZON_MOBILITY_X86 1
+#define AMAZON_TARGET_AVX2 __attribute__((target("avx2")))
+#define AMAZON_TARGET_SSSE3 __attribute__((target("ssse3")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define AMAZON_MOBILITY_X86 1
+#define AMAZON_TARGET_AVX2
+#define AMAZON_TARGET_SSSE3
+#endif
+
+// 按字节棋盘（每格一个 PieceType，square = y * 8 + x，即 Game::BoardGrid / GetBestMove 的棋盘）一次算出
+// 所有格子的可达空格数与双方开放度。
+// 做法：E 为空格掩码，对每个方向 d 迭代 P = shift(P & E, d)（越出棋盘或跨行处补 0），
+// 第 j 次迭代后 P[s] 表示 s 沿 d 的前 j 格全空，七次迭代的 P 累加即该方向的可达格数。
+// 64 格整体放在两个 AVX2 / 四个 SSE 寄存器中，八个方向共约两百条向量指令；运行时按 CPU 选择内核。
+
+namespace AmazonChess
+{
+    struct MobilityCounts
+    {
+        std::array<uint8_t, SQUARE_COUNT> reach{}; // 每格沿八个方向的可达空格数（与该格本身是否有子无关）
+        int openness[2] = { 0, 0 };               // 按 Player 下标：该方所有 Amazon 的 reach 之和
+    };
+
+    enum class MobilityKernel : uint8_t { Scalar, Ssse3, Avx2 };
+
+    inline const char* MobilityKernelName(MobilityKernel k)
+    {
+        switch (k)
+        {
+        case MobilityKernel::Avx2: return "avx2";
+        case MobilityKernel::Ssse3: return "ssse3";
+        default: return "scalar";
+        }
+    }
+
+    inline void ToByteBoard(const std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE>& board, uint8_t* cells)
+    {
+        for (int y = 0; y < BOARD_SIZE; ++y)
+            for (int x = 0; x < BOARD_SIZE; ++x)
+                cells[SquareOf(x, y)] = static_cast<uint8_t>(board[y][x]);
+    }
+
+    // 可移植实现：逐格逐方向走到阻挡为止
+    inline void CountMobilityScalar(const uint8_t* cells, MobilityCounts& out)
+    {
+        out.openness[0] = out.openness[1] = 0;
+        for (int s = 0; s < SQUARE_COUNT; ++s)
+        {
+            int x0 = s % BOARD_SIZE, y0 = s / BOARD_SIZE;
+            int count = 0;
+            for (int d = 0; d < 8; ++d)
+            {
+                int x = x0 + DIRECTION_DX[d], y = y0 + DIRECTION_DY[d];
+                while (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE
+                       && cells[SquareOf(x, y)] == static_cast<uint8_t>(PieceType::None))
+                {
+                    ++count;
+                    x += DIRECTION_DX[d];
+                    y += DIRECTION_DY[d];
+                }
+            }
+            out.reach[s] = static_cast<uint8_t>(count);
+            if (cells[s] == static_cast<uint8_t>(PieceType::WhiteAmazon)) out.openness[0] += count;
+            else if (cells[s] == static_cast<uint8_t>(PieceType::BlackAmazon)) out.openness[1] += count;
+        }
+    }
+
+#if defined(AMAZON_MOBILITY_X86)
+    namespace MobilityDetail
+    {
+        // 按输出格的列判断一步是否合法：dx = +1 时要求 x <= 6，dx = -1 时要求 x >= 1
+        static const uint8_t EAST_VALID[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+        static const uint8_t WEST_VALID[8] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+        // ---- AVX2：lo = 第 0..31 格，hi = 第 32..63 格
+
+        struct Board256
+        {
+            __m256i lo, hi;
+        };
+
+        // out[s] = v[s + K]，越界补 0（|K| < 16）
+        template <int K>
+        AMAZON_TARGET_AVX2 inline Board256 Shift256(const Board256& v)
+        {
+            Board256 r;
+            if (K > 0)
+            {
+                __m256i mid = _mm256_permute2x128_si256(v.lo, v.hi, 0x21);  // [lo 高半, hi 低半]
+                __m256i top = _mm256_permute2x128_si256(v.hi, v.hi, 0x81);  // [hi 高半, 0]
+                r.lo = _mm256_alignr_epi8(mid, v.lo, K > 0 ? K : 1);
+                r.hi = _mm256_alignr_epi8(top, v.hi, K > 0 ? K : 1);
+            }
+            else
+            {
+                __m256i mid = _mm256_permute2x128_si256(v.lo, v.hi, 0x21);  // [lo 高半, hi 低半]
+                __m256i bottom = _mm256_permute2x128_si256(v.lo, v.lo, 0x08); // [0, lo 低半]
+                r.lo = _mm256_alignr_epi8(v.lo, bottom, K < 0 ? 16 + K : 1);
+                r.hi = _mm256_alignr_epi8(v.hi, mid, K < 0 ? 16 + K : 1);
+            }
+            return r;
+        }
+
+        template <int K, int DX>
+        AMAZON_TARGET_AVX2 inline void AccumulateDirection256(const Board256& empty, const Board256& valid, Board256& count)
+        {
+            Board256 p = empty;
+            for (int j = 0; j < BOARD_SIZE - 1; ++j)
+            {
+                p = Shift256<K>(p);
+                if (DX != 0)
+                {
+                    p.lo = _mm256_and_si256(p.lo, valid.lo);
+                    p.hi = _mm256_and_si256(p.hi, valid.hi);
+                }
+                // P 为 0xFF / 0x00，减去即加一
+                count.lo = _mm256_sub_epi8(count.lo, p.lo);
+                count.hi = _mm256_sub_epi8(count.hi, p.hi);
+                p.lo = _mm256_and_si256(p.lo, empty.lo);
+                p.hi = _mm256_and_si256(p.hi, empty.hi);
+            }
+        }
+
+        AMAZON_TARGET_AVX2 inline int SumMasked256(const Board256& count, const Board256& cells, uint8_t piece)
+        {
+            __m256i key = _mm256_set1_epi8(static_cast<char>(piece));
+            __m256i lo = _mm256_and_si256(count.lo, _mm256_cmpeq_epi8(cells.lo, key));
+            __m256i hi = _mm256_and_si256(count.hi, _mm256_cmpeq_epi8(cells.hi, key));
+            __m256i sums = _mm256_add_epi64(_mm256_sad_epu8(lo, _mm256_setzero_si256()), _mm256_sad_epu8(hi, _mm256_setzero_si256()));
+            __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+            return _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+        }
+
+        AMAZON_TARGET_AVX2 inline void CountMobilityAvx2(const uint8_t* cells, MobilityCounts& out)
+        {
+            Board256 board, empty, east, west, count;
+            board.lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells));
+            board.hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + 32));
+            empty.lo = _mm256_cmpeq_epi8(board.lo, _mm256_setzero_si256());
+            empty.hi = _mm256_cmpeq_epi8(board.hi, _mm256_setzero_si256());
+            uint64_t e, w;
+            std::memcpy(&e, EAST_VALID, 8);
+            std::memcpy(&w, WEST_VALID, 8);
+            east.lo = east.hi = _mm256_set1_epi64x(static_cast<long long>(e));
+            west.lo = west.hi = _mm256_set1_epi64x(static_cast<long long>(w));
+            count.lo = count.hi = _mm256_setzero_si256();
+
+            // 顺序同 DIRECTION_DX / DIRECTION_DY：(1,0) (-1,0) (0,1) (0,-1) (1,1) (1,-1) (-1,1) (-1,-1)
+            AccumulateDirection256<1, 1>(empty, east, count);
+            AccumulateDirection256<-1, -1>(empty, west, count);
+            AccumulateDirection256<8, 0>(empty, east, count);
+            AccumulateDirection256<-8, 0>(empty, east, count);
+            AccumulateDirection256<9, 1>(empty, east, count);
+            AccumulateDirection256<-7, 1>(empty, east, count);
+            AccumulateDirection256<7, -1>(empty, west, count);
+            AccumulateDirection256<-9, -1>(empty, west, count);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.reach.data()), count.lo);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.reach.data() + 32), count.hi);
+            out.openness[0] = SumMasked256(count, board, static_cast<uint8_t>(PieceType::WhiteAmazon));
+            out.openness[1] = SumMasked256(count, board, static_cast<uint8_t>(PieceType::BlackAmazon));
+        }
+
+        // ---- SSSE3：v[i] = 第 16i..16i+15 格
+
+        struct Board128
+        {
+            __m128i v[4];
+        };
+
+        template <int K>
+        AMAZON_TARGET_SSSE3 inline Board128 Shift128(const Board128& b)
+        {
+            Board128 r;
+            const __m128i zero = _mm_setzero_si128();
+            if (K > 0)
+            {
+                r.v[0] = _mm_alignr_epi8(b.v[1], b.v[0], K > 0 ? K : 1);
+                r.v[1] = _mm_alignr_epi8(b.v[2], b.v[1], K > 0 ? K : 1);
+                r.v[2] = _mm_alignr_epi8(b.v[3], b.v[2], K > 0 ? K : 1);
+                r.v[3] = _mm_alignr_epi8(zero, b.v[3], K > 0 ? K : 1);
+            }
+            else
+            {
+                r.v[0] = _mm_alignr_epi8(b.v[0], zero, K < 0 ? 16 + K : 1);
+                r.v[1] = _mm_alignr_epi8(b.v[1], b.v[0], K < 0 ? 16 + K : 1);
+                r.v[2] = _mm_alignr_epi8(b.v[2], b.v[1], K < 0 ? 16 + K : 1);
+                r.v[3] = _mm_alignr_epi8(b.v[3], b.v[2], K < 0 ? 16 + K : 1);
+            }
+            return r;
+        }
+
+        template <int K, int DX>
+        AMAZON_TARGET_SSSE3 inline void AccumulateDirection128(const Board128& empty, __m128i valid, Board128& count)
+        {
+            Board128 p = empty;
+            for (int j = 0; j < BOARD_SIZE - 1; ++j)
+            {
+                p = Shift128<K>(p);
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (DX != 0) p.v[i] = _mm_and_si128(p.v[i], valid);
+                    count.v[i] = _mm_sub_epi8(count.v[i], p.v[i]);
+                    p.v[i] = _mm_and_si128(p.v[i], empty.v[i]);
+                }
+            }
+        }
+
+        AMAZON_TARGET_SSSE3 inline int SumMasked128(const Board128& count, const Board128& cells, uint8_t piece)
+        {
+            __m128i key = _mm_set1_epi8(static_cast<char>(piece));
+            __m128i sums = _mm_setzero_si128();
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128i masked = _mm_and_si128(count.v[i], _mm_cmpeq_epi8(cells.v[i], key));
+                sums = _mm_add_epi64(sums, _mm_sad_epu8(masked, _mm_setzero_si128()));
+            }
+            return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+        }
+
+        AMAZON_TARGET_SSSE3 inline void CountMobilitySsse3(const uint8_t* cells, MobilityCounts& out)
+        {
+            Board128 board, empty, count;
+            for (int i = 0; i < 4; ++i)
+            {
+                board.v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + 16 * i));
+                empty.v[i] = _mm_cmpeq_epi8(board.v[i], _mm_setzero_si128());
+                count.v[i] = _mm_setzero_si128();
+            }
+            uint64_t e, w;
+            std::memcpy(&e, EAST_VALID, 8);
+            std::memcpy(&w, WEST_VALID, 8);
+            __m128i east = _mm_set1_epi64x(static_cast<long long>(e));
+            __m128i west = _mm_set1_epi64x(static_cast<long long>(w));
+
+            AccumulateDirection128<1, 1>(empty, east, count);
+            AccumulateDirection128<-1, -1>(empty, west, count);
+            AccumulateDirection128<8, 0>(empty, east, count);
+            AccumulateDirection128<-8, 0>(empty, east, count);
+            AccumulateDirection128<9, 1>(empty, east, count);
+            AccumulateDirection128<-7, 1>(empty, east, count);
+            AccumulateDirection128<7, -1>(empty, west, count);
+            AccumulateDirection128<-9, -1>(empty, west, count);
+
+            for (int i = 0; i < 4; ++i)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.reach.data() + 16 * i), count.v[i]);
+            out.openness[0] = SumMasked128(count, board, static_cast<uint8_t>(PieceType::WhiteAmazon));
+            out.openness[1] = SumMasked128(count, board, static_cast<uint8_t>(PieceType::BlackAmazon));
+        }
+    } // namespace MobilityDetail
+#endif
+
+    // 当前 CPU 支持的最快内核
+    inline MobilityKernel DetectMobilityKernel()
+    {
+#if defined(AMAZON_MOBILITY_X86) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return MobilityKernel::Avx2;
+        if (__builtin_cpu_supports("ssse3")) return MobilityKernel::Ssse3;
+#elif defined(AMAZON_MOBILITY_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        if (osAvx && maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) return MobilityKernel::Avx2;
+        }
+        if (ssse3) return MobilityKernel::Ssse3;
+#endif
+        return MobilityKernel::Scalar;
+    }
+
+    inline bool MobilityKernelSupported(MobilityKernel k)
+    {
+        return static_cast<int>(k) <= static_cast<int>(DetectMobilityKernel());
+    }
+
+    // 用指定内核计算（调用方保证 CPU 支持，见 MobilityKernelSupported）
+    inline void CountMobility(const uint8_t* cells, MobilityCounts& out, MobilityKernel kernel)
+    {
+        switch (kernel)
+        {
+#if defined(AMAZON_MOBILITY_X86)
+        case MobilityKernel::Avx2: MobilityDetail::CountMobilityAvx2(cells, out); return;
+        case MobilityKernel::Ssse3: MobilityDetail::CountMobilitySsse3(cells, out); return;
+#endif
+        default: CountMobilityScalar(cells, out); return;
+        }
+    }
+
+    // 首次调用时检测一次 CPU，之后固定使用该内核
+    inline MobilityKernel ActiveMobilityKernel()
+    {
+        static const MobilityKernel kernel = DetectMobilityKernel();
+        return kernel;
+    }
+
+    inline void CountMobility(const uint8_t* cells, MobilityCounts& out)
+    {
+        CountMobility(cells, out, ActiveMobilityKernel());
+    }
+} // namespace AmazonChess
@@ -0,0 +1,261 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AMAZON_NN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AMAZON_NN_SSE2 1
+#endif
+
+// 小型 NNUE 风格评估网络。
+// 输入特征：以某一方视角的 (己方 Amazon 格, 对方 Amazon 格, 箭格) 各 64 个，共 192 个；
+// 黑方视角将棋盘上下翻转（y -> 7-y），使双方特征分布一致。
+// 第一层累加器（每方视角 HIDDEN 个 int16）在走子时增量更新：每手只涉及 3 个特征列。
+// 输出层：[走子方累加器, 对方累加器] 经 clipped ReLU 后与输出权重做整数点积。
+
+namespace AmazonChess
+{
+    class Network
+    {
+    public:
+        static constexpr int HIDDEN = 64;
+        static constexpr int FEATURES = 3 * SQUARE_COUNT;
+        static constexpr int16_t CLIP = 127;
+        static constexpr uint32_t FILE_MAGIC = 0x4E4E4341; // "ACNN"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        enum FeatureKind { OwnAmazon = 0, OppAmazon = 1, ArrowFeature = 2 };
+
+        // 每方视角的第一层输出
+        struct Accumulator
+        {
+            int16_t values[2][HIDDEN]; // [视角玩家][隐藏单元]
+        };
+
+        Network()
+            : featureWeights(static_cast<size_t>(FEATURES) * HIDDEN, 0),
+              featureBias(HIDDEN, 0),
+              outputWeights(2 * HIDDEN, 0)
+        {
+        }
+
+        static int FeatureIndex(Player perspective, FeatureKind kind, int sq)
+        {
+            if (perspective == Player::Black) sq ^= 0x38; // 上下翻转
+            return static_cast<int>(kind) * SQUARE_COUNT + sq;
+        }
+
+        // 从局面完整计算累加器
+        void Refresh(const Position& pos, Accumulator& acc) const
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                Player persp = static_cast<Player>(side);
+                int16_t* v = acc.values[side];
+                std::copy(featureBias.begin(), featureBias.end(), v);
+                Bitboard own = pos.AmazonsOf(persp);
+                Bitboard opp = pos.AmazonsOf(Opponent(persp));
+                Bitboard arrows = pos.arrows;
+                while (own) AddColumn(v, FeatureIndex(persp, OwnAmazon, PopLowest(own)));
+                while (opp) AddColumn(v, FeatureIndex(persp, OppAmazon, PopLowest(opp)));
+                while (arrows) AddColumn(v, FeatureIndex(persp, ArrowFeature, PopLowest(arrows)));
+            }
+        }
+
+        // 增量更新：mover 走了 m（from->to 并在 arrow 放箭），由 parent 得到 child
+        void Update(const Accumulator& parent, Accumulator& child, Player mover, const Move& m) const
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                Player persp = static_cast<Player>(side);
+                FeatureKind kind = (persp == mover) ? OwnAmazon : OppAmazon;
+                ApplyDelta(parent.values[side], child.values[side],
+                           FeatureIndex(persp, kind, m.from),
+                           FeatureIndex(persp, kind, m.to),
+                           FeatureIndex(persp, ArrowFeature, m.arrow));
+            }
+        }
+
+        // 输出（走子方视角），单位与开放度差相近
+        int Evaluate(const Accumulator& acc, Player sideToMove) const
+        {
+            int stm = static_cast<int>(sideToMove);
+            int32_t sum = outputBias
+                + ClippedDot(acc.values[stm], &outputWeights[0])
+                + ClippedDot(acc.values[stm ^ 1], &outputWeights[HIDDEN]);
+            return sum / outputDivisor;
+        }
+
+        // 当前编译所用的整数内核
+        static const char* KernelName()
+        {
+#if defined(AMAZON_NN_AVX2)
+            return "avx2";
+#elif defined(AMAZON_NN_SSE2)
+            return "sse2";
+#else
+            return "scalar";
+#endif
+        }
+
+        // 权重文件（小端）：magic, version, hidden, 第一层权重 [FEATURES][HIDDEN] int16,
+        // 第一层偏置 [HIDDEN] int16, 输出权重 [2*HIDDEN] int16, 输出偏置 int32, 输出除数 int32
+        bool Load(const std::string& path)
+        {
+            std::ifstream ifs(path, std::ios::binary);
+            if (!ifs.is_open()) return false;
+            uint32_t header[3];
+            if (!ifs.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+            if (header[0] != FILE_MAGIC || header[1] != FILE_VERSION || header[2] != HIDDEN) return false;
+            Network n;
+            int32_t tail[2];
+            if (!ifs.read(reinterpret_cast<char*>(n.featureWeights.data()), n.featureWeights.size() * sizeof(int16_t))
+                || !ifs.read(reinterpret_cast<char*>(n.featureBias.data()), n.featureBias.size() * sizeof(int16_t))
+                || !ifs.read(reinterpret_cast<char*>(n.outputWeights.data()), n.outputWeights.size() * sizeof(int16_t))
+                || !ifs.read(reinterpret_cast<char*>(tail), sizeof(tail)))
+                return false;
+            if (tail[1] <= 0) return false;
+            n.outputBias = tail[0];
+            n.outputDivisor = tail[1];
+            *this = std::move(n);
+            return true;
+        }
+
+        bool Save(const std::string& path) const
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            if (!ofs.is_open()) return false;
+            uint32_t header[3] = { FILE_MAGIC, FILE_VERSION, static_cast<uint32_t>(HIDDEN) };
+            int32_t tail[2] = { outputBias, outputDivisor };
+            ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+            ofs.write(reinterpret_cast<const char*>(featureWeights.data()), featureWeights.size() * sizeof(int16_t));
+            ofs.write(reinterpret_cast<const char*>(featureBias.data()), featureBias.size() * sizeof(int16_t));
+            ofs.write(reinterpret_cast<const char*>(outputWeights.data()), outputWeights.size() * sizeof(int16_t));
+            ofs.write(reinterpret_cast<const char*>(tail), sizeof(tail));
+            return static_cast<bool>(ofs);
+        }
+
+        // 小幅随机权重（用于基准测试与训练初始化）
+        void Randomize(uint64_t seed)
+        {
+            auto next = [&seed]() { return static_cast<int16_t>(static_cast<int>(SplitMix64(seed) % 33) - 16); };
+            for (auto& w : featureWeights) w = next();
+            for (auto& b : featureBias) b = static_cast<int16_t>(next() + 32);
+            for (auto& w : outputWeights) w = next();
+            outputBias = 0;
+            outputDivisor = 256;
+        }
+
+    private:
+        const int16_t* Column(int feature) const { return &featureWeights[static_cast<size_t>(feature) * HIDDEN]; }
+
+        void AddColumn(int16_t* v, int feature) const
+        {
+            const int16_t* w = Column(feature);
+#if defined(AMAZON_NN_AVX2)
+            for (int i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+                x = _mm256_add_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + i), x);
+            }
+#elif defined(AMAZON_NN_SSE2)
+            for (int i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+                x = _mm_add_epi16(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i), x);
+            }
+#else
+            for (int i = 0; i < HIDDEN; ++i) v[i] = static_cast<int16_t>(v[i] + w[i]);
+#endif
+        }
+
+        // child = parent - W[sub] + W[add1] + W[add2]
+        void ApplyDelta(const int16_t* parent, int16_t* child, int sub, int add1, int add2) const
+        {
+            const int16_t* ws = Column(sub);
+            const int16_t* wa = Column(add1);
+            const int16_t* wb = Column(add2);
+#if defined(AMAZON_NN_AVX2)
+            for (int i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(parent + i));
+                v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ws + i)));
+                v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wa + i)));
+                v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(child + i), v);
+            }
+#elif defined(AMAZON_NN_SSE2)
+            for (int i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(parent + i));
+                v = _mm_sub_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ws + i)));
+                v = _mm_add_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(wa + i)));
+                v = _mm_add_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(wb + i)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(child + i), v);
+            }
+#else
+            for (int i = 0; i < HIDDEN; ++i)
+                child[i] = static_cast<int16_t>(parent[i] - ws[i] + wa[i] + wb[i]);
+#endif
+        }
+
+        // sum(clamp(v, 0, CLIP) * w)
+        static int32_t ClippedDot(const int16_t* v, const int16_t* w)
+        {
+#if defined(AMAZON_NN_AVX2)
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i clip = _mm256_set1_epi16(CLIP);
+            __m256i sum = _mm256_setzero_si256();
+            for (int i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+                x = _mm256_min_epi16(_mm256_max_epi16(x, zero), clip);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i))));
+            }
+            __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+            return _mm_cvtsi128_si32(s);
+#elif defined(AMAZON_NN_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i clip = _mm_set1_epi16(CLIP);
+            __m128i sum = _mm_setzero_si128();
+            for (int i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+                x = _mm_min_epi16(_mm_max_epi16(x, zero), clip);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i))));
+            }
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return _mm_cvtsi128_si32(sum);
+#else
+            const int32_t clip = CLIP;
+            int32_t sum = 0;
+            for (int i = 0; i < HIDDEN; ++i)
+            {
+                int32_t x = std::min<int32_t>(std::max<int32_t>(v[i], 0), clip);
+                sum += x * w[i];
+            }
+            return sum;
+#endif
+        }
+
+        std::vector<int16_t> featureWeights;
+        std::vector<int16_t> featureBias;
+        std::vector<int16_t> outputWeights;
+        int32_t outputBias = 0;
+        int32_t outputDivisor = 1;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include <string>
+#include "AmazonBitboard.h"
+
+// 局面记号（类似国际象棋 FEN），直接描述一个局面，载入时无需从初始局面重放：
+//   "<第 0 行>/<第 1 行>/.../<第 7 行> <w|b>"
+// 行按 y = 0..7 排列，每行按 x = 0..7：'W' 白方 Amazon，'B' 黑方 Amazon，'X' 箭，数字 1-8 为连续空格数；
+// 最后一段为走子方。即格号（y * 8 + x）从小到大的顺序。初始局面：
+//   2W2W2/8/W6W/8/8/B6B/8/2B2B2 w
+// 每方最多 MAX_AMAZONS_PER_SIDE 个 Amazon（走法生成按此上限分配 MoveList）。
+
+namespace AmazonChess
+{
+    static constexpr int MAX_AMAZONS_PER_SIDE = 4;
+    static const char* const START_FEN = "2W2W2/8/W6W/8/8/B6B/8/2B2B2 w";
+
+    inline std::string PositionToFen(const Position& pos)
+    {
+        std::string s;
+        for (int y = 0; y < BOARD_SIZE; ++y)
+        {
+            if (y > 0) s += '/';
+            int empty = 0;
+            for (int x = 0; x < BOARD_SIZE; ++x)
+            {
+                PieceType t = pos.PieceAt(SquareOf(x, y));
+                if (t == PieceType::None)
+                {
+                    ++empty;
+                    continue;
+                }
+                if (empty > 0) s += static_cast<char>('0' + empty);
+                empty = 0;
+                s += t == PieceType::WhiteAmazon ? 'W' : t == PieceType::BlackAmazon ? 'B' : 'X';
+            }
+            if (empty > 0) s += static_cast<char>('0' + empty);
+        }
+        s += pos.sideToMove == Player::White ? " w" : " b";
+        return s;
+    }
+
+    // 解析棋盘段与走子方段（分别为 board、side）；失败时 error 为原因
+    inline bool ParseFen(const std::string& board, const std::string& side, Position& out, std::string& error)
+    {
+        Position pos;
+        int x = 0, y = 0;
+        int counts[2] = { 0, 0 };
+        for (char c : board)
+        {
+            if (c == '/')
+            {
+                if (x != BOARD_SIZE)
+                {
+                    error = "row " + std::to_string(y) + " does not have 8 squares";
+                    return false;
+                }
+                if (++y >= BOARD_SIZE)
+                {
+                    error = "more than 8 rows";
+                    return false;
+                }
+                x = 0;
+            }
+            else if (c >= '1' && c <= '8')
+            {
+                x += c - '0';
+                if (x > BOARD_SIZE)
+                {
+                    error = "row " + std::to_string(y) + " is too long";
+                    return false;
+                }
+            }
+            else if (c == 'W' || c == 'B' || c == 'X')
+            {
+                if (x >= BOARD_SIZE)
+                {
+                    error = "row " + std::to_string(y) + " is too long";
+                    return false;
+                }
+                if (c != 'X' && ++counts[c == 'W' ? 0 : 1] > MAX_AMAZONS_PER_SIDE)
+                {
+                    error = "too many amazons";
+                    return false;
+                }
+                pos.Put(c == 'W' ? PieceType::WhiteAmazon : c == 'B' ? PieceType::BlackAmazon : PieceType::Arrow, SquareOf(x, y));
+                ++x;
+            }
+            else
+            {
+                error = std::string("bad character '") + c + "'";
+                return false;
+            }
+        }
+        if (y != BOARD_SIZE - 1 || x != BOARD_SIZE)
+        {
+            error = "board must have 8 rows of 8 squares";
+            return false;
+        }
+        if (side != "w" && side != "b")
+        {
+            error = "side to move must be w or b";
+            return false;
+        }
+        pos.SetSideToMove(side == "w" ? Player::White : Player::Black);
+        out = pos;
+        return true;
+    }
+
+    // 解析完整记号 "<board> <side>"
+    inline bool ParseFen(const std::string& fen, Position& out, std::string& error)
+    {
+        size_t space = fen.find(' ');
+        if (space == std::string::npos)
+        {
+            error = "missing side to move";
+            return false;
+        }
+        size_t sideEnd = fen.find_first_of(" \t\r\n", space + 1);
+        if (sideEnd != std::string::npos && fen.find_first_not_of(" \t\r\n", sideEnd) != std::string::npos)
+        {
+            error = "unexpected text after side to move";
+            return false;
+        }
+        return ParseFen(fen.substr(0, space), fen.substr(space + 1, sideEnd == std::string::npos ? std::string::npos : sideEnd - space - 1), out, error);
+    }
+
+    // 两个局面的棋子与走子方是否相同
+    inline bool SamePosition(const Position& a, const Position& b)
+    {
+        return a.amazons[0] == b.amazons[0] && a.amazons[1] == b.amazons[1] && a.arrows == b.arrows && a.sideToMove == b.sideToMove;
+    }
+} // namespace AmazonChess
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+#include "AmazonNotation.h"
+
+// 无界面引擎文本协议（每行一条命令，空格分隔），供 AmazonEngine 与驱动它的工具共用。
+// 走法记号沿用 GetBestMove 的编码："<movePacked>:<arrowIndex>"，
+//   movePacked = from * 64 + to，square = y * 8 + x，例如 170:46 即 (2,0) -> (2,5)，箭 (6,5)。
+//
+// 命令（-> 为引擎输出）：
+//   hello                                   -> id name ... / id protocol <n> / hellook
+//   isready                                 -> readyok（搜索中也立即应答）
+//   newgame                                 清空置换表（及求解模式的证明数表）
+//   setoption <name> <value>                hash <mb> / eval <file> / net <file>
+//                                           置换表内存（AmazonTableMemory.h，重建置换表）：hugepages / numa <on|off>
+//                                           以及搜索选项（SetSearchOption）：lmr / verify / futility / prefetch <on|off>，
+//                                           lmr-min-depth / lmr-full-moves / futility-margin <n>
+//                                           求解模式（AmazonDfpn.h）：solver-nodes <n>（0 = 关闭）/ solver-arrows <n> / solver-hash <mb>
+//   position startpos [w|b] [moves <m> ...] 初始局面（默认白方先走），随后依次走子
+//   position fen <board> <w|b> [moves <m> ...]
+//                                           直接给出局面（记号见 AmazonNotation.h），随后依次走子
+//   go [depth d] [nodes n] [movetime ms] [infinite] [wtime ms btime ms [winc ms] [binc ms] [movestogo n]]
+//                                           给出双方时钟时由走子方的剩余时间 / 加时分配本手用时（AmazonTimeManager.h）
+//                                           -> info depth d score s nodes n time ms nps x move m（每轮迭代）
+//                                           -> bestmove <m> | bestmove none
+//                                           求解模式开启且箭数不少于 solver-arrows 时先做胜负证明，证明必胜即直接给出必胜的一手
+//   go solve [nodes n] [movetime ms]        只做胜负证明（节点数缺省取 solver-nodes）
+//                                           -> info solve <win|loss|unknown> nodes n time ms pn x dn y move <m|none>
+//                                           -> bestmove <必胜的一手> | bestmove none
+//   stop                                    中止当前搜索（随即输出 bestmove）
+//   quit
+// 不认识的命令输出 "error <原因>"，不影响后续命令。
+
+namespace AmazonChess
+{
+    static constexpr int PROTOCOL_VERSION = 1;
+
+    inline std::string MoveToToken(const Move& m)
+    {
+        return std::to_string(m.MovePacked()) + ":" + std::to_string(m.ArrowIndex());
+    }
+
+    // 解析 "<movePacked>:<arrowIndex>"（只检查编码范围，不检查合法性）
+    inline bool ParseMoveToken(const std::string& token, Move& out)
+    {
+        size_t colon = token.find(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 >= token.size()) return false;
+        char* end = nullptr;
+        long packed = std::strtol(token.c_str(), &end, 10);
+        if (end != token.c_str() + colon) return false;
+        long arrow = std::strtol(token.c_str() + colon + 1, &end, 10);
+        if (*end != '\0') return false;
+        if (packed < 0 || packed >= SQUARE_COUNT * SQUARE_COUNT || arrow < 0 || arrow >= SQUARE_COUNT) return false;
+        out = MoveOf(static_cast<int>(packed / SQUARE_COUNT), static_cast<int>(packed % SQUARE_COUNT), static_cast<int>(arrow));
+        return true;
+    }
+
+    // 局面命令中 "moves" 之前的部分：初始局面用 "startpos <w|b>"，其余用 "fen <board> <side>"
+    inline std::string PositionSetupTokens(const Position& start)
+    {
+        Position initial = Position::Initial();
+        initial.SetSideToMove(start.sideToMove);
+        if (SamePosition(start, initial)) return std::string("startpos ") + (start.sideToMove == Player::White ? "w" : "b");
+        return "fen " + PositionToFen(start);
+    }
+
+    // 从 t[i] 起解析 "startpos [w|b] [moves <m> ...]" 或 "fen <board> <side> [moves <m> ...]"，一直读到末尾；
+    // 失败时 error 为原因
+    inline bool ParsePosition(const std::vector<std::string>& t, size_t i, Position& out, std::string& error)
+    {
+        Position pos = Position::Initial();
+        if (i < t.size() && t[i] == "fen")
+        {
+            if (i + 2 >= t.size())
+            {
+                error = "fen needs board and side to move";
+                return false;
+            }
+            if (!ParseFen(t[i + 1], t[i + 2], pos, error)) return false;
+            i += 3;
+        }
+        else if (i < t.size() && t[i] == "startpos")
+        {
+            ++i;
+            if (i < t.size() && (t[i] == "w" || t[i] == "b"))
+            {
+                pos.SetSideToMove(t[i] == "w" ? Player::White : Player::Black);
+                ++i;
+            }
+        }
+        else
+        {
+            error = "position must start with startpos or fen";
+            return false;
+        }
+        if (i < t.size() && t[i] == "moves")
+        {
+            for (++i; i < t.size(); ++i)
+            {
+                Move m;
+                if (!ParseMoveToken(t[i], m) || !IsLegalMove(pos, m))
+                {
+                    error = "illegal move " + t[i];
+                    return false;
+                }
+                pos.Play(m);
+            }
+        }
+        else if (i < t.size())
+        {
+            error = "unexpected token " + t[i];
+            return false;
+        }
+        out = pos;
+        return true;
+    }
+
+    inline std::vector<std::string> SplitTokens(const std::string& line)
+    {
+        std::vector<std::string> tokens;
+        std::istringstream iss(line);
+        std::string t;
+        while (iss >> t) tokens.push_back(t);
+        return tokens;
+    }
+} // namespace AmazonChess
@@ -0,0 +1,191 @@
+﻿#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+#include "AmazonNotation.h"
+
+// 棋谱（.acp）读写，与平台无关的窄字符版本，供无界面工具使用。
+// 每行一手："W 0,2 2,0 3,3"（玩家 from to arrow），终局一手在末尾附加 '*'。
+// 不从初始局面开始的对局在第一行给出起始局面："FEN <board> <side>"（见 AmazonNotation.h）。
+// 与 Game::SaveToFile / LoadFromFile 使用的格式完全相同。
+
+namespace AmazonChess
+{
+    struct RecordedMove
+    {
+        Player player = Player::White;
+        Move move = MoveOf(0, 0, 0);
+    };
+
+    struct GameRecord
+    {
+        std::vector<RecordedMove> moves;
+        bool finished = false; // 最后一手带有 '*'
+        Position start = Position::Initial(); // 起始局面（走子方以第一手的玩家为准）
+    };
+
+    // 去掉 UTF-8 BOM 与行尾空白
+    inline void TrimRecordLine(std::string& line)
+    {
+        if (line.size() >= 3 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+    }
+
+    // 起始局面行 "FEN <board> <side>"
+    inline bool IsSetupLine(const std::string& line)
+    {
+        return line.compare(0, 4, "FEN ") == 0;
+    }
+
+    inline bool ParseSetupLine(std::string line, Position& out)
+    {
+        TrimRecordLine(line);
+        std::string error;
+        return IsSetupLine(line) && ParseFen(line.substr(4), out, error);
+    }
+
+    inline std::string FormatSetupLine(const Position& start)
+    {
+        return "FEN " + PositionToFen(start);
+    }
+
+    // 起始局面是否需要写出 FEN 行（初始局面的走子方由第一手决定，不必写出）
+    inline bool HasCustomStart(const GameRecord& record)
+    {
+        const Position initial = Position::Initial();
+        return record.start.amazons[0] != initial.amazons[0] || record.start.amazons[1] != initial.amazons[1]
+            || record.start.arrows != initial.arrows;
+    }
+
+    // 解析 "x,y"
+    inline bool ParseSquare(const std::string& s, int& square)
+    {
+        size_t comma = s.find(',');
+        if (comma == std::string::npos || comma == 0 || comma + 1 >= s.size()) return false;
+        int x = 0, y = 0;
+        for (size_t i = 0; i < comma; ++i)
+        {
+            if (s[i] < '0' || s[i] > '9') return false;
+            x = x * 10 + (s[i] - '0');
+        }
+        for (size_t i = comma + 1; i < s.size(); ++i)
+        {
+            if (s[i] < '0' || s[i] > '9') return false;
+            y = y * 10 + (s[i] - '0');
+        }
+        if (x >= BOARD_SIZE || y >= BOARD_SIZE) return false;
+        square = SquareOf(x, y);
+        return true;
+    }
+
+    inline std::string SquareToString(int square)
+    {
+        std::string s;
+        s += static_cast<char>('0' + square % BOARD_SIZE);
+        s += ',';
+        s += static_cast<char>('0' + square / BOARD_SIZE);
+        return s;
+    }
+
+    // "from to arrow"（不含玩家标记）
+    inline std::string MoveToString(const Move& m)
+    {
+        return SquareToString(m.from) + " " + SquareToString(m.to) + " " + SquareToString(m.arrow);
+    }
+
+    // 解析一行记谱；空行返回 false 且 isEmpty = true
+    inline bool ParseRecordLine(std::string line, RecordedMove& out, bool& gameEnd, bool& isEmpty)
+    {
+        gameEnd = false;
+        isEmpty = false;
+        TrimRecordLine(line);
+        if (line.empty()) { isEmpty = true; return false; }
+        if (line.back() == '*') { gameEnd = true; line.pop_back(); }
+
+        std::string tokens[4];
+        size_t pos = 0;
+        for (int t = 0; t < 4; ++t)
+        {
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+            size_t end = pos;
+            while (end < line.size() && line[end] != ' ' && line[end] != '\t') ++end;
+            if (end == pos) return false;
+            tokens[t] = line.substr(pos, end - pos);
+            pos = end;
+        }
+
+        // 与 Game::LoadFromFile 相同：非 "W" 即视为黑方
+        out.player = (tokens[0] == "W") ? Player::White : Player::Black;
+        int from, to, arrow;
+        if (!ParseSquare(tokens[1], from) || !ParseSquare(tokens[2], to) || !ParseSquare(tokens[3], arrow)) return false;
+        out.move = MoveOf(from, to, arrow);
+        return true;
+    }
+
+    inline std::string FormatRecordLine(const RecordedMove& rm, bool gameEnd)
+    {
+        std::string s = (rm.player == Player::White) ? "W " : "B ";
+        s += MoveToString(rm.move);
+        if (gameEnd) s += '*';
+        return s;
+    }
+
+    // 读取整个棋谱文件；遇到格式错误返回 false
+    inline bool LoadRecord(const std::string& path, GameRecord& out)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open()) return false;
+        out.moves.clear();
+        out.finished = false;
+        out.start = Position::Initial();
+        std::string line;
+        bool first = true;
+        while (std::getline(ifs, line))
+        {
+            std::string trimmed = line;
+            TrimRecordLine(trimmed);
+            if (trimmed.empty()) continue;
+            if (first && IsSetupLine(trimmed))
+            {
+                first = false;
+                if (!ParseSetupLine(trimmed, out.start)) return false;
+                continue;
+            }
+            first = false;
+            RecordedMove rm;
+            bool gameEnd, isEmpty;
+            if (!ParseRecordLine(line, rm, gameEnd, isEmpty))
+            {
+                if (isEmpty) continue;
+                return false;
+            }
+            out.moves.push_back(rm);
+            if (gameEnd) { out.finished = true; break; }
+        }
+        return true;
+    }
+
+    inline bool SaveRecord(const std::string& path, const GameRecord& record)
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        if (!ofs.is_open()) return false;
+        if (HasCustomStart(record)) ofs << FormatSetupLine(record.start) << "\n";
+        for (size_t i = 0; i < record.moves.size(); ++i)
+        {
+            bool last = record.finished && i + 1 == record.moves.size();
+            ofs << FormatRecordLine(record.moves[i], last) << "\n";
+        }
+        return static_cast<bool>(ofs);
+    }
+
+    // 在 pos 上执行记谱中的一手（与 Game 重放一致：走子方取记谱行中的玩家），非法时返回 false
+    inline bool ApplyRecordedMove(Position& pos, const RecordedMove& rm)
+    {
+        pos.SetSideToMove(rm.player);
+        if (!IsLegalMove(pos, rm.move)) return false;
+        pos.Play(rm.move);
+        return true;
+    }
+} // namespace AmazonChess
@@ -0,0 +1,640 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+#include "AmazonEvalParams.h"
+#include "AmazonNetwork.h"
+#include "AmazonSearchStats.h"
+#include "AmazonTableMemory.h"
+#include "AmazonTimeManager.h"
+
+// 搜索引擎：迭代加深 alpha-beta + 置换表。
+// 每个 Engine 实例拥有自己的置换表与走法缓冲区，可在各线程中独立使用（一个线程一个实例）。
+
+namespace AmazonChess
+{
+    // 分值约定：以走子方视角，静态评估 = 己方开放度 - 对方开放度；
+    // 无棋可走（被封死）为负的 MATE_SCORE，ply 越近绝对值越大
+    static constexpr int MATE_SCORE = 30000;
+    static constexpr int MATE_BOUND = MATE_SCORE - 1000;
+    static constexpr int INFINITE_SCORE = 32000;
+    static constexpr int MAX_PLY = SQUARE_COUNT - 8; // 除双方 8 个 Amazon 外至多 56 个空格，每手占一格，即最多 56 手
+
+    // 静态评估（走子方视角）。走子方无路可走时返回失败分
+    inline int Evaluate(const Position& pos, int ply)
+    {
+        int mine = Mobility(pos, pos.sideToMove);
+        if (mine == 0) return -MATE_SCORE + ply;
+        return mine - Mobility(pos, Opponent(pos.sideToMove));
+    }
+
+    // 参数化静态评估（走子方视角），非失败局面的分值限制在杀棋分值区间以内
+    inline int Evaluate(const Position& pos, int ply, const EvalParams& params)
+    {
+        if (!HasAnyMove(pos)) return -MATE_SCORE + ply;
+        return std::max(-MATE_BOUND + 1, std::min(MATE_BOUND - 1, params.Score(pos)));
+    }
+
+    // 置换表。每个槽位为两个 64 位原子字（relaxed 读写，无锁）：
+    // data 为走法 / 分值 / 深度 / 界与世代，check = key ^ data；读取时两字不一致（被其它线程并发改写）即视为未命中，
+    // 因此可由多个 Engine 在不同线程中共享。
+    // 每次搜索开始时世代加一（NewSearch），表本身不清空：上一手搜索中已展开的、新根局面下的子树条目原样保留，
+    // 其余条目不再被访问，随后续写入逐步覆盖，无需逐项回收
+    class TranspositionTable
+    {
+    public:
+        enum Bound : uint8_t { BoundNone = 0, BoundUpper = 1, BoundLower = 2, BoundExact = 3 };
+
+        struct Entry
+        {
+            uint64_t key = 0;
+            uint32_t move = NULL_MOVE_CODE;
+            int16_t score = 0;
+            int8_t depth = -1;
+            uint8_t bound = BoundNone;
+            uint8_t generation = 0;   // 写入时的搜索世代（GENERATION_MASK 以内循环）
+        };
+
+        // 内存按 memory 的选项分配（大页 / NUMA 交错，见 AmazonTableMemory.h）
+        explicit TranspositionTable(size_t megabytes, const TableMemoryOptions& memoryOptions = TableMemoryOptions())
+        {
+            size_t count = 1;
+            size_t wanted = std::max<size_t>(1, megabytes) * 1024 * 1024 / sizeof(Slot);
+            while (count * 2 <= wanted) count *= 2;
+            void* raw = memory.Allocate(count * sizeof(Slot), memoryOptions);
+            if (!raw) throw std::bad_alloc();
+            slots = static_cast<Slot*>(raw);
+            for (size_t i = 0; i < count; ++i) new (&slots[i]) Slot();
+            mask = count - 1;
+        }
+
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        void Clear()
+        {
+            for (size_t i = 0; i <= mask; ++i)
+            {
+                slots[i].check.store(0, std::memory_order_relaxed);
+                slots[i].data.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        size_t SizeInBytes() const { return (mask + 1) * sizeof(Slot); }
+        bool HugePagesApplied() const { return memory.HugePagesApplied(); }
+        bool InterleaveApplied() const { return memory.InterleaveApplied(); }
+
+        // 预取 key 所在的槽：走完一手、尚未进入子节点时调用，子节点探查时该缓存行多半已经到位
+        void Prefetch(uint64_t key) const
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(reinterpret_cast<const char*>(&slots[key & mask]), _MM_HINT_T0);
+#elif defined(__GNUC__)
+            __builtin_prefetch(&slots[key & mask]);
+#else
+            (void)key;
+#endif
+        }
+
+        static constexpr uint8_t GENERATION_MASK = 0x3F;
+
+        // 开始新一次搜索，返回本次写入使用的世代
+        uint8_t NewSearch()
+        {
+            return static_cast<uint8_t>((generation.fetch_add(1, std::memory_order_relaxed) + 1) & GENERATION_MASK);
+        }
+
+        bool Probe(uint64_t key, Entry& out) const
+        {
+            const Slot& slot = slots[key & mask];
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((slot.check.load(std::memory_order_relaxed) ^ data) != key) return false;
+            out = Unpack(key, data);
+            return out.bound != BoundNone;
+        }
+
+        // 深度优先替换：不同局面直接覆盖，同一局面仅在深度不更浅时覆盖；条目标记为表的当前世代
+        void Store(uint64_t key, int depth, int score, Bound bound, uint32_t move)
+        {
+            Store(key, depth, score, bound, move, CurrentGeneration());
+        }
+
+        // 同上，条目标记为给定世代（搜索写入时传 NewSearch 的返回值：表被多个会话共用时，
+        // 别的会话开始新搜索不会改变本次搜索写入的世代）
+        void Store(uint64_t key, int depth, int score, Bound bound, uint32_t move, uint8_t searchGeneration)
+        {
+            Slot& slot = slots[key & mask];
+            uint64_t old = slot.data.load(std::memory_order_relaxed);
+            if ((slot.check.load(std::memory_order_relaxed) ^ old) == key)
+            {
+                Entry e = Unpack(key, old);
+                if (e.bound != BoundNone)
+                {
+                    if (depth < e.depth && bound != BoundExact) return;
+                    if (move == NULL_MOVE_CODE) move = e.move;
+                }
+            }
+            uint64_t data = static_cast<uint64_t>(move)
+                | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 32
+                | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+                | static_cast<uint64_t>(bound | (searchGeneration & GENERATION_MASK) << 2) << 56;
+            slot.data.store(data, std::memory_order_relaxed);
+            slot.check.store(key ^ data, std::memory_order_relaxed);
+        }
+
+        // 逐个访问有效条目（导出到分析缓存等）；与搜索并发调用时正在改写的槽校验不过，被跳过
+        template <typename F>
+        void ForEach(F f) const
+        {
+            for (size_t i = 0; i <= mask; ++i)
+            {
+                uint64_t data = slots[i].data.load(std::memory_order_relaxed);
+                if (!data) continue;
+                Entry e = Unpack(slots[i].check.load(std::memory_order_relaxed) ^ data, data);
+                if ((e.key & mask) == i && e.bound != BoundNone) f(e);
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        static Entry Unpack(uint64_t key, uint64_t data)
+        {
+            Entry e;
+            e.key = key;
+            e.move = static_cast<uint32_t>(data);
+            e.score = static_cast<int16_t>(data >> 32);
+            e.depth = static_cast<int8_t>(data >> 48);
+            e.bound = static_cast<uint8_t>(data >> 56) & 3;
+            e.generation = static_cast<uint8_t>(data >> 58);
+            return e;
+        }
+
+        uint8_t CurrentGeneration() const
+        {
+            return static_cast<uint8_t>(generation.load(std::memory_order_relaxed) & GENERATION_MASK);
+        }
+
+        TableMemory memory;
+        Slot* slots = nullptr; // 位于 memory 中；Slot 可平凡析构，无需逐个析构
+        size_t mask = 0;
+        std::atomic<uint32_t> generation{ 0 };
+    };
+
+    // 搜索限制：深度必填，节点数 / 时间为 0 表示不限制
+    struct SearchLimits
+    {
+        int maxDepth = 1;
+        uint64_t maxNodes = 0;
+        int64_t maxTimeMs = 0;
+        const std::atomic<bool>* cancel = nullptr; // 可选：由调用方置位以中止本次搜索
+        TimeBudget time;                           // 可选：按对局时钟分配的本手软 / 硬限制（AllocateTime）
+    };
+
+    struct SearchResult
+    {
+        bool hasMove = false;
+        Move bestMove = MoveOf(0, 0, 0);
+        int score = 0;
+        int depth = 0;          // 完整完成的迭代深度
+        uint64_t nodes = 0;
+        double timeMs = 0.0;
+        double carriedOver = 0.0; // 内部节点的置换表探测中，命中此前搜索所存条目的比例（跨手复用）
+    };
+
+    // 选择性搜索选项，可在两次搜索之间修改。默认全部关闭，此时与完整宽度搜索的结果完全一致
+    struct SearchOptions
+    {
+        // 后序走法削减（LMR）：剩余深度 >= lmrMinDepth 时，先按一层开放度差先验给走法排序（置换表走法仍在最前，
+        // 其余按走完后对方的 Evaluate 从低到高），排序第 lmrFullMoves 手之后的走法少搜 1 层，第 lmrFullMoves * 8 手之后少搜 2 层。
+        // 生成顺序按格子排列，与走法好坏无关，不排序时“靠后”的走法只是任意一部分，削减等于随机少搜
+        bool lateMoveReductions = false;
+        int lmrMinDepth = 2;
+        int lmrFullMoves = 16;
+        // 削减搜索以零窗口进行，超过 alpha 时以完整深度、完整窗口复核；关闭时直接以完整窗口做削减搜索并采用其结果
+        bool verifyReductions = true;
+        // 前沿（剩余深度 1）剪枝：静态评估 + futilityMargin 不超过 alpha，或减去 futilityMargin 仍不低于 beta 时
+        // 不再展开，直接返回静态评估
+        bool futilityPruning = false;
+        int futilityMargin = 25;
+        // 走完一手即预取子局面的置换表槽（只影响速度，不影响搜索结果）
+        bool ttPrefetch = true;
+    };
+
+    // 按名称设置一个选项（供命令行 / 协议使用）：lmr、lmr-min-depth、lmr-full-moves、verify、futility、futility-margin、prefetch；
+    // 开关取 on / off（或 1 / 0）。名称或取值无效时返回 false 且不修改 options
+    inline bool SetSearchOption(SearchOptions& options, const std::string& name, const std::string& value)
+    {
+        bool on = value == "on" || value == "1" || value == "true";
+        bool off = value == "off" || value == "0" || value == "false";
+        char* end = nullptr;
+        long number = std::strtol(value.c_str(), &end, 10);
+        bool isNumber = !value.empty() && *end == '\0' && number >= 0 && number <= 10000;
+        if (name == "lmr" && (on || off)) options.lateMoveReductions = on;
+        else if (name == "verify" && (on || off)) options.verifyReductions = on;
+        else if (name == "futility" && (on || off)) options.futilityPruning = on;
+        else if (name == "prefetch" && (on || off)) options.ttPrefetch = on;
+        else if (name == "lmr-min-depth" && isNumber) options.lmrMinDepth = std::max(2, static_cast<int>(number));
+        else if (name == "lmr-full-moves" && isNumber) options.lmrFullMoves = static_cast<int>(number);
+        else if (name == "futility-margin" && isNumber) options.futilityMargin = static_cast<int>(number);
+        else return false;
+        return true;
+    }
+
+    class Engine
+    {
+    public:
+        explicit Engine(size_t ttMegabytes = 16)
+            : Engine(std::make_shared<TranspositionTable>(ttMegabytes))
+        {
+        }
+
+        // 与其它 Engine 共享置换表（各自在不同线程中搜索）
+        explicit Engine(std::shared_ptr<TranspositionTable> sharedTable)
+            : tt(std::move(sharedTable)), moveLists(MAX_PLY + 1), accumulators(MAX_PLY + 1)
+        {
+        }
+
+        // 使用神经网络评估叶节点；传入 nullptr 恢复开放度评估
+        void SetNetwork(std::shared_ptr<const Network> net) { network = std::move(net); }
+
+        // 使用参数化评估（权重文件见 AmazonEvalParams.h）；神经网络优先；传入 nullptr 恢复开放度评估
+        void SetEvalParams(std::shared_ptr<const EvalParams> params) { evalParams = std::move(params); }
+
+        void SetOptions(const SearchOptions& o) { options = o; }
+        const SearchOptions& Options() const { return options; }
+
+        // 每完成一轮迭代时回调（在搜索线程中调用），用于输出搜索进度
+        using InfoCallback = std::function<void(const SearchResult&)>;
+        void SetInfoCallback(InfoCallback callback) { infoCallback = std::move(callback); }
+
+        // 清空置换表（开始新对局时调用）
+        void NewGame() { tt->Clear(); }
+
+        TranspositionTable& Table() { return *tt; }
+        const TranspositionTable& Table() const { return *tt; }
+
+        // 请求中止当前搜索（可从其它线程调用）。Search 开始时会清除该请求，只对已在进行的搜索有效；
+        // 可能在搜索开始前就要取消时（如另一线程刚发起的搜索），应改用 SearchLimits::cancel
+        void Stop() { stopRequested.store(true, std::memory_order_relaxed); }
+
+        // 最近一次搜索的统计（未定义 AMAZON_SEARCH_STATS 时各计数保持为 0）
+        const SearchStats& LastStats() const { return stats; }
+
+        SearchResult Search(const Position& root, const SearchLimits& limits)
+        {
+            using Clock = std::chrono::steady_clock;
+            startTime = Clock::now();
+            this->limits = limits;
+            nodes = 0;
+            ttProbes = 0;
+            carriedHits = 0;
+            searchGeneration = tt->NewSearch();
+            aborted = false;
+            stopRequested.store(false, std::memory_order_relaxed);
+            AMAZON_STAT(stats.Reset());
+            AMAZON_STAT(stats.startUs = SteadyMicroseconds());
+            AMAZON_STAT(stats.memoryBytes = tt->SizeInBytes() + moveLists.size() * sizeof(MoveList) + accumulators.size() * sizeof(Network::Accumulator));
+
+            SearchResult result;
+            Position pos = root;
+            if (network) network->Refresh(pos, accumulators[0]);
+            MoveList& rootMoves = moveLists[0];
+            GenerateMoves(pos, rootMoves);
+            if (rootMoves.count == 0)
+            {
+                result.score = -MATE_SCORE;
+                result.timeMs = ElapsedMs();
+                AMAZON_STAT(stats.timeMs = result.timeMs);
+                return result;
+            }
+
+            result.hasMove = true;
+            result.bestMove = rootMoves[0];
+            TimeManager timeManager(limits.time);
+            int maxDepth = std::max(1, std::min(limits.maxDepth, MAX_PLY));
+            for (int depth = 1; depth <= maxDepth; ++depth)
+            {
+                Move iterationBest = rootMoves[0];
+                AMAZON_STAT(BeginIteration(depth));
+                int score = SearchRoot(pos, depth, iterationBest);
+                AMAZON_STAT(EndIteration(score, iterationBest));
+                if (aborted)
+                {
+                    // 第一层迭代被中止时仍采用已搜索部分中的最佳走法
+                    if (result.depth == 0 && iterationHasMove)
+                    {
+                        result.bestMove = iterationBest;
+                        result.score = score;
+                    }
+                    break;
+                }
+                result.bestMove = iterationBest;
+                result.score = score;
+                result.depth = depth;
+                if (infoCallback)
+                {
+                    result.nodes = nodes;
+                    result.timeMs = ElapsedMs();
+                    result.carriedOver = CarriedOver();
+                    infoCallback(result);
+                }
+
+                // 已确定胜负时无需继续加深
+                if (std::abs(score) >= MATE_BOUND) break;
+                if (!timeManager.ContinueAfterIteration(result.bestMove, rootMoves.count == 1, ElapsedMs())) break;
+            }
+
+            result.nodes = nodes;
+            result.timeMs = ElapsedMs();
+            result.carriedOver = CarriedOver();
+            AMAZON_STAT(stats.nodes = nodes);
+            AMAZON_STAT(stats.timeMs = result.timeMs);
+            return result;
+        }
+
+    private:
+#if AMAZON_SEARCH_STATS
+        void BeginIteration(int depth)
+        {
+            IterationStats it;
+            it.depth = depth;
+            it.startMs = ElapsedMs();
+            stats.iterations.push_back(it);
+        }
+
+        void EndIteration(int score, const Move& best)
+        {
+            IterationStats& it = stats.iterations.back();
+            it.timeMs = ElapsedMs() - it.startMs;
+            it.nodes = nodes;
+            it.score = score;
+            it.bestMove = best;
+            it.completed = !aborted;
+        }
+#endif
+
+        double CarriedOver() const
+        {
+            return ttProbes ? static_cast<double>(carriedHits) / static_cast<double>(ttProbes) : 0.0;
+        }
+
+        double ElapsedMs() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        }
+
+        // 在每个内部节点调用：内部节点的子节点数以千计，逐次检查的开销可以忽略
+        bool ShouldStop()
+        {
+            if (aborted) return true;
+            if (stopRequested.load(std::memory_order_relaxed)
+                || (limits.cancel && limits.cancel->load(std::memory_order_relaxed))
+                || (limits.maxNodes && nodes >= limits.maxNodes)
+                || (limits.maxTimeMs && ElapsedMs() >= static_cast<double>(limits.maxTimeMs))
+                || (limits.time.hardMs && ElapsedMs() >= static_cast<double>(limits.time.hardMs)))
+            {
+                aborted = true;
+            }
+            return aborted;
+        }
+
+        // 根节点：上一轮最佳走法排在最前；仅在严格更优时替换，保证同分时取枚举顺序最靠前者
+        int SearchRoot(Position& pos, int depth, Move& best)
+        {
+            MoveList& moves = moveLists[0];
+            if (depth > 1) PromoteMove(moves, best.Code());
+
+            iterationHasMove = false;
+            int alpha = -INFINITE_SCORE;
+            for (int i = 0; i < moves.count; ++i)
+            {
+                const Move m = moves[i];
+                ++nodes;
+                PlayMove(pos, m, 0);
+                if (options.ttPrefetch && depth > 1) tt->Prefetch(pos.hash);
+                int score = -Negamax(pos, depth - 1, -INFINITE_SCORE, -alpha, 1);
+                pos.Undo(m);
+                if (aborted) break;
+                if (score > alpha)
+                {
+                    alpha = score;
+                    best = m;
+                    iterationHasMove = true;
+                }
+            }
+            if (!aborted) tt->Store(pos.hash, depth, alpha, TranspositionTable::BoundExact, best.Code(), searchGeneration);
+            return alpha;
+        }
+
+        int Negamax(Position& pos, int depth, int alpha, int beta, int ply)
+        {
+            AMAZON_STAT(if (ply > stats.maxDepth) stats.maxDepth = ply);
+            if (depth <= 0 || ply >= MAX_PLY)
+            {
+                AMAZON_STAT(++stats.leafEvaluations);
+                return EvaluateLeaf(pos, ply);
+            }
+            if (ShouldStop()) return 0;
+
+            uint32_t ttMove = NULL_MOVE_CODE;
+            AMAZON_STAT(++stats.ttProbes);
+            TranspositionTable::Entry e;
+            ++ttProbes;
+            if (tt->Probe(pos.hash, e))
+            {
+                AMAZON_STAT(++stats.ttHits);
+                if (e.generation != searchGeneration) ++carriedHits;
+                ttMove = e.move;
+                if (e.depth >= depth)
+                {
+                    int s = ScoreFromTT(e.score, ply);
+                    if (e.bound == TranspositionTable::BoundExact
+                        || (e.bound == TranspositionTable::BoundLower && s >= beta)
+                        || (e.bound == TranspositionTable::BoundUpper && s <= alpha))
+                    {
+                        AMAZON_STAT(++stats.ttCutoffs);
+                        return s;
+                    }
+                }
+            }
+
+            // 前沿剪枝：静态评估加减余量后仍在窗口之外时不展开（走一手通常只会让己方更好，两侧都可剪）；
+            // 窗口在杀棋分附近时不剪，以免把杀棋误判为普通分值
+            if (options.futilityPruning && depth == 1 && (alpha > -MATE_BOUND || beta < MATE_BOUND))
+            {
+                int staticEval = EvaluateLeaf(pos, ply);
+                if ((alpha > -MATE_BOUND && staticEval + options.futilityMargin <= alpha)
+                    || (beta < MATE_BOUND && staticEval - options.futilityMargin >= beta))
+                {
+                    AMAZON_STAT(++stats.futilityPrunes);
+                    return staticEval;
+                }
+            }
+
+            MoveList& moves = moveLists[ply];
+            GenerateMoves(pos, moves);
+            if (moves.count == 0) return -MATE_SCORE + ply;
+            PromoteMove(moves, ttMove);
+
+            const int alphaOrig = alpha;
+            int bestScore = -INFINITE_SCORE;
+            uint32_t bestMove = NULL_MOVE_CODE;
+            const bool reduce = options.lateMoveReductions && depth >= options.lmrMinDepth;
+            if (reduce) OrderByPrior(pos, moves, ttMove == NULL_MOVE_CODE ? 0 : 1, ply);
+            for (int i = 0; i < moves.count; ++i)
+            {
+                const Move m = moves[i];
+                ++nodes;
+                PlayMove(pos, m, ply);
+                if (options.ttPrefetch && depth > 1) tt->Prefetch(pos.hash); // 剩余 1 层时子节点为叶，不探查置换表
+                int score;
+                int reduction = reduce ? LateMoveReduction(i) : 0;
+                if (reduction > 0)
+                {
+                    AMAZON_STAT(++stats.reducedSearches);
+                    if (options.verifyReductions)
+                    {
+                        score = -Negamax(pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+                        if (score > alpha && !aborted)
+                        {
+                            AMAZON_STAT(++stats.reductionResearches);
+                            score = -Negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+                        }
+                    }
+                    else score = -Negamax(pos, depth - 1 - reduction, -beta, -alpha, ply + 1);
+                }
+                else score = -Negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+                pos.Undo(m);
+                if (aborted) return 0;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestMove = m.Code();
+                    if (score > alpha)
+                    {
+                        alpha = score;
+                        if (alpha >= beta)
+                        {
+                            AMAZON_STAT(stats.RecordCutoff(i));
+                            break;
+                        }
+                    }
+                }
+            }
+
+            TranspositionTable::Bound bound = bestScore >= beta ? TranspositionTable::BoundLower
+                : (bestScore > alphaOrig ? TranspositionTable::BoundExact : TranspositionTable::BoundUpper);
+            tt->Store(pos.hash, depth, ScoreToTT(bestScore, ply), bound, bestMove, searchGeneration);
+            return bestScore;
+        }
+
+        // 把 moves[first..] 按一层开放度差先验排序：走完后对方视角的 Evaluate 越低越靠前，同分保持生成顺序。
+        // 只在会做削减的节点（剩余深度 >= 2）上调用，子树至少上千个叶节点，逐个评估子局面的开销可以忽略
+        void OrderByPrior(Position& pos, MoveList& moves, int first, int ply)
+        {
+            int n = moves.count - first;
+            if (n <= 1) return;
+            priorKeys.resize(static_cast<size_t>(n));
+            for (int i = 0; i < n; ++i)
+            {
+                const Move& m = moves[first + i];
+                pos.Play(m);
+                // 高 32 位为分值（偏移为非负），低 32 位为原序号，整体排序即稳定排序
+                uint64_t score = static_cast<uint64_t>(Evaluate(pos, ply + 1) + INFINITE_SCORE);
+                priorKeys[i] = (score << 32) | static_cast<uint32_t>(i);
+                pos.Undo(m);
+            }
+            std::sort(priorKeys.begin(), priorKeys.end());
+            priorMoves.assign(moves.moves.begin() + first, moves.moves.begin() + moves.count);
+            for (int i = 0; i < n; ++i) moves[first + i] = priorMoves[static_cast<uint32_t>(priorKeys[i])];
+        }
+
+        // 按排序名次决定削减层数（调用方保证剩余深度 >= lmrMinDepth >= 2 时才使用）
+        int LateMoveReduction(int moveIndex) const
+        {
+            if (moveIndex < options.lmrFullMoves) return 0;
+            return moveIndex < options.lmrFullMoves * 8 ? 1 : 2;
+        }
+
+        // 执行走法；使用网络评估时同步增量更新下一层累加器
+        void PlayMove(Position& pos, const Move& m, int ply)
+        {
+            if (network) network->Update(accumulators[ply], accumulators[ply + 1], pos.sideToMove, m);
+            pos.Play(m);
+        }
+
+        int EvaluateLeaf(const Position& pos, int ply) const
+        {
+            if (!network) return evalParams ? Evaluate(pos, ply, *evalParams) : Evaluate(pos, ply);
+            if (!HasAnyMove(pos)) return -MATE_SCORE + ply;
+            int s = network->Evaluate(accumulators[ply], pos.sideToMove);
+            return std::max(-MATE_BOUND + 1, std::min(MATE_BOUND - 1, s));
+        }
+
+        // 将指定走法移到列表首位（其余相对顺序不变）
+        static void PromoteMove(MoveList& moves, uint32_t code)
+        {
+            if (code == NULL_MOVE_CODE) return;
+            for (int i = 0; i < moves.count; ++i)
+            {
+                if (moves[i].Code() == code)
+                {
+                    Move m = moves[i];
+                    std::copy_backward(moves.moves.begin(), moves.moves.begin() + i, moves.moves.begin() + i + 1);
+                    moves[0] = m;
+                    return;
+                }
+            }
+        }
+
+        // 杀棋分在置换表中按“距当前节点”存储
+        static int ScoreToTT(int s, int ply)
+        {
+            if (s >= MATE_BOUND) return s + ply;
+            if (s <= -MATE_BOUND) return s - ply;
+            return s;
+        }
+
+        static int ScoreFromTT(int s, int ply)
+        {
+            if (s >= MATE_BOUND) return s - ply;
+            if (s <= -MATE_BOUND) return s + ply;
+            return s;
+        }
+
+        std::shared_ptr<TranspositionTable> tt;
+        std::vector<MoveList> moveLists;
+        std::vector<uint64_t> priorKeys;  // OrderByPrior 的临时缓冲区（排序完成后才递归，各层共用）
+        std::vector<Move> priorMoves;
+        std::shared_ptr<const Network> network;
+        std::shared_ptr<const EvalParams> evalParams;
+        InfoCallback infoCallback;
+        SearchOptions options;
+        std::vector<Network::Accumulator> accumulators; // 按 ply 的累加器栈
+        SearchStats stats;
+        SearchLimits limits;
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t nodes = 0;
+        uint64_t ttProbes = 0;
+        uint64_t carriedHits = 0;
+        uint8_t searchGeneration = 0;
+        bool aborted = false;
+        bool iterationHasMove = false;
+        std::atomic<bool> stopRequested{ false };
+    };
+} // namespace AmazonChess
@@ -0,0 +1,195 @@
+﻿#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+
+// 搜索统计与时间线导出。
+// 统计收集由 AMAZON_SEARCH_STATS 控制（默认关闭）：关闭时 AMAZON_STAT(...) 展开为空，
+// 搜索热循环中没有任何额外开销；工具构建时加 -DAMAZON_SEARCH_STATS=1 启用。
+
+#ifndef AMAZON_SEARCH_STATS
+#define AMAZON_SEARCH_STATS 0
+#endif
+
+#if AMAZON_SEARCH_STATS
+#define AMAZON_STAT(statement) do { statement; } while (0)
+#else
+#define AMAZON_STAT(statement) do { } while (0)
+#endif
+
+namespace AmazonChess
+{
+    static constexpr bool SEARCH_STATS_ENABLED = AMAZON_SEARCH_STATS != 0;
+
+    // 截断统计按走法序号分桶，最后一桶为“序号 >= CUTOFF_BUCKETS-1”
+    static constexpr int CUTOFF_BUCKETS = 16;
+
+    struct IterationStats
+    {
+        int depth = 0;
+        double startMs = 0.0;   // 相对本次搜索开始
+        double timeMs = 0.0;
+        uint64_t nodes = 0;     // 本轮迭代结束时的累计节点数
+        int score = 0;
+        Move bestMove = MoveOf(0, 0, 0);
+        bool completed = false;
+    };
+
+    struct SearchStats
+    {
+        uint64_t nodes = 0;
+        uint64_t leafEvaluations = 0;
+        uint64_t ttProbes = 0;
+        uint64_t ttHits = 0;
+        uint64_t ttCutoffs = 0;
+        uint64_t betaCutoffs = 0;
+        uint64_t futilityPrunes = 0;     // 前沿节点因评估低于 alpha - 余量直接返回
+        uint64_t reducedSearches = 0;    // 后序走法的削减搜索
+        uint64_t reductionResearches = 0; // 削减搜索超过 alpha 后的完整深度复核
+        std::array<uint64_t, CUTOFF_BUCKETS> cutoffsByMoveIndex{};
+        int maxDepth = 0;           // 实际到达的最大 ply
+        size_t memoryBytes = 0;     // 置换表与走法缓冲区占用
+        int64_t startUs = 0;        // steady_clock 时间戳（微秒），用于时间线对齐
+        double timeMs = 0.0;
+        std::vector<IterationStats> iterations;
+
+        void Reset()
+        {
+            *this = SearchStats();
+        }
+
+        void RecordCutoff(int moveIndex)
+        {
+            ++betaCutoffs;
+            ++cutoffsByMoveIndex[moveIndex < CUTOFF_BUCKETS - 1 ? moveIndex : CUTOFF_BUCKETS - 1];
+        }
+    };
+
+    inline int64_t SteadyMicroseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline std::string FormatDouble(double v)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3f", v);
+        return buf;
+    }
+
+    // 统计记录的 JSON 对象（单行）
+    inline std::string SearchStatsToJson(const SearchStats& s)
+    {
+        std::ostringstream ss;
+        ss << "{\"nodes\":" << s.nodes
+           << ",\"leafEvaluations\":" << s.leafEvaluations
+           << ",\"ttProbes\":" << s.ttProbes
+           << ",\"ttHits\":" << s.ttHits
+           << ",\"ttCutoffs\":" << s.ttCutoffs
+           << ",\"betaCutoffs\":" << s.betaCutoffs
+           << ",\"futilityPrunes\":" << s.futilityPrunes
+           << ",\"reducedSearches\":" << s.reducedSearches
+           << ",\"reductionResearches\":" << s.reductionResearches
+           << ",\"cutoffsByMoveIndex\":[";
+        for (int i = 0; i < CUTOFF_BUCKETS; ++i)
+        {
+            if (i) ss << ',';
+            ss << s.cutoffsByMoveIndex[i];
+        }
+        ss << "],\"maxDepth\":" << s.maxDepth
+           << ",\"memoryBytes\":" << s.memoryBytes
+           << ",\"timeMs\":" << FormatDouble(s.timeMs)
+           << ",\"iterations\":[";
+        for (size_t i = 0; i < s.iterations.size(); ++i)
+        {
+            const IterationStats& it = s.iterations[i];
+            if (i) ss << ',';
+            ss << "{\"depth\":" << it.depth
+               << ",\"timeMs\":" << FormatDouble(it.timeMs)
+               << ",\"nodes\":" << it.nodes
+               << ",\"score\":" << it.score
+               << ",\"completed\":" << (it.completed ? "true" : "false") << "}";
+        }
+        ss << "]}";
+        return ss.str();
+    }
+
+    // Chrome trace（chrome://tracing / Perfetto）时间线写出器：
+    // 事件逐条写入文件，不在内存中累积；多个线程可并发调用 AddSearch
+    class SearchTraceWriter
+    {
+    public:
+        explicit SearchTraceWriter(const std::string& path)
+            : file(std::fopen(path.c_str(), "wb")), originUs(SteadyMicroseconds())
+        {
+            if (file) std::fputs("[\n", file);
+        }
+
+        ~SearchTraceWriter()
+        {
+            if (file)
+            {
+                std::fputs("\n]\n", file);
+                std::fclose(file);
+            }
+        }
+
+        SearchTraceWriter(const SearchTraceWriter&) = delete;
+        SearchTraceWriter& operator=(const SearchTraceWriter&) = delete;
+
+        bool IsOpen() const { return file != nullptr; }
+
+        // 一次搜索写为一个完整事件（ph=X），每轮迭代为其下的子事件，并附带节点数计数器
+        void AddSearch(const SearchStats& s, size_t threadId, const std::string& label)
+        {
+            if (!file) return;
+            std::ostringstream ss;
+            int64_t ts = s.startUs - originUs;
+            ss << "{\"name\":\"search " << EscapeLabel(label) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+               << ",\"ts\":" << ts << ",\"dur\":" << static_cast<int64_t>(s.timeMs * 1000.0)
+               << ",\"args\":" << SearchStatsToJson(s) << "}";
+            for (const IterationStats& it : s.iterations)
+            {
+                int64_t its = ts + static_cast<int64_t>(it.startMs * 1000.0);
+                ss << ",\n{\"name\":\"depth " << it.depth << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+                   << ",\"ts\":" << its << ",\"dur\":" << static_cast<int64_t>(it.timeMs * 1000.0)
+                   << ",\"args\":{\"nodes\":" << it.nodes << ",\"score\":" << it.score
+                   << ",\"completed\":" << (it.completed ? "true" : "false") << "}}";
+                ss << ",\n{\"name\":\"nodes\",\"ph\":\"C\",\"pid\":1,\"tid\":" << threadId
+                   << ",\"ts\":" << its + static_cast<int64_t>(it.timeMs * 1000.0)
+                   << ",\"args\":{\"nodes\":" << it.nodes << "}}";
+            }
+            std::string text = ss.str();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!first) std::fputs(",\n", file);
+            first = false;
+            std::fwrite(text.data(), 1, text.size(), file);
+        }
+
+    private:
+        static std::string EscapeLabel(const std::string& s)
+        {
+            std::string out;
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\') out += '\\';
+                if (static_cast<unsigned char>(c) >= 0x20) out += c;
+            }
+            return out;
+        }
+
+        std::FILE* file;
+        int64_t originUs;
+        std::mutex mutex;
+        bool first = true;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "AmazonSearch.h"
+#include "AmazonShard.h"
+
+// 自对弈单局：开局若干手随机走子，其后每一手由 Engine 搜索并记录为训练样本。
+// 第 i 局的随机序列只由 seed 与 i 决定，同样的设置在任何进程 / 线程中下出同一局。
+
+namespace AmazonChess
+{
+    struct SelfPlaySettings
+    {
+        SearchLimits limits;
+        int randomPlies = 6;
+        uint64_t seed = 1;
+    };
+
+    struct SelfPlayGame
+    {
+        std::vector<Move> moves;                 // 白方先走，黑白交替
+        Player winner = Player::None;
+        std::vector<TrainingSample> samples;     // 随机开局之后的每个局面
+    };
+
+    // 下完一局；out 的缓冲区由调用方复用
+    inline void PlaySelfPlayGame(Engine& engine, MoveList& moves, const SelfPlaySettings& settings,
+                                 uint64_t gameIndex, SelfPlayGame& out)
+    {
+        out.moves.clear();
+        out.samples.clear();
+        engine.NewGame();
+        uint64_t rng = settings.seed ^ (gameIndex * 0x9E3779B97F4A7C15ull);
+        Position pos = Position::Initial();
+        int ply = 0;
+        while (WinnerOf(pos) == Player::None)
+        {
+            Move m;
+            if (ply < settings.randomPlies)
+            {
+                GenerateMoves(pos, moves);
+                m = moves[static_cast<int>(SplitMix64(rng) % static_cast<uint64_t>(moves.count))];
+            }
+            else
+            {
+                SearchResult r = engine.Search(pos, settings.limits);
+                if (!r.hasMove) break;
+                TrainingSample s;
+                s.position = pos;
+                s.score = std::max(-32767, std::min(32767, r.score));
+                s.ply = std::min(ply, 255);
+                out.samples.push_back(s);
+                m = r.bestMove;
+            }
+            out.moves.push_back(m);
+            pos.Play(m);
+            ++ply;
+        }
+
+        out.winner = WinnerOf(pos);
+        for (TrainingSample& s : out.samples) s.sideToMoveWon = s.position.sideToMove == out.winner;
+    }
+} // namespace AmazonChess
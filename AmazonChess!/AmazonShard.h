@@ -0,0 +1,217 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AmazonBitboard.h"
+
+// 训练样本分片（二进制）格式。
+// 文件头 16 字节：magic "ACSD"、版本、样本字节数、保留；之后为定长样本，每个 20 字节：
+//   arrows      u64  箭位掩码
+//   amazons[8]  u8   白方 4 个 Amazon 格、黑方 4 个 Amazon 格（升序，缺失为 0xFF）
+//   score       i16  搜索分值（走子方视角）
+//   flags       u8   bit0 = 黑方走子，bit1 = 走子方最终获胜
+//   ply         u8   局面所在手数
+// 所有多字节字段为小端。
+
+namespace AmazonChess
+{
+    struct TrainingSample
+    {
+        Position position;
+        int score = 0;
+        bool sideToMoveWon = false;
+        int ply = 0;
+    };
+
+    static constexpr uint32_t SHARD_MAGIC = 0x44534341; // "ACSD"
+    static constexpr uint32_t SHARD_VERSION = 1;
+    static constexpr size_t SHARD_HEADER_BYTES = 16;
+    static constexpr size_t SHARD_SAMPLE_BYTES = 20;
+
+    inline void PutU32(unsigned char* p, uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+
+    inline uint32_t GetU32(const unsigned char* p)
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    inline void EncodeSample(const TrainingSample& s, unsigned char* out)
+    {
+        uint64_t arrows = s.position.arrows;
+        for (int i = 0; i < 8; ++i) out[i] = static_cast<unsigned char>(arrows >> (8 * i));
+        for (int side = 0; side < 2; ++side)
+        {
+            Bitboard a = s.position.amazons[side];
+            for (int k = 0; k < 4; ++k)
+                out[8 + side * 4 + k] = a ? static_cast<unsigned char>(PopLowest(a)) : 0xFF;
+        }
+        int16_t score = static_cast<int16_t>(s.score);
+        out[16] = static_cast<unsigned char>(score & 0xFF);
+        out[17] = static_cast<unsigned char>((score >> 8) & 0xFF);
+        out[18] = static_cast<unsigned char>((s.position.sideToMove == Player::Black ? 1 : 0) | (s.sideToMoveWon ? 2 : 0));
+        out[19] = static_cast<unsigned char>(s.ply);
+    }
+
+    inline void DecodeSample(const unsigned char* in, TrainingSample& s)
+    {
+        Position pos;
+        for (int i = 0; i < 8; ++i)
+        {
+            Bitboard byte = in[i];
+            while (byte) pos.Put(PieceType::Arrow, 8 * i + PopLowest(byte));
+        }
+        for (int side = 0; side < 2; ++side)
+            for (int k = 0; k < 4; ++k)
+                if (in[8 + side * 4 + k] < SQUARE_COUNT)
+                    pos.Put(side == 0 ? PieceType::WhiteAmazon : PieceType::BlackAmazon, in[8 + side * 4 + k]);
+        pos.SetSideToMove((in[18] & 1) ? Player::Black : Player::White);
+        s.position = pos;
+        s.score = static_cast<int16_t>(in[16] | (in[17] << 8));
+        s.sideToMoveWon = (in[18] & 2) != 0;
+        s.ply = in[19];
+    }
+
+    // 分片写出器：线程安全；缓冲达到 flushSamples 时写盘并 fflush，
+    // 单个分片达到 samplesPerShard 后切换到下一个文件，内存占用与运行时长无关
+    class ShardWriter
+    {
+    public:
+        ShardWriter(const std::string& prefix, size_t samplesPerShard, size_t flushSamples)
+            : prefix(prefix), samplesPerShard(samplesPerShard ? samplesPerShard : 1),
+              flushSamples(flushSamples ? flushSamples : 1)
+        {
+            buffer.reserve(this->flushSamples * SHARD_SAMPLE_BYTES);
+        }
+
+        ~ShardWriter() { Close(); }
+
+        ShardWriter(const ShardWriter&) = delete;
+        ShardWriter& operator=(const ShardWriter&) = delete;
+
+        // 追加一批样本（通常为一整局），返回是否写入成功
+        bool Append(const std::vector<TrainingSample>& samples)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            unsigned char encoded[SHARD_SAMPLE_BYTES];
+            for (const TrainingSample& s : samples)
+            {
+                EncodeSample(s, encoded);
+                buffer.insert(buffer.end(), encoded, encoded + SHARD_SAMPLE_BYTES);
+                if (buffer.size() >= flushSamples * SHARD_SAMPLE_BYTES && !FlushLocked()) return false;
+            }
+            return true;
+        }
+
+        bool Flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return FlushLocked();
+        }
+
+        void Close()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            FlushLocked();
+            if (file) { std::fclose(file); file = nullptr; }
+        }
+
+        uint64_t SamplesWritten() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return totalSamples;
+        }
+
+    private:
+        bool OpenNextShard()
+        {
+            if (file) std::fclose(file);
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%05u.bin", shardIndex++);
+            file = std::fopen((prefix + name).c_str(), "wb");
+            if (!file) return false;
+            unsigned char header[SHARD_HEADER_BYTES] = {};
+            PutU32(header, SHARD_MAGIC);
+            PutU32(header + 4, SHARD_VERSION);
+            PutU32(header + 8, static_cast<uint32_t>(SHARD_SAMPLE_BYTES));
+            samplesInShard = 0;
+            return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+        }
+
+        bool FlushLocked()
+        {
+            size_t offset = 0;
+            while (offset < buffer.size())
+            {
+                if (!file || samplesInShard >= samplesPerShard)
+                {
+                    if (!OpenNextShard()) return false;
+                }
+                size_t room = (samplesPerShard - samplesInShard) * SHARD_SAMPLE_BYTES;
+                size_t chunk = std::min(room, buffer.size() - offset);
+                if (std::fwrite(buffer.data() + offset, 1, chunk, file) != chunk) return false;
+                samplesInShard += chunk / SHARD_SAMPLE_BYTES;
+                totalSamples += chunk / SHARD_SAMPLE_BYTES;
+                offset += chunk;
+            }
+            buffer.clear();
+            if (file) std::fflush(file);
+            return true;
+        }
+
+        std::string prefix;
+        size_t samplesPerShard;
+        size_t flushSamples;
+        mutable std::mutex mutex;
+        std::vector<unsigned char> buffer;
+        std::FILE* file = nullptr;
+        unsigned shardIndex = 0;
+        size_t samplesInShard = 0;
+        uint64_t totalSamples = 0;
+    };
+
+    // 顺序读取单个分片文件
+    class ShardReader
+    {
+    public:
+        explicit ShardReader(const std::string& path) : file(std::fopen(path.c_str(), "rb"))
+        {
+            unsigned char header[SHARD_HEADER_BYTES];
+            if (!file) return;
+            if (std::fread(header, 1, sizeof(header), file) != sizeof(header)
+                || GetU32(header) != SHARD_MAGIC || GetU32(header + 4) != SHARD_VERSION
+                || GetU32(header + 8) != SHARD_SAMPLE_BYTES)
+            {
+                std::fclose(file);
+                file = nullptr;
+            }
+        }
+
+        ~ShardReader() { if (file) std::fclose(file); }
+
+        ShardReader(const ShardReader&) = delete;
+        ShardReader& operator=(const ShardReader&) = delete;
+
+        bool IsOpen() const { return file != nullptr; }
+
+        // 读取下一个样本；文件结束（或尾部不完整）返回 false
+        bool Next(TrainingSample& s)
+        {
+            unsigned char data[SHARD_SAMPLE_BYTES];
+            if (!file || std::fread(data, 1, sizeof(data), file) != sizeof(data)) return false;
+            DecodeSample(data, s);
+            return true;
+        }
+
+    private:
+        std::FILE* file;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,156 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 大块表内存（置换表等）的分配：
+//   - Linux 上以匿名 mmap 按 2 MB 对齐分配，hugePages 时 madvise(MADV_HUGEPAGE) 请求透明大页，
+//     数 GB 的表由 4 KB 页的数十万个 TLB 项降到两千余个，随机探查基本不再 TLB 缺失；
+//   - interleaveNodes 时以 mbind(MPOL_INTERLEAVE) 把页面轮流分布到各有内存的 NUMA 节点，
+//     多路服务器上各线程访问远端内存的比例相同，不会集中压在首次写入者所在的节点（单节点机器上不生效）；
+//   - 其它平台退化为普通分配（Windows 上按 64 字节对齐）。
+// 两个选项都是“尽力而为”：内核不支持或策略设置失败时照常分配，HugePagesApplied / InterleaveApplied 报告实际结果。
+// 返回的内存全部为 0，且尚未触碰（由调用方初始化时首次写入，页面按上述策略落位）。
+
+namespace AmazonChess
+{
+    struct TableMemoryOptions
+    {
+        bool hugePages = true;
+        bool interleaveNodes = false;
+    };
+
+    namespace TableMemoryDetail
+    {
+        static constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+        static constexpr size_t CACHE_LINE_BYTES = 64;
+
+#if defined(__linux__)
+        // 解析 "0-1,3" 形式的节点列表为位掩码（最多 64 个节点）
+        inline uint64_t ParseNodeList(const std::string& s)
+        {
+            uint64_t mask = 0;
+            size_t i = 0;
+            while (i < s.size())
+            {
+                char* end = nullptr;
+                long first = std::strtol(s.c_str() + i, &end, 10);
+                if (end == s.c_str() + i) break;
+                long last = first;
+                i = static_cast<size_t>(end - s.c_str());
+                if (i < s.size() && s[i] == '-')
+                {
+                    last = std::strtol(s.c_str() + i + 1, &end, 10);
+                    i = static_cast<size_t>(end - s.c_str());
+                }
+                for (long n = first; n <= last && n < 64; ++n)
+                    if (n >= 0) mask |= uint64_t(1) << n;
+                if (i < s.size() && s[i] == ',') ++i;
+                else break;
+            }
+            return mask;
+        }
+
+        // 有内存的 NUMA 节点
+        inline uint64_t MemoryNodes()
+        {
+            std::ifstream ifs("/sys/devices/system/node/has_memory");
+            std::string line;
+            if (!ifs.is_open() || !std::getline(ifs, line)) return 0;
+            return ParseNodeList(line);
+        }
+#endif
+    } // namespace TableMemoryDetail
+
+    class TableMemory
+    {
+    public:
+        TableMemory() = default;
+        ~TableMemory() { Release(); }
+
+        TableMemory(const TableMemory&) = delete;
+        TableMemory& operator=(const TableMemory&) = delete;
+
+        // 分配 bytes 字节的清零内存；失败返回 nullptr
+        void* Allocate(size_t bytes, const TableMemoryOptions& options)
+        {
+            Release();
+            hugePagesApplied = false;
+            interleaveApplied = false;
+#if defined(__linux__)
+            using namespace TableMemoryDetail;
+            // 多映射一个大页再裁掉首尾，使起始地址按 2 MB 对齐（透明大页只在对齐的整段上生效）
+            size_t mapped = bytes + HUGE_PAGE_BYTES;
+            void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) return nullptr;
+            uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = (start + HUGE_PAGE_BYTES - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_BYTES - 1);
+            if (aligned > start) munmap(raw, aligned - start);
+            size_t length = (bytes + 4095) & ~static_cast<size_t>(4095);
+            uintptr_t end = start + mapped;
+            if (end > aligned + length) munmap(reinterpret_cast<void*>(aligned + length), end - aligned - length);
+            data = reinterpret_cast<void*>(aligned);
+            size = length;
+#if defined(MADV_HUGEPAGE)
+            // 关闭时显式拒绝大页（透明大页为 always 模式时也按 4 KB 页分配），便于对比
+            if (options.hugePages) hugePagesApplied = madvise(data, size, MADV_HUGEPAGE) == 0;
+            else madvise(data, size, MADV_NOHUGEPAGE);
+#endif
+#if defined(SYS_mbind)
+            uint64_t nodes = MemoryNodes();
+            if (options.interleaveNodes && (nodes & (nodes - 1)) != 0)
+            {
+                const int MPOL_INTERLEAVE_MODE = 3; // <numaif.h> 中的 MPOL_INTERLEAVE，避免依赖 libnuma
+                unsigned long mask = static_cast<unsigned long>(nodes);
+                interleaveApplied = syscall(SYS_mbind, data, size, MPOL_INTERLEAVE_MODE, &mask, sizeof(mask) * 8 + 1, 0) == 0;
+            }
+#endif
+            return data;
+#else
+            (void)options;
+            size = (bytes + TableMemoryDetail::CACHE_LINE_BYTES - 1) & ~(TableMemoryDetail::CACHE_LINE_BYTES - 1);
+#if defined(_WIN32)
+            data = _aligned_malloc(size, TableMemoryDetail::CACHE_LINE_BYTES);
+            if (data) std::memset(data, 0, size);
+#else
+            data = std::calloc(1, size);
+#endif
+            return data;
+#endif
+        }
+
+        void Release()
+        {
+            if (!data) return;
+#if defined(__linux__)
+            munmap(data, size);
+#elif defined(_WIN32)
+            _aligned_free(data);
+#else
+            std::free(data);
+#endif
+            data = nullptr;
+            size = 0;
+        }
+
+        bool HugePagesApplied() const { return hugePagesApplied; }
+        bool InterleaveApplied() const { return interleaveApplied; }
+
+    private:
+        void* data = nullptr;
+        size_t size = 0;
+        bool hugePagesApplied = false;
+        bool interleaveApplied = false;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，空闲时从其它队列头部窃取。
+// 任务接收执行它的工作线程编号，便于每个线程持有独立的 Engine 等状态。
+
+namespace AmazonChess
+{
+    class WorkStealingPool
+    {
+    public:
+        using Task = std::function<void(size_t workerIndex)>;
+
+        explicit WorkStealingPool(size_t threadCount)
+        {
+            if (threadCount == 0) threadCount = 1;
+            for (size_t i = 0; i < threadCount; ++i) queues.emplace_back(new Queue());
+            for (size_t i = 0; i < threadCount; ++i) workers.emplace_back([this, i] { WorkerLoop(i); });
+        }
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stopping = true;
+            }
+            wakeCv.notify_all();
+            for (auto& t : workers) t.join();
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        size_t Size() const { return workers.size(); }
+
+        // 默认线程数：硬件线程数（无法获取时为 1）
+        static size_t DefaultThreadCount()
+        {
+            unsigned n = std::thread::hardware_concurrency();
+            return n ? n : 1;
+        }
+
+        // 提交任务：轮流放入各工作线程的队列尾部
+        void Submit(Task task)
+        {
+            size_t q = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+            {
+                std::lock_guard<std::mutex> lock(queues[q]->mutex);
+                queues[q]->tasks.push_back(std::move(task));
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                ++queued;
+                ++unfinished;
+            }
+            wakeCv.notify_one();
+        }
+
+        // 等待所有已提交任务执行完毕
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            idleCv.wait(lock, [this] { return unfinished == 0; });
+        }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // 先取自己队列尾部（最近提交，缓存更热），再从其它队列头部窃取
+        bool TryTake(size_t index, Task& out)
+        {
+            {
+                Queue& own = *queues[index];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty())
+                {
+                    out = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+            for (size_t k = 1; k < queues.size(); ++k)
+            {
+                Queue& victim = *queues[(index + k) % queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    out = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void WorkerLoop(size_t index)
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(sleepMutex);
+                    wakeCv.wait(lock, [this] { return stopping || queued > 0; });
+                    if (queued == 0) return; // stopping 且无剩余任务
+                    --queued;
+                }
+
+                // queued 计数保证至少有一个任务可取
+                Task task;
+                while (!TryTake(index, task)) std::this_thread::yield();
+                task(index);
+
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                if (--unfinished == 0) idleCv.notify_all();
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<size_t> nextQueue{ 0 };
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeCv;
+        std::condition_variable idleCv;
+        size_t queued = 0;      // 已提交但尚未被领取的任务数
+        size_t unfinished = 0;  // 已提交但尚未执行完毕的任务数
+        bool stopping = false;
+    };
+} // namespace AmazonChess
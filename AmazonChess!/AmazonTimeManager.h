@@ -0,0 +1,97 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include "AmazonBitboard.h"
+
+// 用时管理：按对局剩余时间与每手加时为本手分配软 / 硬限制，并在迭代加深的每一轮结束后决定是否继续。
+// 软限制：超过后不再开始新一轮迭代（最佳走法不稳定时按比例放宽）；硬限制：搜索中途强制停止。
+// 只依据 steady_clock 计时，与界面的显示延迟无关。
+
+namespace AmazonChess
+{
+    // 对局时钟（走子方视角）；remainingMs 为 0 表示不使用用时管理
+    struct TimeControl
+    {
+        int64_t remainingMs = 0;
+        int64_t incrementMs = 0;
+        int movesToGo = 0;       // 距下一次加时的手数，0 表示整局包干
+    };
+
+    // 本手的时间预算；softMs 为 0 表示不限制
+    struct TimeBudget
+    {
+        int64_t softMs = 0;
+        int64_t hardMs = 0;
+    };
+
+    static constexpr int64_t TIME_OVERHEAD_MS = 20;      // 预留给通信 / 界面刷新的时间
+    static constexpr int MIN_MOVES_LEFT = 8;
+    static constexpr int64_t HARD_LIMIT_MULTIPLIER = 4;  // 硬限制最多为软限制的倍数
+    static constexpr int64_t HARD_LIMIT_DIVISOR = 3;     // 硬限制最多为剩余时间的 1/3
+    static constexpr double MAX_INSTABILITY_SCALE = 2.5;
+
+    // 估计走子方还要走的手数：每手消耗一个空格（落箭），双方平分剩余空格，
+    // 对局通常在空格用完之前结束，按三分之一估计
+    inline int EstimateMovesLeft(const Position& pos)
+    {
+        int empty = BOARD_SIZE * BOARD_SIZE - PopCount(pos.Occupied());
+        return std::max(MIN_MOVES_LEFT, empty / 3);
+    }
+
+    inline TimeBudget AllocateTime(const TimeControl& tc, const Position& pos, int64_t overheadMs = TIME_OVERHEAD_MS)
+    {
+        TimeBudget b;
+        if (tc.remainingMs <= 0) return b;
+        int64_t available = std::max<int64_t>(1, tc.remainingMs - overheadMs);
+        int movesLeft = tc.movesToGo > 0 ? std::min(tc.movesToGo, EstimateMovesLeft(pos)) : EstimateMovesLeft(pos);
+        int64_t soft = available / movesLeft + tc.incrementMs * 3 / 4;
+        int64_t hard = std::min(soft * HARD_LIMIT_MULTIPLIER, available / HARD_LIMIT_DIVISOR + tc.incrementMs);
+        hard = std::max<int64_t>(1, std::min(hard, available));
+        b.softMs = std::max<int64_t>(1, std::min(soft, hard));
+        b.hardMs = hard;
+        return b;
+    }
+
+    // 一次搜索内的迭代决策（每次 Search 新建一个）
+    class TimeManager
+    {
+    public:
+        explicit TimeManager(const TimeBudget& budget) : budget(budget) {}
+
+        bool Enabled() const { return budget.softMs > 0; }
+        int64_t HardMs() const { return budget.hardMs; }
+
+        // 每完成一轮迭代调用；forced 表示根节点只有一手可走。返回 false 表示不再开始下一轮
+        bool ContinueAfterIteration(const Move& best, bool forced, double elapsedMs)
+        {
+            if (!Enabled()) return true;
+            if (forced) return false;
+
+            // 最佳走法每变化一次加 1，每轮衰减一半：连续变化时放宽到软限制的 MAX_INSTABILITY_SCALE 倍
+            instability *= 0.5;
+            if (iterations > 0 && best.Code() != lastBest) instability += 1.0;
+            lastBest = best.Code();
+
+            double iterationMs = elapsedMs - lastElapsedMs;
+            double growth = lastIterationMs > 0.5 ? std::max(2.0, iterationMs / lastIterationMs) : 0.0;
+            lastIterationMs = iterationMs;
+            lastElapsedMs = elapsedMs;
+            ++iterations;
+
+            double soft = budget.softMs * std::min(MAX_INSTABILITY_SCALE, 1.0 + instability);
+            if (elapsedMs >= soft) return false;
+            // 未完成的迭代结果会被丢弃：按最近两轮的耗时比外推，预计在硬限制前完不成的一轮不必开始
+            if (growth > 0.0 && elapsedMs + iterationMs * growth > static_cast<double>(budget.hardMs)) return false;
+            return true;
+        }
+
+    private:
+        TimeBudget budget;
+        uint32_t lastBest = NULL_MOVE_CODE;
+        double instability = 0.0;
+        double lastElapsedMs = 0.0;
+        double lastIterationMs = 0.0;
+        int iterations = 0;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,370 @@
+﻿// AmazonAnalyse.cpp : 无界面批量局面分析工具
+// 从 .acp 棋谱或局面列表文件读入局面，分发到工作窃取线程池（每个工作线程拥有独立 Engine），
+// 按输入顺序逐行输出 JSONL 结果（最佳走法、分值、节点数、耗时）。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonAnalyse.cpp -o AmazonAnalyse
+//
+// 用法：AmazonAnalyse [选项] [game.acp ...]
+//   --list <file>      局面列表文件：每行 "<path.acp> [ply]" 或 "FEN <board> <side>"（直接给出局面，见 AmazonNotation.h），
+//                      '#' 开头为注释；省略 ply 时取棋谱终局局面
+//   --all-plies        对命令行给出的 .acp 分析每一手之前的局面（默认只分析终局局面）
+//   --threads <n>      工作线程数（默认硬件线程数）
+//   --depth <d>        搜索深度（默认 1）
+//   --nodes <n>        每个局面的节点上限（0 = 不限）
+//   --movetime <ms>    每个局面的时间上限（0 = 不限）
+//   --hash <mb>        每个工作线程的置换表大小（默认 16）
+//   --net <file>       使用神经网络权重文件评估（默认开放度评估）
+//   --eval <file>      使用评估权重文件（AmazonTune 输出）
+//   --option <n>=<v>   选择性搜索选项（可重复），如 --option lmr=on --option futility-margin=60，名称见 SetSearchOption
+//   --out <file>       输出文件（默认 stdout）
+//   --stats            在每行结果中附加搜索统计（需以 -DAMAZON_SEARCH_STATS=1 构建）
+//   --trace <file>     将所有搜索写为 Chrome trace 时间线（同样需要启用统计）
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AmazonJson.h"
+#include "AmazonRecord.h"
+#include "AmazonSearch.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    struct Job
+    {
+        std::string source;
+        int ply = 0;
+        Position position;
+        bool hasPlayed = false;   // 棋谱中该局面实际走出的一手
+        Move played = MoveOf(0, 0, 0);
+    };
+
+    // 局面来源：逐个棋谱惰性展开，避免一次性载入全部输入
+    class JobSource
+    {
+    public:
+        struct Request
+        {
+            std::string path;     // 直接给出的局面为其记号
+            int ply;              // -1 表示终局局面，-2 表示每一手
+            bool direct = false;  // 局面由记号直接给出，不读棋谱
+            Position position;
+        };
+
+        void Add(const std::string& path, int ply) { requests.push_back({ path, ply, false, Position() }); }
+        void AddPosition(const Position& pos) { requests.push_back({ "FEN " + PositionToFen(pos), 0, true, pos }); }
+
+        // 取下一个局面；输入耗尽返回 false
+        bool Next(Job& job)
+        {
+            while (pending.empty())
+            {
+                if (nextRequest >= requests.size()) return false;
+                Expand(requests[nextRequest++]);
+            }
+            job = pending.front();
+            pending.pop_front();
+            return true;
+        }
+
+    private:
+        void Expand(const Request& req)
+        {
+            if (req.direct)
+            {
+                Job job;
+                job.source = req.path;
+                job.ply = 0;
+                job.position = req.position;
+                pending.push_back(job);
+                return;
+            }
+            GameRecord record;
+            if (!LoadRecord(req.path, record))
+            {
+                std::cerr << "warning: cannot read record " << req.path << "\n";
+                return;
+            }
+            Position pos = record.start;
+            if (!record.moves.empty()) pos.SetSideToMove(record.moves.front().player);
+            int last = static_cast<int>(record.moves.size());
+            int target = req.ply >= 0 ? std::min(req.ply, last) : last;
+            for (int i = 0; i <= target; ++i)
+            {
+                if (req.ply == -2 || i == target)
+                {
+                    Job job;
+                    job.source = req.path;
+                    job.ply = i;
+                    job.position = pos;
+                    if (i < last)
+                    {
+                        job.hasPlayed = true;
+                        job.played = record.moves[i].move;
+                        job.position.SetSideToMove(record.moves[i].player);
+                    }
+                    pending.push_back(job);
+                }
+                if (i == last) break;
+                if (!ApplyRecordedMove(pos, record.moves[i]))
+                {
+                    std::cerr << "warning: illegal move at ply " << i << " in " << req.path << "\n";
+                    break;
+                }
+            }
+        }
+
+        std::vector<Request> requests;
+        size_t nextRequest = 0;
+        std::deque<Job> pending;
+    };
+
+    std::string FormatResult(size_t id, const Job& job, const SearchResult& r, const SearchStats* stats)
+    {
+        std::ostringstream ss;
+        ss << "{\"id\":" << id
+           << ",\"source\":\"" << JsonEscape(job.source) << "\""
+           << ",\"ply\":" << job.ply
+           << ",\"side\":\"" << (job.position.sideToMove == Player::White ? "W" : "B") << "\"";
+        if (r.hasMove)
+        {
+            ss << ",\"move\":\"" << MoveToString(r.bestMove) << "\""
+               << ",\"movePacked\":" << r.bestMove.MovePacked()
+               << ",\"arrowIndex\":" << r.bestMove.ArrowIndex();
+        }
+        else
+        {
+            ss << ",\"move\":null,\"movePacked\":-1,\"arrowIndex\":-1";
+        }
+        if (job.hasPlayed) ss << ",\"played\":\"" << MoveToString(job.played) << "\"";
+        char timeBuf[32];
+        std::snprintf(timeBuf, sizeof(timeBuf), "%.3f", r.timeMs);
+        ss << ",\"score\":" << r.score
+           << ",\"depth\":" << r.depth
+           << ",\"nodes\":" << r.nodes
+           << ",\"timeMs\":" << timeBuf;
+        if (stats) ss << ",\"stats\":" << SearchStatsToJson(*stats);
+        ss << "}";
+        return ss.str();
+    }
+
+    // 有界重排窗口：工作线程按任意顺序写入，主线程按 id 顺序取出
+    class OrderedResults
+    {
+    public:
+        explicit OrderedResults(size_t window) : slots(window), ready(window, false) {}
+
+        size_t Window() const { return slots.size(); }
+
+        void Put(size_t id, std::string line)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[id % slots.size()] = std::move(line);
+                ready[id % slots.size()] = true;
+            }
+            cv.notify_all();
+        }
+
+        // 阻塞直到 id 的结果就绪并取出
+        std::string Take(size_t id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            size_t slot = id % slots.size();
+            cv.wait(lock, [&] { return static_cast<bool>(ready[slot]); });
+            ready[slot] = false;
+            return std::move(slots[slot]);
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::string> slots;
+        std::vector<bool> ready;
+    };
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonAnalyse [--list file] [--all-plies] [--threads n] [--depth d]\n"
+                     "                     [--nodes n] [--movetime ms] [--hash mb] [--out file]\n"
+                     "                     [--stats] [--trace file] [--net file] [--eval file]\n"
+                     "                     [--option name=value ...] [game.acp ...]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    JobSource source;
+    SearchLimits limits;
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    size_t hashMb = 16;
+    bool allPlies = false;
+    bool withStats = false;
+    std::string outPath;
+    std::string tracePath;
+    std::string netPath;
+    std::string evalPath;
+    std::vector<std::string> games;
+    std::vector<std::string> lists;
+    SearchOptions searchOptions;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--list") lists.push_back(next());
+        else if (arg == "--all-plies") allPlies = true;
+        else if (arg == "--threads") threads = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--depth") limits.maxDepth = std::atoi(next());
+        else if (arg == "--nodes") limits.maxNodes = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--movetime") limits.maxTimeMs = std::atoll(next());
+        else if (arg == "--hash") hashMb = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--out") outPath = next();
+        else if (arg == "--stats") withStats = true;
+        else if (arg == "--trace") tracePath = next();
+        else if (arg == "--net") netPath = next();
+        else if (arg == "--eval") evalPath = next();
+        else if (arg == "--option")
+        {
+            std::string option = next();
+            size_t eq = option.find('=');
+            if (eq == std::string::npos || !SetSearchOption(searchOptions, option.substr(0, eq), option.substr(eq + 1)))
+            {
+                std::cerr << "bad search option " << option << "\n";
+                return 2;
+            }
+        }
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else if (!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+        else games.push_back(arg);
+    }
+
+    for (const auto& g : games) source.Add(g, allPlies ? -2 : -1);
+    for (const auto& listPath : lists)
+    {
+        std::ifstream ifs(listPath);
+        if (!ifs.is_open())
+        {
+            std::cerr << "cannot open list " << listPath << "\n";
+            return 1;
+        }
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            std::istringstream iss(line);
+            std::string path;
+            if (!(iss >> path) || path[0] == '#') continue;
+            if (path == "FEN")
+            {
+                std::string board, side, error;
+                Position pos;
+                if (!(iss >> board >> side) || !ParseFen(board, side, pos, error))
+                {
+                    std::cerr << "warning: bad position in " << listPath << ": " << line << " (" << error << ")\n";
+                    continue;
+                }
+                source.AddPosition(pos);
+                continue;
+            }
+            int ply = -1;
+            iss >> ply;
+            source.Add(path, ply < 0 ? -1 : ply);
+        }
+    }
+    if (games.empty() && lists.empty()) { Usage(); return 2; }
+
+    std::ofstream outFile;
+    if (!outPath.empty())
+    {
+        outFile.open(outPath, std::ios::binary);
+        if (!outFile.is_open())
+        {
+            std::cerr << "cannot open output " << outPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : outFile;
+
+    if ((withStats || !tracePath.empty()) && !SEARCH_STATS_ENABLED)
+    {
+        std::cerr << "warning: built without AMAZON_SEARCH_STATS, statistics will be empty\n";
+    }
+    std::unique_ptr<SearchTraceWriter> trace;
+    if (!tracePath.empty())
+    {
+        trace.reset(new SearchTraceWriter(tracePath));
+        if (!trace->IsOpen())
+        {
+            std::cerr << "cannot open trace " << tracePath << "\n";
+            return 1;
+        }
+    }
+
+    std::shared_ptr<Network> network;
+    if (!netPath.empty())
+    {
+        network = std::make_shared<Network>();
+        if (!network->Load(netPath))
+        {
+            std::cerr << "cannot load network " << netPath << "\n";
+            return 1;
+        }
+    }
+    std::shared_ptr<const EvalParams> evalParams;
+    if (!evalPath.empty() && !(evalParams = LoadEvalParams(evalPath)))
+    {
+        std::cerr << "cannot load weights " << evalPath << "\n";
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<Engine>> engines;
+    for (size_t i = 0; i < pool.Size(); ++i)
+    {
+        engines.emplace_back(new Engine(hashMb));
+        engines.back()->SetNetwork(network);
+        engines.back()->SetEvalParams(evalParams);
+        engines.back()->SetOptions(searchOptions);
+    }
+
+    // 窗口大小限制在途局面数量，内存占用与输入规模无关
+    OrderedResults results(pool.Size() * 8);
+    size_t submitted = 0;
+    size_t written = 0;
+    Job job;
+    while (source.Next(job))
+    {
+        while (submitted - written >= results.Window())
+        {
+            out << results.Take(written++) << "\n";
+        }
+        size_t id = submitted++;
+        std::shared_ptr<Job> shared = std::make_shared<Job>(job);
+        pool.Submit([&engines, &results, &limits, &trace, withStats, shared, id](size_t worker) {
+            Engine& engine = *engines[worker];
+            SearchResult r = engine.Search(shared->position, limits);
+            if (trace) trace->AddSearch(engine.LastStats(), worker, shared->source + ":" + std::to_string(shared->ply));
+            results.Put(id, FormatResult(id, *shared, r, withStats ? &engine.LastStats() : nullptr));
+        });
+    }
+    while (written < submitted)
+    {
+        out << results.Take(written++) << "\n";
+    }
+    out.flush();
+    return 0;
+}
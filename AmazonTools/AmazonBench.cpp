@@ -0,0 +1,1302 @@
+﻿// AmazonBench.cpp : 引擎组件基准测试
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -march=native -pthread -I"../AmazonChess!" AmazonBench.cpp -o AmazonBench
+//
+// 用法：AmazonBench <子命令> [选项]
+//   eval [--net file] [--positions n] [--seed s]
+//        比较开放度评估与神经网络评估（完整刷新 / 增量更新）的每秒评估次数。
+//        未给出 --net 时使用随机权重，仅测速度。
+//   batch [--positions n] [--seed s]
+//        校验批量评估（AmazonBatchEval.h）与逐个 Evaluate 的结果一致，
+//        再比较批大小 1 / 8 / 64 / 1024 下的每秒评估次数（SIMD 与逐局面两种实现）。
+//   mobility [--boards n] [--seed s]
+//        在随机棋盘（随机落子与随机对局局面各半）上逐格校验各字节棋盘开放度内核（AmazonMobilityKernel.h）
+//        与位棋盘 QueenReach / Mobility 的结果一致，再比较各内核每秒处理的棋盘数。
+//   search [--movetime ms | --depth d] [--positions n] [--seed s] [--hash mb]
+//          [--config name:opt=v,opt=v ...] [game.acp ...]
+//        在同一组局面上依次用各组选择性搜索选项（SetSearchOption）搜索，比较到达深度、节点数、耗时，
+//        以及最佳走法与第一组的一致率。局面取自给出的棋谱（均匀抽取），否则取随机对局。
+//        默认限制为每局面 200 ms；未给出 --config 时比较 full / lmr / futility / lmr+futility / lmr-noverify。
+//   journal [--games n] [--seed s] [--dir path]
+//        先校验对局日志（AmazonJournal.h）的恢复：残缺尾部与损坏记录被截掉、其前各手完整保留；
+//        再在 n 局随机对局上比较每手的写盘代价：日志追加（每手 fflush / 每 8 手 fflush / 每手 fsync）
+//        与每手整局重写 .acp（SaveRecord）。临时文件写在 --dir（默认当前目录）下，结束后删除。
+//   cache [--positions n] [--depth d] [--hash mb] [--cache-mb mb] [--seed s] [--dir path]
+//        先校验分析缓存（AmazonAnalysisCache.h）：深度替换规则、重新打开后保留、评估指纹不符与头部损坏时清空重建、
+//        写坏的条目被忽略；再模拟两次会话：第一次冷启动搜索 n 个局面并写回缓存，第二次从缓存预热后搜索同一组局面，
+//        比较节点数、耗时与最佳走法。临时文件写在 --dir（默认当前目录）下，结束后删除。
+//   tt [--hash mb] [--probes n] [--positions n] [--depth d] [--seed s]
+//        置换表内存选项（AmazonTableMemory.h）对比：4 KB 页 / 透明大页 / 大页 + NUMA 交错，
+//        各自测随机探查的延迟（相互依赖的探查链，以及提前 8 个预取的独立探查），
+//        再在同一组局面上做定深搜索，比较关闭 / 开启子节点预取时的每秒节点数。
+//   mcts [--playouts n] [--positions n] [--seed s] [--ref-depth d] [--widen-base b] [--widen-exp e]
+//        在初始局面与随机对局的开局 / 中局局面上比较 MCTS（AmazonMcts.h）渐进展开与一次全部展开：
+//        收敛所需模拟次数（此后访问最多的根子节点不再变化）、最终选择与 d 层 alpha-beta（默认 2）的一致率、每秒模拟数。
+//   protocol [--engine path] [--rounds n]（Linux）
+//        校验引擎进程（默认 ./AmazonEngine）对 stop 的响应：go 之后立即或稍后发 stop 与 isready，
+//        每轮启动一个新进程，要求在 5 秒内先输出 bestmove 再输出 readyok（go 与 stop 之间的竞争不能丢掉 stop）；
+//        普通搜索、求解模式（先求解后搜索）与 go solve 各测一组。
+//   dedup [--dedup path] [--games n] [--seed s] [--dir path]（Linux）
+//        校验对局库去重工具（默认 ./AmazonDedup）：n 局随机对局另加完全相同与左右镜像的副本，
+//        分别以 --memory 0（每局单独成段，段数超过归并扇入，须多趟归并）与默认内存（一趟归并）运行，
+//        不带 / 带 --symmetric 时保留的对局须与预期一致（镜像副本仅在 --symmetric 时去掉）。临时文件写在 --dir 下，结束后删除。
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AmazonAnalysisCache.h"
+#include "AmazonBatchEval.h"
+#include "AmazonJournal.h"
+#include "AmazonMcts.h"
+#include "AmazonMobilityKernel.h"
+#include "AmazonNetwork.h"
+#include "AmazonRecord.h"
+#include "AmazonSearch.h"
+#if !defined(_WIN32)
+#include "AmazonProcess.h"
+#endif
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // 随机对局采样：返回 (局面, 该局面之后实际走出的一手) 序列，覆盖开局到残局
+    struct Sample
+    {
+        Position position;
+        Move next;
+    };
+
+    std::vector<Sample> RandomSamples(size_t count, uint64_t seed)
+    {
+        std::vector<Sample> samples;
+        samples.reserve(count);
+        std::unique_ptr<MoveList> moves(new MoveList());
+        while (samples.size() < count)
+        {
+            Position pos = Position::Initial();
+            for (;;)
+            {
+                GenerateMoves(pos, *moves);
+                if (moves->count == 0 || samples.size() >= count) break;
+                Move m = (*moves)[static_cast<int>(SplitMix64(seed) % static_cast<uint64_t>(moves->count))];
+                samples.push_back({ pos, m });
+                pos.Play(m);
+            }
+        }
+        return samples;
+    }
+
+    // 防止编译器优化掉评估结果
+    volatile int64_t g_sink = 0;
+
+    int BenchEval(int argc, char* argv[])
+    {
+        std::string netPath;
+        size_t positions = 20000;
+        uint64_t seed = 1;
+        for (int i = 0; i < argc; ++i)
+        {
+            if (!std::strcmp(argv[i], "--net") && i + 1 < argc) netPath = argv[++i];
+            else if (!std::strcmp(argv[i], "--positions") && i + 1 < argc) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+
+        Network net;
+        if (netPath.empty()) net.Randomize(seed);
+        else if (!net.Load(netPath))
+        {
+            std::fprintf(stderr, "cannot load network %s\n", netPath.c_str());
+            return 1;
+        }
+
+        std::vector<Sample> samples = RandomSamples(positions, seed);
+        const int rounds = 20;
+        int64_t sink = 0;
+
+        Clock::time_point t0 = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const Sample& s : samples) sink += Evaluate(s.position, 0);
+        double mobilitySec = SecondsSince(t0);
+
+        Network::Accumulator acc;
+        t0 = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (const Sample& s : samples)
+            {
+                net.Refresh(s.position, acc);
+                sink += net.Evaluate(acc, s.position.sideToMove);
+            }
+        }
+        double refreshSec = SecondsSince(t0);
+
+        // 增量：每个样本由父累加器经一次 Update 得到子节点并评估（搜索中叶节点的实际开销）
+        std::vector<Network::Accumulator> parents(samples.size());
+        for (size_t i = 0; i < samples.size(); ++i) net.Refresh(samples[i].position, parents[i]);
+        Network::Accumulator child;
+        t0 = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                const Sample& s = samples[i];
+                net.Update(parents[i], child, s.position.sideToMove, s.next);
+                sink += net.Evaluate(child, Opponent(s.position.sideToMove));
+            }
+        }
+        double incrementalSec = SecondsSince(t0);
+        g_sink = sink;
+
+        double n = static_cast<double>(samples.size()) * rounds;
+        std::printf("kernel            %s\n", Network::KernelName());
+        std::printf("positions         %zu x %d rounds\n", samples.size(), rounds);
+        std::printf("mobility          %12.0f evals/s\n", n / mobilitySec);
+        std::printf("network refresh   %12.0f evals/s\n", n / refreshSec);
+        std::printf("network increment %12.0f evals/s\n", n / incrementalSec);
+        return 0;
+    }
+
+    int BenchBatch(int argc, char* argv[])
+    {
+        size_t positions = 65536;
+        uint64_t seed = 1;
+        for (int i = 0; i < argc; ++i)
+        {
+            if (!std::strcmp(argv[i], "--positions") && i + 1 < argc) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        std::vector<Sample> samples = RandomSamples(std::max<size_t>(positions, 1), seed);
+
+        PositionBatch all;
+        for (const Sample& s : samples) all.Add(s.position);
+        std::vector<int> scores(all.Size()), scratch;
+        for (bool simd : { false, true })
+        {
+            EvaluateBatch(all, 3, scores.data(), scratch, simd);
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                if (scores[i] != Evaluate(samples[i].position, 3))
+                {
+                    std::printf("MISMATCH position %zu (%s)\n", i, simd ? "simd" : "scalar");
+                    return 1;
+                }
+            }
+        }
+        std::printf("validated         %zu positions, kernel %s\n", samples.size(),
+                    ActiveMobilityKernel() == MobilityKernel::Avx2 ? "avx2" : "scalar");
+
+        int64_t sink = 0;
+        const int rounds = 10;
+        double n = static_cast<double>(samples.size()) * rounds;
+        Clock::time_point t0 = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const Sample& s : samples) sink += Evaluate(s.position, 0);
+        std::printf("single Evaluate   %12.0f evals/s\n", n / SecondsSince(t0));
+
+        for (size_t batchSize : { size_t(1), size_t(8), size_t(64), size_t(1024) })
+        {
+            std::vector<PositionBatch> batches((samples.size() + batchSize - 1) / batchSize);
+            for (size_t i = 0; i < samples.size(); ++i) batches[i / batchSize].Add(samples[i].position);
+            double rate[2];
+            for (int simd = 0; simd < 2; ++simd)
+            {
+                t0 = Clock::now();
+                for (int r = 0; r < rounds; ++r)
+                {
+                    for (const PositionBatch& b : batches)
+                    {
+                        EvaluateBatch(b, 0, scores.data(), scratch, simd != 0);
+                        sink += scores[0];
+                    }
+                }
+                rate[simd] = n / SecondsSince(t0);
+            }
+            std::printf("batch %-5zu       %12.0f evals/s  (per-position %12.0f)\n", batchSize, rate[1], rate[0]);
+        }
+        g_sink = sink;
+        return 0;
+    }
+
+    // 随机落子的字节棋盘：每格以 1/2 为空，其余在白 / 黑 Amazon 与箭之间均分（不要求 Amazon 恰为 4 个）
+    void RandomByteBoard(uint64_t& rng, uint8_t* cells)
+    {
+        for (int s = 0; s < SQUARE_COUNT; ++s)
+        {
+            uint64_t r = SplitMix64(rng) % 6;
+            cells[s] = static_cast<uint8_t>(r < 3 ? 0 : r - 2);
+        }
+    }
+
+    Position PositionFromBytes(const uint8_t* cells)
+    {
+        std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE> board;
+        for (int s = 0; s < SQUARE_COUNT; ++s) board[s / BOARD_SIZE][s % BOARD_SIZE] = static_cast<PieceType>(cells[s]);
+        return Position::FromBoard(board, Player::White);
+    }
+
+    int BenchMobility(int argc, char* argv[])
+    {
+        size_t boards = 20000;
+        uint64_t seed = 1;
+        for (int i = 0; i < argc; ++i)
+        {
+            if (!std::strcmp(argv[i], "--boards") && i + 1 < argc) boards = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+
+        std::vector<uint8_t> cells(boards * SQUARE_COUNT);
+        uint64_t rng = seed;
+        size_t half = boards / 2;
+        for (size_t i = 0; i < half; ++i) RandomByteBoard(rng, &cells[i * SQUARE_COUNT]);
+        std::vector<Sample> samples = RandomSamples(boards - half, seed);
+        for (size_t i = half; i < boards; ++i)
+        {
+            std::array<std::array<PieceType, BOARD_SIZE>, BOARD_SIZE> board;
+            samples[i - half].position.ToBoard(board);
+            ToByteBoard(board, &cells[i * SQUARE_COUNT]);
+        }
+
+        const MobilityKernel kernels[] = { MobilityKernel::Scalar, MobilityKernel::Ssse3, MobilityKernel::Avx2 };
+        std::printf("detected kernel   %s\n", MobilityKernelName(DetectMobilityKernel()));
+
+        // 校验：每格可达数与 QueenReach 一致，双方合计与 Mobility 一致
+        MobilityCounts counts;
+        for (MobilityKernel k : kernels)
+        {
+            if (!MobilityKernelSupported(k)) continue;
+            for (size_t i = 0; i < boards; ++i)
+            {
+                const uint8_t* b = &cells[i * SQUARE_COUNT];
+                Position pos = PositionFromBytes(b);
+                CountMobility(b, counts, k);
+                bool ok = counts.openness[0] == Mobility(pos, Player::White)
+                    && counts.openness[1] == Mobility(pos, Player::Black);
+                for (int s = 0; ok && s < SQUARE_COUNT; ++s)
+                    ok = counts.reach[s] == PopCount(QueenReach(s, pos.Occupied()));
+                if (!ok)
+                {
+                    std::printf("MISMATCH kernel %s board %zu\n", MobilityKernelName(k), i);
+                    return 1;
+                }
+            }
+        }
+        std::printf("validated         %zu boards\n", boards);
+
+        const int rounds = 20;
+        int64_t sink = 0;
+        std::vector<Position> positions;
+        positions.reserve(boards);
+        for (size_t i = 0; i < boards; ++i) positions.push_back(PositionFromBytes(&cells[i * SQUARE_COUNT]));
+        Clock::time_point t0 = Clock::now();
+        for (int r = 0; r < rounds; ++r)
+            for (const Position& pos : positions) sink += Mobility(pos, Player::White) + Mobility(pos, Player::Black);
+        double n = static_cast<double>(boards) * rounds;
+        std::printf("bitboard          %12.0f boards/s (openness only)\n", n / SecondsSince(t0));
+        for (MobilityKernel k : kernels)
+        {
+            if (!MobilityKernelSupported(k)) continue;
+            t0 = Clock::now();
+            for (int r = 0; r < rounds; ++r)
+            {
+                for (size_t i = 0; i < boards; ++i)
+                {
+                    CountMobility(&cells[i * SQUARE_COUNT], counts, k);
+                    sink += counts.openness[0] + counts.reach[i & 63];
+                }
+            }
+            std::printf("%-17s %12.0f boards/s\n", MobilityKernelName(k), n / SecondsSince(t0));
+        }
+        g_sink = sink;
+        return 0;
+    }
+
+    struct SearchConfig
+    {
+        std::string name;
+        SearchOptions options;
+    };
+
+    // "name:opt=v,opt=v"（冒号后可为空，即全部默认）
+    bool ParseSearchConfig(const std::string& text, SearchConfig& out)
+    {
+        size_t colon = text.find(':');
+        out.name = text.substr(0, colon);
+        out.options = SearchOptions();
+        if (out.name.empty()) return false;
+        if (colon == std::string::npos) return true;
+        std::string rest = text.substr(colon + 1);
+        size_t start = 0;
+        while (start < rest.size())
+        {
+            size_t comma = rest.find(',', start);
+            std::string item = rest.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            size_t eq = item.find('=');
+            if (eq == std::string::npos || !SetSearchOption(out.options, item.substr(0, eq), item.substr(eq + 1))) return false;
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        return true;
+    }
+
+    int BenchSearch(int argc, char* argv[])
+    {
+        SearchLimits limits;
+        limits.maxDepth = MAX_PLY;
+        limits.maxTimeMs = 200;
+        size_t positions = 40;
+        uint64_t seed = 1;
+        size_t hashMb = 16;
+        std::vector<SearchConfig> configs;
+        std::vector<std::string> games;
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--movetime") && hasValue) { limits.maxTimeMs = std::atoll(argv[++i]); limits.maxDepth = MAX_PLY; }
+            else if (!std::strcmp(argv[i], "--depth") && hasValue) { limits.maxDepth = std::atoi(argv[++i]); limits.maxTimeMs = 0; }
+            else if (!std::strcmp(argv[i], "--positions") && hasValue) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--hash") && hasValue) hashMb = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--config") && hasValue)
+            {
+                SearchConfig c;
+                if (!ParseSearchConfig(argv[++i], c))
+                {
+                    std::fprintf(stderr, "bad config %s\n", argv[i]);
+                    return 2;
+                }
+                configs.push_back(c);
+            }
+            else if (argv[i][0] != '-') games.push_back(argv[i]);
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        if (configs.empty())
+        {
+            for (const char* c : { "full", "lmr:lmr=on", "futility:futility=on", "lmr+futility:lmr=on,futility=on",
+                                   "lmr-noverify:lmr=on,verify=off" })
+            {
+                configs.emplace_back();
+                ParseSearchConfig(c, configs.back());
+            }
+        }
+
+        // 局面：棋谱中每一手之前的局面（均匀抽取 positions 个），或随机对局
+        std::vector<Position> corpus;
+        for (const std::string& path : games)
+        {
+            GameRecord record;
+            if (!LoadRecord(path, record))
+            {
+                std::fprintf(stderr, "cannot load %s\n", path.c_str());
+                return 1;
+            }
+            Position pos = record.start;
+            for (const RecordedMove& rm : record.moves)
+            {
+                Position before = pos;
+                before.SetSideToMove(rm.player);
+                if (!ApplyRecordedMove(pos, rm)) break;
+                corpus.push_back(before);
+            }
+        }
+        std::vector<Position> selected;
+        if (corpus.empty())
+        {
+            for (const Sample& s : RandomSamples(positions, seed)) selected.push_back(s.position);
+        }
+        else
+        {
+            size_t count = std::min(positions, corpus.size());
+            for (size_t i = 0; i < count; ++i) selected.push_back(corpus[i * corpus.size() / count]);
+        }
+
+        std::printf("positions %zu, limit %s\n", selected.size(),
+                    limits.maxTimeMs ? (std::to_string(limits.maxTimeMs) + " ms").c_str()
+                                     : ("depth " + std::to_string(limits.maxDepth)).c_str());
+        std::printf("%-16s %9s %14s %10s %12s %9s\n", "config", "avg depth", "nodes", "time s", "nodes/s", "same move");
+        std::vector<uint32_t> baseline;
+        for (const SearchConfig& c : configs)
+        {
+            Engine engine(hashMb);
+            engine.SetOptions(c.options);
+            uint64_t nodes = 0;
+            double depthSum = 0.0;
+            size_t same = 0;
+            std::vector<uint32_t> best;
+            Clock::time_point t0 = Clock::now();
+            for (const Position& pos : selected)
+            {
+                engine.NewGame();
+                SearchResult r = engine.Search(pos, limits);
+                nodes += r.nodes;
+                depthSum += r.depth;
+                best.push_back(r.hasMove ? r.bestMove.Code() : NULL_MOVE_CODE);
+                if (!baseline.empty() && best.back() == baseline[best.size() - 1]) ++same;
+            }
+            double sec = SecondsSince(t0);
+            if (baseline.empty()) baseline = best;
+            double n = static_cast<double>(std::max<size_t>(1, selected.size()));
+            std::printf("%-16s %9.2f %14llu %10.2f %12.0f %8.1f%%\n", c.name.c_str(), depthSum / n,
+                        static_cast<unsigned long long>(nodes), sec, sec > 0 ? nodes / sec : 0.0,
+                        &c == &configs[0] ? 100.0 : 100.0 * same / n);
+        }
+        return 0;
+    }
+
+    // 随机对局（走到一方无子可走），记录格式与 GUI 相同
+    GameRecord RandomGame(uint64_t& seed)
+    {
+        GameRecord record;
+        std::unique_ptr<MoveList> moves(new MoveList());
+        Position pos = Position::Initial();
+        for (;;)
+        {
+            GenerateMoves(pos, *moves);
+            if (moves->count == 0) break;
+            RecordedMove rm;
+            rm.player = pos.sideToMove;
+            rm.move = (*moves)[static_cast<int>(SplitMix64(seed) % static_cast<uint64_t>(moves->count))];
+            record.moves.push_back(rm);
+            pos.Play(rm.move);
+        }
+        record.finished = !record.moves.empty();
+        return record;
+    }
+
+    bool SameMoves(const GameRecord& a, const GameRecord& b, size_t count)
+    {
+        if (a.moves.size() < count || b.moves.size() < count) return false;
+        for (size_t i = 0; i < count; ++i)
+            if (a.moves[i].player != b.moves[i].player || a.moves[i].move != b.moves[i].move) return false;
+        return true;
+    }
+
+    // 写出 record 的前 plies 手（不含终局标记），返回是否成功
+    bool WriteJournalPrefix(const std::string& path, const GameRecord& record, size_t plies)
+    {
+        JournalWriter writer;
+        if (!writer.Create(path)) return false;
+        for (size_t i = 0; i < plies; ++i)
+            if (!writer.Append(record.moves[i], false)) return false;
+        return true;
+    }
+
+    // 恢复校验：残缺尾部、损坏记录、Resume 截断后继续追加
+    bool CheckJournalRecovery(const std::string& path, const GameRecord& game)
+    {
+        size_t half = game.moves.size() / 2;
+        GameRecord read;
+        size_t plies = 0;
+
+        // 完整写出整局（最后一手带终局标记）
+        {
+            JournalWriter writer;
+            if (!writer.Create(path)) return false;
+            for (size_t i = 0; i < game.moves.size(); ++i)
+                if (!writer.Append(game.moves[i], i + 1 == game.moves.size())) return false;
+        }
+        if (!ReadJournal(path, read, &plies) || !read.finished || plies != game.moves.size()
+            || !SameMoves(read, game, plies)) return false;
+
+        // 残缺尾部：半条记录
+        if (!WriteJournalPrefix(path, game, half)) return false;
+        {
+            std::FILE* f = std::fopen(path.c_str(), "ab");
+            if (!f) return false;
+            const unsigned char torn[3] = { 1, 2, 3 };
+            std::fwrite(torn, 1, sizeof(torn), f);
+            std::fclose(f);
+        }
+        if (!ReadJournal(path, read, &plies) || read.finished || plies != half || !SameMoves(read, game, half)) return false;
+
+        // 截掉残缺尾部后继续追加剩余各手，应得到完整对局
+        {
+            JournalWriter writer;
+            if (!writer.Resume(path, plies)) return false;
+            for (size_t i = half; i < game.moves.size(); ++i)
+                if (!writer.Append(game.moves[i], i + 1 == game.moves.size())) return false;
+        }
+        if (!ReadJournal(path, read, &plies) || !read.finished || plies != game.moves.size()
+            || !SameMoves(read, game, plies)) return false;
+
+        // 中间一条记录损坏：只保留其前各手
+        {
+            std::FILE* f = std::fopen(path.c_str(), "r+b");
+            if (!f) return false;
+            std::fseek(f, JOURNAL_HEADER_BYTES + static_cast<long>(half) * JOURNAL_RECORD_BYTES + 2, SEEK_SET);
+            std::fputc(static_cast<int>(game.moves[half].move.to ^ 1), f);
+            std::fclose(f);
+        }
+        if (!ReadJournal(path, read, &plies) || read.finished || plies != half || !SameMoves(read, game, half)) return false;
+
+        // 非初始起始局面写入文件头
+        Position start;
+        std::string error;
+        if (!ParseFen("W7/8/3X4/8/8/8/8/6BX b", start, error)) return false;
+        {
+            JournalWriter writer;
+            if (!writer.Create(path, start)) return false;
+        }
+        return ReadJournal(path, read, &plies) && plies == 0 && SamePosition(read.start, start);
+    }
+
+    int BenchJournal(int argc, char* argv[])
+    {
+        size_t gameCount = 200;
+        uint64_t seed = 1;
+        std::string dir = ".";
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--games") && hasValue) gameCount = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--dir") && hasValue) dir = argv[++i];
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        std::vector<GameRecord> games;
+        size_t totalPlies = 0;
+        for (size_t g = 0; g < std::max<size_t>(1, gameCount); ++g)
+        {
+            games.push_back(RandomGame(seed));
+            totalPlies += games.back().moves.size();
+        }
+        std::string journalPath = dir + "/bench_journal.acj";
+        std::string recordPath = dir + "/bench_journal.acp";
+
+        if (!CheckJournalRecovery(journalPath, games[0]))
+        {
+            std::fprintf(stderr, "journal recovery check FAILED\n");
+            std::remove(journalPath.c_str());
+            return 1;
+        }
+        std::printf("recovery check ok (torn tail, corrupt record, resume, start position)\n");
+        std::printf("games %zu, plies %zu (avg %.1f per game)\n", games.size(), totalPlies,
+                    static_cast<double>(totalPlies) / games.size());
+        std::printf("%-26s %12s %14s\n", "mode", "total s", "us per ply");
+
+        struct JournalMode { const char* name; int flushPlies; bool sync; };
+        const JournalMode modes[] = {
+            { "journal flush/ply", 1, false },
+            { "journal flush/8 plies", 8, false },
+            { "journal fsync/ply", 1, true },
+        };
+        for (const JournalMode& m : modes)
+        {
+            Clock::time_point t0 = Clock::now();
+            for (const GameRecord& game : games)
+            {
+                JournalWriter writer;
+                writer.SetFlushPlies(m.flushPlies);
+                writer.SetSyncToDisk(m.sync);
+                if (!writer.Create(journalPath)) return 1;
+                for (size_t i = 0; i < game.moves.size(); ++i)
+                    if (!writer.Append(game.moves[i], i + 1 == game.moves.size())) return 1;
+            }
+            double sec = SecondsSince(t0);
+            std::printf("%-26s %12.3f %14.2f\n", m.name, sec, 1e6 * sec / totalPlies);
+        }
+
+        // 对照：每走一手把整局 .acp 重写一次（Game::SaveToFile 的做法）
+        {
+            Clock::time_point t0 = Clock::now();
+            GameRecord prefix;
+            for (const GameRecord& game : games)
+            {
+                prefix.moves.clear();
+                prefix.finished = false;
+                for (size_t i = 0; i < game.moves.size(); ++i)
+                {
+                    prefix.moves.push_back(game.moves[i]);
+                    prefix.finished = i + 1 == game.moves.size();
+                    if (!SaveRecord(recordPath, prefix)) return 1;
+                }
+            }
+            double sec = SecondsSince(t0);
+            std::printf("%-26s %12.3f %14.2f\n", "rewrite .acp/ply", sec, 1e6 * sec / totalPlies);
+        }
+        std::remove(journalPath.c_str());
+        std::remove(recordPath.c_str());
+        return 0;
+    }
+
+    // 分析缓存的存取规则与过期 / 损坏检测
+    bool CheckAnalysisCache(const std::string& path)
+    {
+        std::remove(path.c_str());
+        const uint64_t key = 0x123456789ABCDEFULL;
+        TranspositionTable::Entry e;
+        {
+            AnalysisCache cache;
+            if (cache.Open(path, 1, 7) != AnalysisCache::OpenResult::Created) return false;
+            if (!cache.Store(key, 5, 40, TranspositionTable::BoundLower, MoveOf(1, 2, 3).Code())) return false;
+            if (cache.Store(key, 4, 10, TranspositionTable::BoundExact, MoveOf(4, 5, 6).Code())) return false; // 更浅：不覆盖
+            if (!cache.Store(key, 5, 50, TranspositionTable::BoundExact, NULL_MOVE_CODE)) return false;       // 同深度精确值：覆盖，保留走法
+            if (cache.Store(key, 5, 60, TranspositionTable::BoundUpper, NULL_MOVE_CODE)) return false;       // 同深度非精确：不覆盖精确值
+            if (!cache.Probe(key, e) || e.depth != 5 || e.score != 50 || e.move != MoveOf(1, 2, 3).Code()) return false;
+        }
+        {
+            AnalysisCache cache;
+            if (cache.Open(path, 1, 7) != AnalysisCache::OpenResult::Loaded) return false;
+            if (!cache.Probe(key, e) || e.score != 50 || e.bound != TranspositionTable::BoundExact) return false;
+        }
+        // 写坏一条：不再命中
+        {
+            std::FILE* f = std::fopen(path.c_str(), "r+b");
+            if (!f) return false;
+            std::vector<unsigned char> bytes(CACHE_ENTRY_BYTES);
+            long at = 0;
+            std::fseek(f, static_cast<long>(CACHE_HEADER_BYTES), SEEK_SET);
+            for (;;)
+            {
+                at = std::ftell(f);
+                if (std::fread(bytes.data(), 1, bytes.size(), f) != bytes.size())
+                {
+                    std::fclose(f);
+                    return false;
+                }
+                if (std::count(bytes.begin(), bytes.end(), 0) != static_cast<long>(bytes.size())) break;
+            }
+            std::fseek(f, at + 3, SEEK_SET);
+            std::fputc(bytes[3] ^ 0x40, f);
+            std::fclose(f);
+        }
+        {
+            AnalysisCache cache;
+            if (cache.Open(path, 1, 7) != AnalysisCache::OpenResult::Loaded || cache.Probe(key, e)) return false;
+            cache.Store(key, 3, 1, TranspositionTable::BoundExact, NULL_MOVE_CODE);
+        }
+        // 评估指纹变化：清空
+        {
+            AnalysisCache cache;
+            if (cache.Open(path, 1, 8) != AnalysisCache::OpenResult::Discarded || cache.Probe(key, e)) return false;
+            cache.Store(key, 3, 1, TranspositionTable::BoundExact, NULL_MOVE_CODE);
+        }
+        // 头部损坏：清空
+        {
+            std::FILE* f = std::fopen(path.c_str(), "r+b");
+            if (!f) return false;
+            std::fseek(f, 20, SEEK_SET);
+            std::fputc(0x5A, f);
+            std::fclose(f);
+        }
+        AnalysisCache cache;
+        return cache.Open(path, 1, 8) == AnalysisCache::OpenResult::Discarded && !cache.Probe(key, e);
+    }
+
+    int BenchCache(int argc, char* argv[])
+    {
+        size_t positions = 20;
+        int depth = 3;
+        size_t hashMb = 32;
+        size_t cacheMb = 16;
+        uint64_t seed = 1;
+        std::string dir = ".";
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--positions") && hasValue) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--depth") && hasValue) depth = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i], "--hash") && hasValue) hashMb = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--cache-mb") && hasValue) cacheMb = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--dir") && hasValue) dir = argv[++i];
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        std::string path = dir + "/bench_cache.acc";
+        if (!CheckAnalysisCache(path))
+        {
+            std::fprintf(stderr, "analysis cache check FAILED\n");
+            std::remove(path.c_str());
+            return 1;
+        }
+        std::printf("cache check ok (replacement, reopen, corrupt entry, fingerprint, corrupt header)\n");
+        std::remove(path.c_str());
+
+        // 从随机对局中段取局面（开局局面之间差别太小）
+        std::vector<Sample> all = RandomSamples(positions * 40, seed);
+        std::vector<Position> set;
+        for (size_t i = 0; i < all.size() && set.size() < positions; i += 40) set.push_back(all[i + 10].position);
+
+        SearchLimits limits;
+        limits.maxDepth = depth;
+        std::vector<Move> coldMoves;
+        const char* names[2] = { "cold", "warm from cache" };
+        for (int session = 0; session < 2; ++session)
+        {
+            AnalysisCache cache;
+            if (cache.Open(path, cacheMb, 0) == AnalysisCache::OpenResult::Failed)
+            {
+                std::fprintf(stderr, "cannot open %s\n", path.c_str());
+                return 1;
+            }
+            Engine engine(hashMb);
+            Clock::time_point w0 = Clock::now();
+            size_t warmed = cache.WarmTable(engine.Table());
+            double warmMs = 1e3 * SecondsSince(w0);
+            uint64_t nodes = 0;
+            size_t same = 0;
+            Clock::time_point t0 = Clock::now();
+            for (size_t i = 0; i < set.size(); ++i)
+            {
+                SearchResult r = engine.Search(set[i], limits);
+                nodes += r.nodes;
+                if (session == 0) coldMoves.push_back(r.bestMove);
+                else if (r.bestMove == coldMoves[i]) ++same;
+            }
+            double sec = SecondsSince(t0);
+            Clock::time_point a0 = Clock::now();
+            size_t stored = cache.Absorb(engine.Table(), 2);
+            cache.Flush();
+            double absorbMs = 1e3 * SecondsSince(a0);
+            std::printf("%-16s warmed %8zu entries (%6.1f ms)  search %8.3f s %12llu nodes", names[session], warmed, warmMs,
+                        sec, static_cast<unsigned long long>(nodes));
+            if (session == 1) std::printf("  same best move %zu/%zu", same, set.size());
+            std::printf("  stored %zu (%.1f ms)\n", stored, absorbMs);
+        }
+        std::remove(path.c_str());
+        return 0;
+    }
+
+    // 进程中透明大页的总量（KB），读不到时为 -1
+    long AnonHugePagesKb()
+    {
+        std::ifstream ifs("/proc/self/smaps_rollup");
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            if (line.compare(0, 14, "AnonHugePages:") == 0)
+                return std::atol(line.c_str() + 14);
+        }
+        return -1;
+    }
+
+    int BenchTable(int argc, char* argv[])
+    {
+        size_t hashMb = 1024;
+        size_t probes = 4000000;
+        size_t positions = 8;
+        int depth = 3;
+        uint64_t seed = 1;
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--hash") && hasValue) hashMb = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--probes") && hasValue) probes = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--positions") && hasValue) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--depth") && hasValue) depth = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        std::vector<Sample> all = RandomSamples(positions * 40, seed);
+        std::vector<Position> set;
+        for (size_t i = 0; i < all.size() && set.size() < positions; i += 40) set.push_back(all[i + 10].position);
+
+        struct MemoryMode { const char* name; TableMemoryOptions options; };
+        MemoryMode modes[3] = { { "4k pages", {} }, { "hugepages", {} }, { "hugepages+numa", {} } };
+        modes[0].options.hugePages = false;
+        modes[2].options.interleaveNodes = true;
+
+        std::printf("hash %zu MB, %zu probes, %zu positions at depth %d\n", hashMb, probes, set.size(), depth);
+        std::printf("%-16s %6s %6s %10s %14s %14s %14s %14s\n", "memory", "thp", "numa", "thp MB",
+                    "chain ns/probe", "pref ns/probe", "nps no-pref", "nps prefetch");
+        for (const MemoryMode& mode : modes)
+        {
+            long hugeBefore = AnonHugePagesKb();
+            std::shared_ptr<TranspositionTable> tt = std::make_shared<TranspositionTable>(hashMb, mode.options);
+            // 写满整张表，使每个页面都已落位
+            uint64_t state = seed;
+            size_t slots = tt->SizeInBytes() / 16;
+            for (size_t i = 0; i < slots; ++i)
+                tt->Store(SplitMix64(state), 1 + static_cast<int>(i % 8), 0, TranspositionTable::BoundExact, 0);
+            long hugeMb = hugeBefore >= 0 ? (AnonHugePagesKb() - hugeBefore) / 1024 : -1;
+
+            // 相互依赖的探查链：下一次的键取决于本次结果，测的是单次访存延迟
+            TranspositionTable::Entry e;
+            uint64_t key = seed, hits = 0;
+            Clock::time_point t0 = Clock::now();
+            for (size_t i = 0; i < probes; ++i)
+            {
+                if (tt->Probe(key, e)) ++hits;
+                key = SplitMix64(key) ^ static_cast<uint64_t>(e.depth);
+            }
+            double chainNs = 1e9 * SecondsSince(t0) / std::max<size_t>(1, probes);
+
+            // 独立探查，提前 8 个键预取
+            std::vector<uint64_t> keys(probes);
+            state = seed + 1;
+            for (uint64_t& k : keys) k = SplitMix64(state);
+            t0 = Clock::now();
+            for (size_t i = 0; i < probes; ++i)
+            {
+                if (i + 8 < probes) tt->Prefetch(keys[i + 8]);
+                if (tt->Probe(keys[i], e)) ++hits;
+            }
+            double prefetchNs = 1e9 * SecondsSince(t0) / std::max<size_t>(1, probes);
+            g_sink += static_cast<int64_t>(hits);
+
+            double nps[2] = { 0.0, 0.0 };
+            for (int prefetch = 0; prefetch < 2; ++prefetch)
+            {
+                Engine engine(tt);
+                SearchOptions options;
+                options.ttPrefetch = prefetch != 0;
+                engine.SetOptions(options);
+                SearchLimits limits;
+                limits.maxDepth = depth;
+                uint64_t nodes = 0;
+                tt->Clear();
+                t0 = Clock::now();
+                for (const Position& pos : set) nodes += engine.Search(pos, limits).nodes;
+                double sec = SecondsSince(t0);
+                nps[prefetch] = sec > 0 ? nodes / sec : 0.0;
+            }
+            char hugeText[24];
+            if (hugeMb >= 0) std::snprintf(hugeText, sizeof(hugeText), "%ld", hugeMb);
+            else std::snprintf(hugeText, sizeof(hugeText), "n/a");
+            std::printf("%-16s %6s %6s %10s %14.1f %14.1f %14.0f %14.0f\n", mode.name, tt->HugePagesApplied() ? "yes" : "no",
+                        tt->InterleaveApplied() ? "yes" : "no", hugeText, chainNs, prefetchNs, nps[0], nps[1]);
+        }
+        return 0;
+    }
+
+    int BenchMcts(int argc, char* argv[])
+    {
+        uint64_t playouts = 20000;
+        size_t positions = 8;
+        uint64_t seed = 1;
+        int refDepth = 2;
+        MctsOptions widened;
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--playouts") && hasValue) playouts = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--positions") && hasValue) positions = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--ref-depth") && hasValue) refDepth = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i], "--widen-base") && hasValue) widened.widenBase = std::atof(argv[++i]);
+            else if (!std::strcmp(argv[i], "--widen-exp") && hasValue) widened.widenExponent = std::atof(argv[++i]);
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        // 初始局面加各自独立的随机对局走到第 4、10、16 ... 手的局面（开局到中局）
+        std::vector<Position> set(1, Position::Initial());
+        std::unique_ptr<MoveList> list(new MoveList());
+        for (size_t p = 1; p < positions; ++p)
+        {
+            Position pos = Position::Initial();
+            for (size_t ply = 0; ply < 4 + 6 * (p - 1); ++ply)
+            {
+                GenerateMoves(pos, *list);
+                if (list->count == 0) break;
+                pos.Play((*list)[static_cast<int>(SplitMix64(seed) % static_cast<uint64_t>(list->count))]);
+            }
+            set.push_back(pos);
+        }
+
+        std::vector<Move> reference;
+        {
+            Engine engine(16);
+            SearchLimits limits;
+            limits.maxDepth = refDepth;
+            for (const Position& pos : set) reference.push_back(engine.Search(pos, limits).bestMove);
+        }
+
+        MctsOptions full = widened;
+        full.progressiveWidening = false;
+        full.innerMoveCap = 0;
+        struct Mode { const char* name; MctsOptions options; };
+        const Mode modes[2] = { { "full expansion", full }, { "progressive", widened } };
+        std::printf("%zu positions, %llu playouts each, reference: depth-%d alpha-beta\n", set.size(),
+                    static_cast<unsigned long long>(playouts), refDepth);
+        for (const Mode& mode : modes)
+        {
+            std::printf("%s:\n  %4s %6s %12s %10s %8s\n", mode.name, "pos", "moves", "converged at", "tree nodes", "matches");
+            Mcts mcts(mode.options);
+            std::vector<uint64_t> converged;
+            size_t matches = 0;
+            double seconds = 0.0;
+            std::unique_ptr<MoveList> moves(new MoveList());
+            for (size_t p = 0; p < set.size(); ++p)
+            {
+                // 逐次模拟，记录访问最多的根子节点最后一次改变的位置
+                mcts.SetRoot(set[p]);
+                uint64_t lastChange = 0;
+                Move current = MoveOf(0, 0, 0);
+                bool have = false;
+                Clock::time_point t0 = Clock::now();
+                for (uint64_t i = 1; i <= playouts; ++i)
+                {
+                    mcts.Playout();
+                    MctsResult r = mcts.Result();
+                    if (r.hasMove && (!have || r.bestMove != current))
+                    {
+                        current = r.bestMove;
+                        have = true;
+                        lastChange = i;
+                    }
+                }
+                seconds += SecondsSince(t0);
+                MctsResult r = mcts.Result();
+                bool match = r.hasMove && r.bestMove == reference[p];
+                matches += match ? 1 : 0;
+                converged.push_back(lastChange);
+                GenerateMoves(set[p], *moves);
+                std::printf("  %4zu %6d %12llu %10zu %8s\n", p, moves->count, static_cast<unsigned long long>(lastChange),
+                            r.treeNodes, match ? "yes" : "no");
+            }
+            std::vector<uint64_t> sorted = converged;
+            std::sort(sorted.begin(), sorted.end());
+            double mean = 0.0;
+            for (uint64_t c : converged) mean += static_cast<double>(c);
+            mean /= static_cast<double>(converged.size());
+            std::printf("  converged: mean %.0f, median %llu playouts; matches reference %zu/%zu; %.0f playouts/s\n", mean,
+                        static_cast<unsigned long long>(sorted[sorted.size() / 2]), matches, set.size(),
+                        seconds > 0 ? playouts * set.size() / seconds : 0.0);
+        }
+        return 0;
+    }
+
+#if !defined(_WIN32)
+    struct ProtocolCase
+    {
+        const char* name;
+        std::vector<std::string> setup;  // go 之前发送的命令
+        const char* go;
+        int stopDelayMs;                 // go 与 stop 之间的间隔，0 = 紧接着发送
+        const char* expect;              // 要求的 bestmove 行，nullptr = 任意
+    };
+
+    static constexpr int PROTOCOL_TIMEOUT_MS = 5000;
+
+    // 在新启动的引擎进程上运行一例：应在超时前先收到恰好一条 bestmove，再收到 readyok
+    bool RunProtocolCase(const std::string& enginePath, const ProtocolCase& c, std::string& failure)
+    {
+        ChildProcess engine;
+        if (!engine.Start(enginePath))
+        {
+            failure = "cannot start " + enginePath;
+            return false;
+        }
+        for (const std::string& cmd : c.setup) engine.WriteLine(cmd);
+        engine.WriteLine(c.go);
+        if (c.stopDelayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(c.stopDelayMs));
+        engine.WriteLine("stop");
+        engine.WriteLine("isready");
+
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(PROTOCOL_TIMEOUT_MS);
+        bool bestmove = false;
+        std::string line;
+        for (;;)
+        {
+            int left = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+            ChildProcess::ReadStatus status = left > 0 ? engine.ReadLine(line, left) : LineChannel::ReadTimeout;
+            if (status != LineChannel::ReadOk)
+            {
+                failure = status == LineChannel::ReadTimeout
+                    ? (bestmove ? "no readyok" : "no bestmove") + std::string(" within timeout")
+                    : std::string("engine exited");
+                return false;
+            }
+            if (line.compare(0, 9, "bestmove ") == 0)
+            {
+                if (bestmove) { failure = "second bestmove"; return false; }
+                if (c.expect && line != c.expect) { failure = "unexpected " + line; return false; }
+                bestmove = true;
+            }
+            else if (line == "readyok")
+            {
+                if (!bestmove) { failure = "readyok before bestmove"; return false; }
+                engine.WriteLine("quit");
+                return true;
+            }
+            else if (line.compare(0, 6, "error ") == 0)
+            {
+                failure = line;
+                return false;
+            }
+        }
+    }
+
+    int BenchProtocol(int argc, char* argv[])
+    {
+        std::string enginePath = "./AmazonEngine";
+        int rounds = 20;
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--engine") && hasValue) enginePath = argv[++i];
+            else if (!std::strcmp(argv[i], "--rounds") && hasValue) rounds = std::atoi(argv[++i]);
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        std::signal(SIGPIPE, SIG_IGN);
+
+        const std::vector<std::string> start = { "position startpos" };
+        const std::vector<std::string> solver = { "setoption solver-arrows 0", "setoption solver-nodes 1000000000", "position startpos" };
+        const ProtocolCase cases[] = {
+            { "go infinite, stop at once", start, "go infinite", 0, nullptr },
+            { "go infinite, stop after 20 ms", start, "go infinite", 20, nullptr },
+            { "go depth 3, stop at once", start, "go depth 3", 0, nullptr },
+            // 求解模式：开局局面上求解不会结束，stop 须中止求解并照常给出走法
+            { "solver mode, stop at once", solver, "go infinite", 0, nullptr },
+            { "solver mode, stop after 20 ms", solver, "go infinite", 20, nullptr },
+            { "go solve, stop at once", start, "go solve", 0, "bestmove none" },
+            { "go solve, stop after 20 ms", start, "go solve", 20, "bestmove none" },
+        };
+        int failures = 0;
+        for (const ProtocolCase& c : cases)
+        {
+            int passed = 0;
+            std::string firstFailure;
+            for (int r = 0; r < rounds; ++r)
+            {
+                std::string failure;
+                if (RunProtocolCase(enginePath, c, failure)) ++passed;
+                else if (firstFailure.empty()) firstFailure = failure;
+            }
+            std::printf("%-36s %3d/%d%s%s\n", c.name, passed, rounds,
+                        firstFailure.empty() ? "" : "  FAILED: ", firstFailure.c_str());
+            failures += rounds - passed;
+        }
+        if (failures)
+        {
+            std::fprintf(stderr, "protocol check FAILED\n");
+            return 1;
+        }
+        return 0;
+    }
+#endif
+
+#if !defined(_WIN32)
+    // 左右镜像一局：初始局面关于竖直中线对称，镜像后的对局同样合法
+    GameRecord MirrorGame(const GameRecord& record)
+    {
+        GameRecord out = record;
+        auto mirror = [](int sq) { Pos p = PosOf(sq); return SquareOf(BOARD_SIZE - 1 - p.x, p.y); };
+        for (RecordedMove& rm : out.moves) rm.move = MoveOf(mirror(rm.move.from), mirror(rm.move.to), mirror(rm.move.arrow));
+        return out;
+    }
+
+    std::string ShellQuote(const std::string& s)
+    {
+        std::string out = "'";
+        for (char c : s) out += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        return out + "'";
+    }
+
+    // 运行一次 AmazonDedup，读出归并趟数与 --out-list 中保留的路径
+    bool RunDedup(const std::string& command, const std::string& outList, size_t& passes,
+                  std::vector<std::string>& kept, std::string& failure)
+    {
+        ChildProcess dedup;
+        if (!dedup.Start(command))
+        {
+            failure = "cannot start " + command;
+            return false;
+        }
+        passes = 0;
+        bool summary = false;
+        std::string line;
+        for (;;)
+        {
+            ChildProcess::ReadStatus status = dedup.ReadLine(line, 60000);
+            if (status == LineChannel::ReadTimeout)
+            {
+                failure = "no exit within timeout";
+                return false;
+            }
+            if (status == LineChannel::ReadEof) break;
+            size_t runs;
+            if (std::sscanf(line.c_str(), "runs %zu, merge passes %zu", &runs, &passes) == 2) summary = true;
+        }
+        dedup.Terminate();
+        if (!summary)
+        {
+            failure = "no summary line";
+            return false;
+        }
+        kept.clear();
+        std::ifstream ifs(outList);
+        while (std::getline(ifs, line)) kept.push_back(line);
+        return true;
+    }
+
+    int BenchDedup(int argc, char* argv[])
+    {
+        std::string dedupPath = "./AmazonDedup";
+        size_t gameCount = 200;
+        uint64_t seed = 1;
+        std::string dir = ".";
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--dedup") && hasValue) dedupPath = argv[++i];
+            else if (!std::strcmp(argv[i], "--games") && hasValue) gameCount = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--dir") && hasValue) dir = argv[++i];
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        std::signal(SIGPIPE, SIG_IGN);
+        gameCount = std::max<size_t>(1, gameCount);
+
+        // 先写全部原局，再写副本：每 3 局一份完全相同的副本，每 4 局一份左右镜像
+        std::vector<GameRecord> games;
+        for (size_t g = 0; g < gameCount; ++g) games.push_back(RandomGame(seed));
+        std::vector<std::string> paths, originals, mirrors;
+        bool ok = true;
+        auto write = [&](const GameRecord& record) {
+            char name[48];
+            std::snprintf(name, sizeof(name), "/bench_dedup_%05zu.acp", paths.size());
+            paths.push_back(dir + name);
+            ok = SaveRecord(paths.back(), record) && ok;
+            return paths.back();
+        };
+        for (const GameRecord& g : games) originals.push_back(write(g));
+        for (size_t g = 0; g < gameCount; ++g)
+        {
+            if (g % 3 == 0) write(games[g]);
+            if (g % 4 == 0) mirrors.push_back(write(MirrorGame(games[g])));
+        }
+        std::string listPath = dir + "/bench_dedup.list";
+        std::string outPath = dir + "/bench_dedup_out.list";
+        {
+            std::ofstream list(listPath);
+            for (const std::string& p : paths) list << p << "\n";
+            ok = ok && static_cast<bool>(list);
+        }
+        auto cleanup = [&]() {
+            for (const std::string& p : paths) std::remove(p.c_str());
+            std::remove(listPath.c_str());
+            std::remove(outPath.c_str());
+        };
+        if (!ok)
+        {
+            std::fprintf(stderr, "cannot write games to %s\n", dir.c_str());
+            cleanup();
+            return 1;
+        }
+        // 保留的是每组中输入最早的一份：不去对称时为原局与镜像，去对称时只有原局
+        std::vector<std::string> expectPlain = originals;
+        expectPlain.insert(expectPlain.end(), mirrors.begin(), mirrors.end());
+        std::printf("games %zu (files %zu: %zu exact copies, %zu mirrored copies)\n", gameCount, paths.size(),
+                    paths.size() - gameCount - mirrors.size(), mirrors.size());
+
+        struct DedupCase { const char* name; const char* options; bool multiPass; const std::vector<std::string>* expect; };
+        const DedupCase cases[] = {
+            { "exact, --memory 0", "--memory 0", true, &expectPlain },
+            { "exact, single pass", "", false, &expectPlain },
+            { "symmetric, --memory 0", "--symmetric --memory 0", true, &originals },
+            { "symmetric, single pass", "--symmetric", false, &originals },
+        };
+        int failures = 0;
+        for (const DedupCase& c : cases)
+        {
+            std::string command = ShellQuote(dedupPath) + " --list " + ShellQuote(listPath) + " --out-list " + ShellQuote(outPath)
+                + " --temp " + ShellQuote(dir) + " " + c.options;
+            size_t passes = 0;
+            std::vector<std::string> kept;
+            std::string failure;
+            if (RunDedup(command, outPath, passes, kept, failure))
+            {
+                // 多于 MAX_MERGE_FAN_IN（128）个段时至少两趟
+                if (c.multiPass ? passes < 2 : passes != 1) failure = "merge passes " + std::to_string(passes);
+                else if (kept != *c.expect) failure = "kept " + std::to_string(kept.size()) + ", expected " + std::to_string(c.expect->size());
+            }
+            std::printf("%-26s passes %zu  kept %4zu%s%s\n", c.name, passes, kept.size(),
+                        failure.empty() ? "" : "  FAILED: ", failure.c_str());
+            if (!failure.empty()) ++failures;
+        }
+        cleanup();
+        if (failures)
+        {
+            std::fprintf(stderr, "dedup check FAILED\n");
+            return 1;
+        }
+        return 0;
+    }
+#endif
+
+    struct Command
+    {
+        const char* name;
+        int (*run)(int argc, char* argv[]);
+    };
+
+    const Command g_commands[] = {
+        { "eval", BenchEval },
+        { "batch", BenchBatch },
+        { "mobility", BenchMobility },
+        { "search", BenchSearch },
+        { "journal", BenchJournal },
+        { "cache", BenchCache },
+        { "tt", BenchTable },
+        { "mcts", BenchMcts },
+#if !defined(_WIN32)
+        { "protocol", BenchProtocol },
+        { "dedup", BenchDedup },
+#endif
+    };
+
+    void Usage()
+    {
+        std::fprintf(stderr, "usage: AmazonBench <command> [options]\ncommands:");
+        for (const Command& c : g_commands) std::fprintf(stderr, " %s", c.name);
+        std::fprintf(stderr, "\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        Usage();
+        return 2;
+    }
+    for (const Command& c : g_commands)
+    {
+        if (!std::strcmp(argv[1], c.name)) return c.run(argc - 2, argv + 2);
+    }
+    Usage();
+    return 2;
+}
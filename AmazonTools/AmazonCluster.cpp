@@ -0,0 +1,687 @@
+﻿// AmazonCluster.cpp : 多进程分布式自对弈 / 局面分析（Linux，单机）
+// coordinator 监听本机套接字并按需启动 N 个 worker 进程（同一可执行文件的 worker 子命令），
+// 逐个分派对局（game）或局面（analyse）任务，收集结果写为 .acp、训练分片（AmazonShard.h）与 JSONL。
+// worker 是独立进程：某个 worker 崩溃或超时只会让它手上的任务重新排队，由其它 worker 重做，
+// 由 coordinator 启动的 worker 退出后会被重新拉起。对局任务只由 seed 与局号决定，重做得到同一局。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonCluster.cpp -o AmazonCluster
+//
+// 用法：
+//   AmazonCluster coordinator [选项]
+//     --listen <addr>        监听地址（unix:<path> 或 tcp:<port>，默认 unix:/tmp/amazon-cluster-<pid>.sock）
+//     --workers <n>          启动的 worker 进程数（默认硬件线程数；0 = 只等待外部 worker 连接）
+//     --games <n>            自对弈对局数（默认 0）
+//     --positions <file>     分析任务列表：每行 "<path.acp> [ply]"，省略 ply 取终局局面
+//     --depth / --nodes / --movetime / --random-plies / --seed / --hash   引擎与自对弈设置（同 AmazonSelfPlay）
+//     --out <prefix>         对局样本分片前缀（默认 cluster）
+//     --games-dir <dir>      每局写为 <dir>/game_<局号>.acp（默认不写）
+//     --analysis-out <file>  分析结果 JSONL（默认 stdout）
+//     --inflight <n>         每个 worker 同时持有的任务数（默认 2）
+//     --job-timeout <s>      worker 在此时间内没有任何应答则视为失去响应，结束它并重派任务（默认 0 = 不限）
+//     --max-restarts <n>     worker 重启次数上限（默认 100）
+//   AmazonCluster worker --connect <addr>
+//
+// coordinator 与 worker 之间为按行文本协议：
+//   worker -> hello <pid>
+//   coord  -> config depth d nodes n movetime ms randomplies k seed s hash mb
+//   coord  -> game <局号>        worker -> game <局号> winner <w|b|-> moves <m> ... samples <hex> ...
+//   coord  -> analyse <编号> <go 参数> position startpos ...
+//                                worker -> analysed <编号> move <m|none> score s depth d nodes n
+//   coord  -> quit
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include "AmazonJson.h"
+#include "AmazonLineIO.h"
+#include "AmazonProcess.h"
+#include "AmazonProtocol.h"
+#include "AmazonRecord.h"
+#include "AmazonSelfPlay.h"
+#include "AmazonSocket.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    volatile std::sig_atomic_t g_interrupted = 0;
+
+    void OnInterrupt(int)
+    {
+        g_interrupted = 1;
+    }
+
+    std::string ToHex(const unsigned char* data, size_t size)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string s;
+        s.reserve(size * 2);
+        for (size_t i = 0; i < size; ++i)
+        {
+            s += digits[data[i] >> 4];
+            s += digits[data[i] & 15];
+        }
+        return s;
+    }
+
+    bool FromHex(const std::string& s, unsigned char* out, size_t size)
+    {
+        if (s.size() != size * 2) return false;
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+        for (size_t i = 0; i < size; ++i)
+        {
+            int hi = nibble(s[2 * i]), lo = nibble(s[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out[i] = static_cast<unsigned char>(hi * 16 + lo);
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------------- worker
+
+    int RunWorker(int argc, char* argv[])
+    {
+        std::string address;
+        for (int i = 0; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--connect" && i + 1 < argc) address = argv[++i];
+        }
+        int fd = ConnectTo(address);
+        if (fd < 0)
+        {
+            std::cerr << "worker: cannot connect to " << address << "\n";
+            return 1;
+        }
+        std::signal(SIGPIPE, SIG_IGN);
+        LineChannel channel;
+        channel.Attach(fd, fd);
+        channel.WriteLine("hello " + std::to_string(getpid()));
+
+        SelfPlaySettings settings;
+        std::unique_ptr<Engine> engine(new Engine(16));
+        std::unique_ptr<MoveList> moves(new MoveList());
+        SelfPlayGame game;
+        std::string line;
+        while (channel.ReadLine(line, -1) == LineChannel::ReadOk)
+        {
+            std::vector<std::string> t = SplitTokens(line);
+            if (t.empty()) continue;
+            if (t[0] == "quit") break;
+            if (t[0] == "config")
+            {
+                for (size_t i = 1; i + 1 < t.size(); i += 2)
+                {
+                    const std::string& key = t[i];
+                    const char* value = t[i + 1].c_str();
+                    if (key == "depth") settings.limits.maxDepth = std::atoi(value);
+                    else if (key == "nodes") settings.limits.maxNodes = std::strtoull(value, nullptr, 10);
+                    else if (key == "movetime") settings.limits.maxTimeMs = std::atoll(value);
+                    else if (key == "randomplies") settings.randomPlies = std::atoi(value);
+                    else if (key == "seed") settings.seed = std::strtoull(value, nullptr, 10);
+                    else if (key == "hash") engine.reset(new Engine(std::strtoul(value, nullptr, 10)));
+                }
+            }
+            else if (t[0] == "game" && t.size() == 2)
+            {
+                uint64_t index = std::strtoull(t[1].c_str(), nullptr, 10);
+                PlaySelfPlayGame(*engine, *moves, settings, index, game);
+                std::string reply = "game " + t[1] + " winner "
+                    + (game.winner == Player::White ? "w" : game.winner == Player::Black ? "b" : "-") + " moves";
+                for (const Move& m : game.moves) reply += " " + MoveToToken(m);
+                reply += " samples";
+                unsigned char encoded[SHARD_SAMPLE_BYTES];
+                for (const TrainingSample& s : game.samples)
+                {
+                    EncodeSample(s, encoded);
+                    reply += " " + ToHex(encoded, sizeof(encoded));
+                }
+                if (!channel.WriteLine(reply)) break;
+            }
+            else if (t[0] == "analyse" && t.size() >= 2)
+            {
+                SearchLimits limits;
+                limits.maxDepth = MAX_PLY;
+                size_t i = 2;
+                for (; i < t.size() && t[i] != "position"; ++i)
+                {
+                    if (i + 1 >= t.size()) break;
+                    if (t[i] == "depth") limits.maxDepth = std::atoi(t[++i].c_str());
+                    else if (t[i] == "nodes") limits.maxNodes = std::strtoull(t[++i].c_str(), nullptr, 10);
+                    else if (t[i] == "movetime") limits.maxTimeMs = std::atoll(t[++i].c_str());
+                }
+                Position pos;
+                std::string error;
+                std::string reply = "analysed " + t[1];
+                if (i < t.size() && ParsePosition(t, i + 1, pos, error))
+                {
+                    engine->NewGame();
+                    SearchResult r = engine->Search(pos, limits);
+                    reply += " move " + (r.hasMove ? MoveToToken(r.bestMove) : std::string("none"))
+                        + " score " + std::to_string(r.score) + " depth " + std::to_string(r.depth)
+                        + " nodes " + std::to_string(r.nodes);
+                }
+                else reply += " error";
+                if (!channel.WriteLine(reply)) break;
+            }
+        }
+        return 0;
+    }
+
+    // ----------------------------------------------------------- coordinator
+
+    struct AnalysisJob
+    {
+        std::string source;
+        int ply = 0;
+        std::string position; // "position startpos ..." 协议写法
+    };
+
+    // 任务编号：对局为局号，分析任务为 ANALYSIS_BASE + 下标
+    static const uint64_t ANALYSIS_BASE = uint64_t(1) << 62;
+
+    struct WorkerConnection
+    {
+        std::unique_ptr<LineChannel> channel;
+        pid_t pid = -1;                // hello 中报告的进程号
+        std::vector<uint64_t> inFlight;
+        Clock::time_point lastActivity;
+        bool dead = false;
+    };
+
+    struct CoordinatorConfig
+    {
+        std::string address;
+        size_t spawn = 1;
+        uint64_t games = 0;
+        SelfPlaySettings settings;
+        size_t hashMb = 16;
+        std::string outPrefix = "cluster";
+        std::string gamesDir;
+        std::string analysisOut;
+        size_t inflight = 2;
+        int jobTimeoutSec = 0;
+        int maxRestarts = 100;
+        std::string self;
+    };
+
+    class Coordinator
+    {
+    public:
+        Coordinator(const CoordinatorConfig& config, std::vector<AnalysisJob> analysis)
+            : config(config), analysis(std::move(analysis)), analysisDone(this->analysis.size(), false),
+              writer(config.outPrefix, 1000000, 65536)
+        {
+        }
+
+        int Run()
+        {
+            listenFd = ListenOn(config.address);
+            if (listenFd < 0)
+            {
+                std::cerr << "cannot listen on " << config.address << "\n";
+                return 1;
+            }
+            if (!config.analysisOut.empty())
+            {
+                analysisFile.open(config.analysisOut, std::ios::binary);
+                if (!analysisFile.is_open())
+                {
+                    std::cerr << "cannot open " << config.analysisOut << "\n";
+                    return 1;
+                }
+            }
+            for (size_t i = 0; i < config.spawn; ++i) Spawn();
+            start = Clock::now();
+
+            while (!Finished() && !g_interrupted && !writeFailed)
+            {
+                std::vector<pollfd> fds;
+                fds.push_back({ listenFd, POLLIN, 0 });
+                for (auto& w : workers) fds.push_back({ w.channel->ReadDescriptor(), POLLIN, 0 });
+                // 需要定期检查子进程与超时，其余时间阻塞在套接字上
+                int r = poll(fds.data(), fds.size(), 500);
+                if (r < 0 && errno != EINTR) break;
+                if (r > 0)
+                {
+                    if (fds[0].revents & POLLIN) Accept();
+                    for (size_t i = 0; i + 1 < fds.size() && i < workers.size(); ++i)
+                        if (fds[i + 1].revents) ReadWorker(workers[i]);
+                }
+                CheckTimeouts();
+                ReapAndRespawn();
+                RemoveDead();
+                Dispatch();
+            }
+
+            for (auto& w : workers) w.channel->WriteLine("quit");
+            workers.clear();
+            for (pid_t pid : children) waitpid(pid, nullptr, 0);
+            close(listenFd);
+            if (config.address.compare(0, 5, "unix:") == 0) unlink(config.address.c_str() + 5);
+            writer.Close();
+            if (analysisFile.is_open()) analysisFile.close();
+
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            std::fprintf(stderr, "%sgames %llu  analysed %zu  samples %llu  %.1f s  restarts %d  reassigned %llu\n",
+                         writeFailed ? "write failed: " : g_interrupted ? "interrupted: " : "finished: ",
+                         static_cast<unsigned long long>(gamesDone), analysedCount,
+                         static_cast<unsigned long long>(writer.SamplesWritten()), sec, restarts,
+                         static_cast<unsigned long long>(reassigned));
+            return g_interrupted || writeFailed ? 1 : 0;
+        }
+
+    private:
+        bool Finished() const
+        {
+            return gamesDone >= config.games && analysedCount >= analysis.size();
+        }
+
+        void Spawn()
+        {
+            pid_t pid = SpawnProcess({ config.self, "worker", "--connect", config.address });
+            if (pid > 0) children.push_back(pid);
+        }
+
+        void Accept()
+        {
+            int fd = AcceptOn(listenFd);
+            if (fd < 0) return;
+            WorkerConnection w;
+            w.channel.reset(new LineChannel());
+            w.channel->Attach(fd, fd);
+            w.lastActivity = Clock::now();
+            char buf[160];
+            std::snprintf(buf, sizeof(buf), "config depth %d nodes %llu movetime %lld randomplies %d seed %llu hash %zu",
+                          config.settings.limits.maxDepth,
+                          static_cast<unsigned long long>(config.settings.limits.maxNodes),
+                          static_cast<long long>(config.settings.limits.maxTimeMs), config.settings.randomPlies,
+                          static_cast<unsigned long long>(config.settings.seed), config.hashMb);
+            if (w.channel->WriteLine(buf)) workers.push_back(std::move(w));
+        }
+
+        // 读出该连接上所有完整的行；连接断开即标记为失效
+        void ReadWorker(WorkerConnection& w)
+        {
+            std::string line;
+            for (;;)
+            {
+                LineChannel::ReadStatus st = w.channel->ReadLine(line, 0);
+                if (st == LineChannel::ReadTimeout) return;
+                if (st == LineChannel::ReadEof)
+                {
+                    w.dead = true;
+                    return;
+                }
+                w.lastActivity = Clock::now();
+                std::vector<std::string> t = SplitTokens(line);
+                if (t.size() >= 2 && t[0] == "hello") w.pid = static_cast<pid_t>(std::atoi(t[1].c_str()));
+                else if (t.size() >= 2 && t[0] == "game") HandleGame(w, t);
+                else if (t.size() >= 2 && t[0] == "analysed") HandleAnalysed(w, t);
+            }
+        }
+
+        // 从 inFlight 中移除；不在其中（迟到的重复结果）返回 false
+        static bool Complete(WorkerConnection& w, uint64_t job)
+        {
+            auto it = std::find(w.inFlight.begin(), w.inFlight.end(), job);
+            if (it == w.inFlight.end()) return false;
+            w.inFlight.erase(it);
+            return true;
+        }
+
+        void HandleGame(WorkerConnection& w, const std::vector<std::string>& t)
+        {
+            uint64_t index = std::strtoull(t[1].c_str(), nullptr, 10);
+            if (!Complete(w, index)) return;
+
+            // 重放校验走法，同时得到 .acp 记谱与样本
+            GameRecord record;
+            std::vector<TrainingSample> samples;
+            Position pos = Position::Initial();
+            bool ok = t.size() >= 5 && t[2] == "winner" && t[4] == "moves";
+            size_t i = 5;
+            for (; ok && i < t.size() && t[i] != "samples"; ++i)
+            {
+                Move m;
+                if (!ParseMoveToken(t[i], m) || !IsLegalMove(pos, m)) ok = false;
+                else
+                {
+                    record.moves.push_back({ pos.sideToMove, m });
+                    pos.Play(m);
+                }
+            }
+            for (++i; ok && i < t.size(); ++i)
+            {
+                unsigned char encoded[SHARD_SAMPLE_BYTES];
+                TrainingSample s;
+                if (!FromHex(t[i], encoded, sizeof(encoded))) ok = false;
+                else
+                {
+                    DecodeSample(encoded, s);
+                    samples.push_back(s);
+                }
+            }
+            if (!ok)
+            {
+                std::cerr << "malformed result for game " << index << ", requeued\n";
+                pending.push_back(index);
+                return;
+            }
+            record.finished = WinnerOf(pos) != Player::None;
+            // 写盘失败（磁盘满、目录不可写）与 AmazonSelfPlay 一样视为致命：不计入完成数，结束运行
+            bool written = writer.Append(samples);
+            if (written && !config.gamesDir.empty())
+            {
+                char name[40];
+                std::snprintf(name, sizeof(name), "/game_%06llu.acp", static_cast<unsigned long long>(index));
+                written = SaveRecord(config.gamesDir + name, record);
+            }
+            if (!written)
+            {
+                std::cerr << "cannot write results of game " << index << "\n";
+                writeFailed = true;
+                return;
+            }
+            ++gamesDone;
+            if (gamesDone % 100 == 0) Progress();
+        }
+
+        void HandleAnalysed(WorkerConnection& w, const std::vector<std::string>& t)
+        {
+            uint64_t id = std::strtoull(t[1].c_str(), nullptr, 10);
+            if (!Complete(w, id) || id < ANALYSIS_BASE) return;
+            size_t index = static_cast<size_t>(id - ANALYSIS_BASE);
+            if (index >= analysis.size() || analysisDone[index]) return;
+
+            // worker 的应答只在校验后写入：走法须能解析，其余字段的值须为整数
+            const AnalysisJob& job = analysis[index];
+            std::ostringstream ss;
+            ss << "{\"source\":\"" << JsonEscape(job.source) << "\",\"ply\":" << job.ply;
+            bool ok = true;
+            for (size_t i = 2; ok && i + 1 < t.size(); i += 2)
+            {
+                Move m;
+                if (t[i] == "move" && t[i + 1] == "none") ss << ",\"move\":null";
+                else if (t[i] == "move")
+                {
+                    ok = ParseMoveToken(t[i + 1], m);
+                    if (ok) ss << ",\"move\":\"" << t[i + 1] << "\"";
+                }
+                else if (IsJsonInteger(t[i + 1])) ss << ",\"" << JsonEscape(t[i]) << "\":" << t[i + 1];
+                else ok = false;
+            }
+            if (!ok)
+            {
+                std::cerr << "malformed result for position " << index << ", requeued\n";
+                pending.push_back(id);
+                return;
+            }
+            if (t.size() == 3 && t[2] == "error") ss << ",\"error\":true";
+            ss << "}\n";
+            analysisDone[index] = true;
+            ++analysedCount;
+            std::ostream& out = analysisFile.is_open() ? static_cast<std::ostream&>(analysisFile) : std::cout;
+            if (!(out << ss.str()))
+            {
+                std::cerr << "cannot write analysis result for " << job.source << "\n";
+                writeFailed = true;
+            }
+        }
+
+        // 失去响应的 worker：结束其进程（若已知）并按断开处理
+        void CheckTimeouts()
+        {
+            if (config.jobTimeoutSec <= 0) return;
+            Clock::time_point now = Clock::now();
+            for (auto& w : workers)
+            {
+                if (w.dead || w.inFlight.empty()) continue;
+                if (now - w.lastActivity > std::chrono::seconds(config.jobTimeoutSec))
+                {
+                    std::cerr << "worker " << w.pid << " timed out\n";
+                    if (w.pid > 0) kill(w.pid, SIGKILL);
+                    w.dead = true;
+                }
+            }
+        }
+
+        void ReapAndRespawn()
+        {
+            for (auto it = children.begin(); it != children.end();)
+            {
+                int status;
+                if (waitpid(*it, &status, WNOHANG) == *it)
+                {
+                    it = children.erase(it);
+                    if (!Finished() && restarts < config.maxRestarts)
+                    {
+                        ++restarts;
+                        std::cerr << "worker exited, restarting\n";
+                        Spawn();
+                    }
+                }
+                else ++it;
+            }
+        }
+
+        void RemoveDead()
+        {
+            for (auto& w : workers)
+            {
+                if (!w.dead) continue;
+                for (uint64_t job : w.inFlight)
+                {
+                    pending.push_front(job);
+                    ++reassigned;
+                }
+                w.inFlight.clear();
+            }
+            workers.erase(std::remove_if(workers.begin(), workers.end(),
+                [](const WorkerConnection& w) { return w.dead; }), workers.end());
+        }
+
+        bool NextJob(uint64_t& job)
+        {
+            if (!pending.empty())
+            {
+                job = pending.front();
+                pending.pop_front();
+                return true;
+            }
+            if (nextGame < config.games)
+            {
+                job = nextGame++;
+                return true;
+            }
+            if (nextAnalysis < analysis.size())
+            {
+                job = ANALYSIS_BASE + nextAnalysis++;
+                return true;
+            }
+            return false;
+        }
+
+        void Dispatch()
+        {
+            for (auto& w : workers)
+            {
+                while (!w.dead && w.inFlight.size() < config.inflight)
+                {
+                    uint64_t job;
+                    if (!NextJob(job)) return;
+                    std::string line;
+                    if (job >= ANALYSIS_BASE)
+                    {
+                        const AnalysisJob& a = analysis[static_cast<size_t>(job - ANALYSIS_BASE)];
+                        char go[96];
+                        std::snprintf(go, sizeof(go), " depth %d nodes %llu movetime %lld ",
+                                      config.settings.limits.maxDepth,
+                                      static_cast<unsigned long long>(config.settings.limits.maxNodes),
+                                      static_cast<long long>(config.settings.limits.maxTimeMs));
+                        line = "analyse " + std::to_string(job) + go + a.position;
+                    }
+                    else line = "game " + std::to_string(job);
+                    if (w.inFlight.empty()) w.lastActivity = Clock::now();
+                    w.inFlight.push_back(job);
+                    if (!w.channel->WriteLine(line)) w.dead = true;
+                }
+            }
+        }
+
+        void Progress()
+        {
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            std::fprintf(stderr, "games %llu/%llu  workers %zu  %.1f games/s\n",
+                         static_cast<unsigned long long>(gamesDone), static_cast<unsigned long long>(config.games),
+                         workers.size(), sec > 0 ? gamesDone / sec : 0.0);
+        }
+
+        CoordinatorConfig config;
+        std::vector<AnalysisJob> analysis;
+        std::vector<bool> analysisDone;
+        ShardWriter writer;
+        std::ofstream analysisFile;
+        int listenFd = -1;
+        std::vector<WorkerConnection> workers;
+        std::vector<pid_t> children;
+        std::deque<uint64_t> pending;   // 需要重做的任务
+        uint64_t nextGame = 0;
+        size_t nextAnalysis = 0;
+        uint64_t gamesDone = 0;
+        size_t analysedCount = 0;
+        uint64_t reassigned = 0;
+        int restarts = 0;
+        bool writeFailed = false;       // 结果写盘失败，结束运行
+        Clock::time_point start;
+    };
+
+    // 分析任务只支持黑白交替的棋谱（协议的 moves 序列隐含交替）
+    bool LoadAnalysisJob(const std::string& path, int ply, AnalysisJob& out)
+    {
+        GameRecord record;
+        if (!LoadRecord(path, record)) return false;
+        size_t count = ply >= 0 ? std::min(record.moves.size(), static_cast<size_t>(ply)) : record.moves.size();
+        Position pos = record.start;
+        if (!record.moves.empty()) pos.SetSideToMove(record.moves[0].player);
+        std::string cmd = "position " + PositionSetupTokens(pos) + " moves";
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (record.moves[i].player != pos.sideToMove) return false;
+            if (!ApplyRecordedMove(pos, record.moves[i])) return false;
+            cmd += " " + MoveToToken(record.moves[i].move);
+        }
+        out.source = path;
+        out.ply = static_cast<int>(count);
+        out.position = cmd;
+        return true;
+    }
+
+    int RunCoordinator(int argc, char* argv[], const std::string& self)
+    {
+        CoordinatorConfig config;
+        config.self = self;
+        config.address = "unix:/tmp/amazon-cluster-" + std::to_string(getpid()) + ".sock";
+        config.spawn = std::max(1u, std::thread::hardware_concurrency());
+        config.settings.limits.maxDepth = 2;
+        std::vector<AnalysisJob> analysis;
+
+        for (int i = 0; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto next = [&]() -> const char* {
+                if (i + 1 >= argc) { std::cerr << "missing value for " << arg << "\n"; std::exit(2); }
+                return argv[++i];
+            };
+            if (arg == "--listen") config.address = next();
+            else if (arg == "--workers") config.spawn = std::strtoul(next(), nullptr, 10);
+            else if (arg == "--games") config.games = std::strtoull(next(), nullptr, 10);
+            else if (arg == "--depth") config.settings.limits.maxDepth = std::atoi(next());
+            else if (arg == "--nodes") config.settings.limits.maxNodes = std::strtoull(next(), nullptr, 10);
+            else if (arg == "--movetime") config.settings.limits.maxTimeMs = std::atoll(next());
+            else if (arg == "--random-plies") config.settings.randomPlies = std::atoi(next());
+            else if (arg == "--seed") config.settings.seed = std::strtoull(next(), nullptr, 10);
+            else if (arg == "--hash") config.hashMb = std::strtoul(next(), nullptr, 10);
+            else if (arg == "--out") config.outPrefix = next();
+            else if (arg == "--games-dir") config.gamesDir = next();
+            else if (arg == "--analysis-out") config.analysisOut = next();
+            else if (arg == "--inflight") config.inflight = std::max<size_t>(1, std::strtoul(next(), nullptr, 10));
+            else if (arg == "--job-timeout") config.jobTimeoutSec = std::atoi(next());
+            else if (arg == "--max-restarts") config.maxRestarts = std::atoi(next());
+            else if (arg == "--positions")
+            {
+                std::ifstream ifs(next());
+                if (!ifs.is_open())
+                {
+                    std::cerr << "cannot open list " << argv[i] << "\n";
+                    return 1;
+                }
+                std::string line;
+                while (std::getline(ifs, line))
+                {
+                    std::istringstream iss(line);
+                    std::string path;
+                    if (!(iss >> path) || path[0] == '#') continue;
+                    int ply = -1;
+                    iss >> ply;
+                    AnalysisJob job;
+                    if (LoadAnalysisJob(path, ply, job)) analysis.push_back(job);
+                    else std::cerr << "warning: skipping " << path << "\n";
+                }
+            }
+            else
+            {
+                std::cerr << "unknown option " << arg << "\n";
+                return 2;
+            }
+        }
+
+        std::signal(SIGPIPE, SIG_IGN);
+        std::signal(SIGINT, OnInterrupt);
+        std::signal(SIGTERM, OnInterrupt);
+        Coordinator coordinator(config, std::move(analysis));
+        return coordinator.Run();
+    }
+
+    // worker 由 coordinator 以本程序的绝对路径启动
+    std::string SelfPath(const char* argv0)
+    {
+        char buf[4096];
+        ssize_t n = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+        if (n > 0) return std::string(buf, static_cast<size_t>(n));
+        return argv0;
+    }
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonCluster coordinator [--workers n] [--games n] [--positions file] [options]\n"
+                     "       AmazonCluster worker --connect <addr>\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) { Usage(); return 2; }
+    std::string mode = argv[1];
+    if (mode == "worker") return RunWorker(argc - 2, argv + 2);
+    if (mode == "coordinator") return RunCoordinator(argc - 2, argv + 2, SelfPath(argv[0]));
+    Usage();
+    return 2;
+}
@@ -0,0 +1,479 @@
+﻿// AmazonDedup.cpp : 对局库合并去重工具（Linux）
+// 把多处来源（自对弈、人机对局等）的棋谱合并为一份不含重复对局的集合，对局总量可以远大于内存：
+//   1. 并行读取各棋谱（.acp / .acj），为每局计算 128 位对局键（起始局面 + 着法序列 + 是否结束），
+//      与输入编号一起放入所在线程的缓冲区；缓冲区满即排序写出为临时有序段（run）。
+//   2. 有序段多于 MAX_MERGE_FAN_IN 时先分组归并成更长的段，最后一趟 k 路归并：
+//      同键的条目相邻，只保留编号最小的一局（即输入中最早出现的一份），其余计为重复。
+//   3. 按输入顺序再扫一遍路径，输出保留下来的对局。
+// --symmetric 时对局键取棋盘 8 种对称变换下的最小值，互为镜像 / 旋转的对局也视为重复。
+// 内存：条目缓冲区由 --memory 限定，另有每局 1 位的保留标记；对局键碰撞概率可忽略（128 位）。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonDedup.cpp -o AmazonDedup
+//
+// 用法：AmazonDedup [选项] [game.acp|game.acj ...]
+//   --list <file>       每行一个棋谱路径（'#' 开头为注释），可多次给出，可与命令行路径混用
+//   --out-list <file>   写出保留对局的路径（输入顺序），可直接作为其他工具的 --list
+//   --out-dir <dir>     把保留的对局依次写为 <dir>/00000000.acp ...（统一为 .acp 格式）
+//   --symmetric         同时去除对称重复
+//   --memory <mb>       条目缓冲区总大小（默认 256，各线程平分）；0 表示每局单独成段（用于检验多趟归并）
+//   --temp <dir>        临时有序段目录（默认 $TMPDIR 或 /tmp）
+//   --threads <n>       工作线程数（默认硬件线程数）
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "AmazonGameSource.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 一趟归并同时打开的有序段上限（受文件描述符数限制）
+    static constexpr size_t MAX_MERGE_FAN_IN = 128;
+    // 读写有序段时每个文件的缓冲条目数
+    static constexpr size_t RUN_BUFFER_ENTRIES = 4096;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // 进程峰值常驻内存（MB）
+    double PeakRssMb()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+        return usage.ru_maxrss / 1024.0; // Linux 上单位为 KB
+    }
+
+    struct GameKey
+    {
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+
+        bool operator<(const GameKey& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+        bool operator==(const GameKey& o) const { return hi == o.hi && lo == o.lo; }
+    };
+
+    // 有序段中的一条：按 (键, 输入编号) 排序，同键时编号最小者在前
+    struct DedupEntry
+    {
+        GameKey key;
+        uint64_t game;
+
+        bool operator<(const DedupEntry& o) const { return key == o.key ? game < o.game : key < o.key; }
+    };
+
+    // ---- 对局键 ----
+
+    // 棋盘的 8 种对称变换（格号 y * 8 + x）
+    int TransformSquare(int sq, int symmetry)
+    {
+        int x = sq % BOARD_SIZE, y = sq / BOARD_SIZE;
+        if (symmetry & 1) x = BOARD_SIZE - 1 - x;
+        if (symmetry & 2) y = BOARD_SIZE - 1 - y;
+        if (symmetry & 4) std::swap(x, y);
+        return SquareOf(x, y);
+    }
+
+    Bitboard TransformBitboard(Bitboard b, int symmetry)
+    {
+        Bitboard out = 0;
+        while (b) out |= Bitboard(1) << TransformSquare(PopLowest(b), symmetry);
+        return out;
+    }
+
+    // 两路独立种子的 64 位混合，合成 128 位键
+    struct KeyHasher
+    {
+        uint64_t a = 0x243F6A8885A308D3ULL;
+        uint64_t b = 0x13198A2E03707344ULL;
+
+        void Add(uint64_t v)
+        {
+            a = Mix(a ^ v);
+            b = Mix(b + v * 0x9E3779B97F4A7C15ULL);
+        }
+
+        static uint64_t Mix(uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+    };
+
+    GameKey KeyOf(const GameRecord& record, int symmetry)
+    {
+        KeyHasher h;
+        const Position& start = record.start;
+        h.Add(TransformBitboard(start.arrows, symmetry));
+        h.Add(TransformBitboard(start.amazons[0], symmetry));
+        h.Add(TransformBitboard(start.amazons[1], symmetry));
+        h.Add(record.moves.size());
+        for (const RecordedMove& rm : record.moves)
+        {
+            Move m = MoveOf(TransformSquare(rm.move.from, symmetry), TransformSquare(rm.move.to, symmetry),
+                            TransformSquare(rm.move.arrow, symmetry));
+            h.Add((uint64_t(rm.player == Player::Black) << 32) | m.Code());
+        }
+        h.Add(record.finished ? 1 : 0);
+        return { h.a, h.b };
+    }
+
+    GameKey CanonicalKey(const GameRecord& record, bool symmetric)
+    {
+        GameKey best = KeyOf(record, 0);
+        if (!symmetric) return best;
+        for (int s = 1; s < 8; ++s)
+        {
+            GameKey k = KeyOf(record, s);
+            if (k < best) best = k;
+        }
+        return best;
+    }
+
+    // ---- 有序段 ----
+
+    class RunWriter
+    {
+    public:
+        bool Open(const std::string& path)
+        {
+            file = std::fopen(path.c_str(), "wb");
+            buffer.reserve(RUN_BUFFER_ENTRIES);
+            return file != nullptr;
+        }
+
+        bool Write(const DedupEntry& e)
+        {
+            buffer.push_back(e);
+            return buffer.size() < RUN_BUFFER_ENTRIES || Flush();
+        }
+
+        bool Close()
+        {
+            bool ok = Flush();
+            if (file && std::fclose(file) != 0) ok = false;
+            file = nullptr;
+            return ok;
+        }
+
+    private:
+        bool Flush()
+        {
+            bool ok = file && std::fwrite(buffer.data(), sizeof(DedupEntry), buffer.size(), file) == buffer.size();
+            buffer.clear();
+            return ok;
+        }
+
+        std::FILE* file = nullptr;
+        std::vector<DedupEntry> buffer;
+    };
+
+    class RunReader
+    {
+    public:
+        ~RunReader()
+        {
+            if (file) std::fclose(file);
+        }
+
+        bool Open(const std::string& path)
+        {
+            file = std::fopen(path.c_str(), "rb");
+            buffer.resize(RUN_BUFFER_ENTRIES);
+            return file != nullptr;
+        }
+
+        bool Next(DedupEntry& e)
+        {
+            if (at == count)
+            {
+                count = std::fread(buffer.data(), sizeof(DedupEntry), buffer.size(), file);
+                at = 0;
+                if (count == 0) return false;
+            }
+            e = buffer[at++];
+            return true;
+        }
+
+    private:
+        std::FILE* file = nullptr;
+        std::vector<DedupEntry> buffer;
+        size_t at = 0;
+        size_t count = 0;
+    };
+
+    // 归并若干有序段，按序对每个条目调用 emit；任一段无法打开时返回 false
+    template <typename Emit>
+    bool MergeRuns(const std::vector<std::string>& runs, Emit emit)
+    {
+        std::vector<std::unique_ptr<RunReader>> readers;
+        typedef std::pair<DedupEntry, size_t> Head;
+        auto greater = [](const Head& a, const Head& b) { return b.first < a.first; };
+        std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+        for (size_t r = 0; r < runs.size(); ++r)
+        {
+            readers.emplace_back(new RunReader());
+            if (!readers.back()->Open(runs[r])) return false;
+            DedupEntry e;
+            if (readers.back()->Next(e)) heap.push(Head(e, r));
+        }
+        while (!heap.empty())
+        {
+            Head h = heap.top();
+            heap.pop();
+            emit(h.first);
+            DedupEntry e;
+            if (readers[h.second]->Next(e)) heap.push(Head(e, h.second));
+        }
+        return true;
+    }
+
+    // 临时有序段的命名与登记（多线程写出）
+    class RunSet
+    {
+    public:
+        explicit RunSet(std::string dir) : directory(std::move(dir)) {}
+
+        ~RunSet()
+        {
+            for (const std::string& p : paths) std::remove(p.c_str());
+        }
+
+        std::string NewPath()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string p = directory + "/amazon-dedup-" + std::to_string(getpid()) + "-" + std::to_string(serial++) + ".run";
+            paths.push_back(p);
+            live.push_back(p);
+            return p;
+        }
+
+        // 取出当前所有有序段（调用方负责归并，归并后可删除）
+        std::vector<std::string> TakeLive()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::string> out;
+            out.swap(live);
+            return out;
+        }
+
+        void Discard(const std::vector<std::string>& done)
+        {
+            for (const std::string& p : done) std::remove(p.c_str());
+        }
+
+    private:
+        std::mutex mutex;
+        std::string directory;
+        std::vector<std::string> paths; // 创建过的全部段（析构时清理残留）
+        std::vector<std::string> live;  // 尚未归并的段
+        size_t serial = 0;
+    };
+
+    bool SpillRun(std::vector<DedupEntry>& buffer, RunSet& runs)
+    {
+        if (buffer.empty()) return true;
+        std::sort(buffer.begin(), buffer.end());
+        RunWriter w;
+        bool ok = w.Open(runs.NewPath());
+        for (size_t i = 0; ok && i < buffer.size(); ++i) ok = w.Write(buffer[i]);
+        ok = w.Close() && ok;
+        buffer.clear();
+        return ok;
+    }
+
+    void Usage()
+    {
+        std::fprintf(stderr, "usage: AmazonDedup [--list file] [--out-list file] [--out-dir dir] [--symmetric] [--memory mb] [--temp dir] [--threads n] [game ...]\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> paths, lists;
+    std::string outList, outDir;
+    const char* tmpEnv = std::getenv("TMPDIR");
+    std::string tempDir = tmpEnv && *tmpEnv ? tmpEnv : "/tmp";
+    bool symmetric = false;
+    size_t memoryMb = 256;
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--list") && hasValue) lists.push_back(argv[++i]);
+        else if (!std::strcmp(argv[i], "--out-list") && hasValue) outList = argv[++i];
+        else if (!std::strcmp(argv[i], "--out-dir") && hasValue) outDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--symmetric")) symmetric = true;
+        else if (!std::strcmp(argv[i], "--memory") && hasValue) memoryMb = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--temp") && hasValue) tempDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--threads") && hasValue) threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--help") || !std::strcmp(argv[i], "-h"))
+        {
+            Usage();
+            return 0;
+        }
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            Usage();
+            return 2;
+        }
+    }
+    if (paths.empty() && lists.empty())
+    {
+        Usage();
+        return 2;
+    }
+
+    Clock::time_point t0 = Clock::now();
+    RunSet runs(tempDir);
+    uint64_t gameCount = 0, unreadable = 0;
+    bool ok = true;
+
+    // 1. 计算对局键并分段写出
+    {
+        GameSource source(paths, lists);
+        WorkStealingPool pool(threads);
+        size_t perWorker = memoryMb == 0 ? 1 : std::max<size_t>(1024, memoryMb * 1024 * 1024 / sizeof(DedupEntry) / pool.Size());
+        std::vector<uint64_t> failed(pool.Size(), 0), last(pool.Size(), 0);
+        std::vector<char> workerOk(pool.Size(), 1);
+        for (size_t w = 0; w < pool.Size(); ++w)
+        {
+            pool.Submit([&](size_t worker) {
+                std::vector<DedupEntry> buffer;
+                buffer.reserve(perWorker);
+                std::vector<std::string> batch;
+                uint64_t first;
+                GameRecord record;
+                while (workerOk[worker] && source.NextBatch(batch, first))
+                {
+                    for (size_t i = 0; i < batch.size(); ++i)
+                    {
+                        if (!LoadGameFile(batch[i], record))
+                        {
+                            std::fprintf(stderr, "warning: cannot read record %s\n", batch[i].c_str());
+                            ++failed[worker];
+                            continue;
+                        }
+                        buffer.push_back({ CanonicalKey(record, symmetric), first + i });
+                        if (buffer.size() >= perWorker && !SpillRun(buffer, runs)) workerOk[worker] = 0;
+                    }
+                    last[worker] = std::max(last[worker], first + batch.size());
+                }
+                if (!SpillRun(buffer, runs)) workerOk[worker] = 0;
+            });
+        }
+        pool.Wait();
+        for (size_t w = 0; w < pool.Size(); ++w)
+        {
+            unreadable += failed[w];
+            gameCount = std::max(gameCount, last[w]);
+            if (!workerOk[w]) ok = false;
+        }
+    }
+    if (!ok)
+    {
+        std::fprintf(stderr, "cannot write runs to %s\n", tempDir.c_str());
+        return 1;
+    }
+    double keySec = SecondsSince(t0);
+
+    // 2. 段数过多时先分组归并，最后一趟标记每个键的第一局
+    std::vector<std::string> live = runs.TakeLive();
+    size_t runCount = live.size(), passes = 1;
+    while (ok && live.size() > MAX_MERGE_FAN_IN)
+    {
+        std::vector<std::string> next;
+        for (size_t begin = 0; ok && begin < live.size(); begin += MAX_MERGE_FAN_IN)
+        {
+            std::vector<std::string> group(live.begin() + begin, live.begin() + std::min(live.size(), begin + MAX_MERGE_FAN_IN));
+            std::string out = runs.NewPath();
+            RunWriter w;
+            ok = w.Open(out);
+            ok = MergeRuns(group, [&](const DedupEntry& e) { if (ok) ok = w.Write(e); }) && ok;
+            ok = w.Close() && ok;
+            runs.Discard(group);
+            next.push_back(out);
+        }
+        runs.TakeLive();
+        live.swap(next);
+        ++passes;
+    }
+    std::vector<uint64_t> keep((gameCount + 63) / 64, 0); // 每局 1 位
+    uint64_t unique = 0;
+    bool haveLast = false;
+    GameKey lastKey;
+    ok = ok && MergeRuns(live, [&](const DedupEntry& e) {
+        if (haveLast && e.key == lastKey) return;
+        keep[e.game / 64] |= uint64_t(1) << (e.game % 64);
+        lastKey = e.key;
+        haveLast = true;
+        ++unique;
+    });
+    runs.Discard(live);
+    if (!ok)
+    {
+        std::fprintf(stderr, "cannot merge runs in %s\n", tempDir.c_str());
+        return 1;
+    }
+    double mergeSec = SecondsSince(t0) - keySec;
+
+    // 3. 按输入顺序输出保留的对局
+    if (!outList.empty() || !outDir.empty())
+    {
+        std::FILE* list = nullptr;
+        if (!outList.empty() && !(list = std::fopen(outList.c_str(), "w")))
+        {
+            std::fprintf(stderr, "cannot write %s\n", outList.c_str());
+            return 1;
+        }
+        GameSource source(paths, lists);
+        std::vector<std::string> batch;
+        uint64_t first, written = 0;
+        GameRecord record;
+        while (source.NextBatch(batch, first))
+        {
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                uint64_t g = first + i;
+                if (g >= gameCount || !(keep[g / 64] >> (g % 64) & 1)) continue;
+                if (list) std::fprintf(list, "%s\n", batch[i].c_str());
+                if (outDir.empty()) continue;
+                char name[32];
+                std::snprintf(name, sizeof(name), "/%08llu.acp", static_cast<unsigned long long>(written++));
+                if (!LoadGameFile(batch[i], record) || !SaveRecord(outDir + name, record))
+                {
+                    std::fprintf(stderr, "cannot copy %s to %s%s\n", batch[i].c_str(), outDir.c_str(), name);
+                    ok = false;
+                }
+            }
+        }
+        if (list && std::fclose(list) != 0) ok = false;
+    }
+    double totalSec = SecondsSince(t0);
+
+    uint64_t readable = gameCount - unreadable;
+    std::printf("games %llu (unreadable %llu), unique %llu, duplicates %llu%s\n",
+                static_cast<unsigned long long>(gameCount), static_cast<unsigned long long>(unreadable),
+                static_cast<unsigned long long>(unique), static_cast<unsigned long long>(readable - unique),
+                symmetric ? " (including symmetric)" : "");
+    std::printf("runs %zu, merge passes %zu; keys %.2f s, merge %.2f s, total %.2f s (%.0f games/s), peak RSS %.1f MB\n",
+                runCount, passes, keySec, mergeSec, totalSec, totalSec > 0 ? gameCount / totalSec : 0.0, PeakRssMb());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+﻿// AmazonEngine.cpp : 无界面引擎进程（标准输入输出文本协议，协议说明见 AmazonProtocol.h）
+// 命令在主线程中逐行处理，搜索在单独的线程中进行，搜索期间仍可响应 stop / isready / quit。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonEngine.cpp -o AmazonEngine
+//
+// 用法：AmazonEngine [--hash mb] [--eval file] [--net file]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AmazonDfpn.h"
+#include "AmazonProtocol.h"
+#include "AmazonSearch.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    // 输出一行并立即刷新；搜索线程与主线程都会输出，需串行化
+    std::mutex g_outputMutex;
+
+    void Send(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    std::string InfoLine(const SearchResult& r)
+    {
+        char buf[160];
+        double nps = r.timeMs > 0.0 ? r.nodes * 1000.0 / r.timeMs : 0.0;
+        std::snprintf(buf, sizeof(buf), "info depth %d score %d nodes %llu time %lld nps %.0f move ",
+                      r.depth, r.score, static_cast<unsigned long long>(r.nodes),
+                      static_cast<long long>(r.timeMs), nps);
+        return buf + (r.hasMove ? MoveToToken(r.bestMove) : std::string("none"));
+    }
+
+    std::string SolveLine(const SolverOutcome& o)
+    {
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "info solve %s nodes %llu time %lld pn %u dn %u move ",
+                      SolveResultName(o.result), static_cast<unsigned long long>(o.nodes),
+                      static_cast<long long>(o.timeMs), o.phi, o.delta);
+        return buf + (o.hasMove ? MoveToToken(o.bestMove) : std::string("none"));
+    }
+
+    class EngineSession
+    {
+    public:
+        explicit EngineSession(size_t hashMb) : engine(new Engine(hashMb)), hashMb(hashMb), position(Position::Initial())
+        {
+            InstallCallback();
+        }
+
+        ~EngineSession() { StopSearch(); }
+
+        // 处理一行命令；返回 false 表示退出
+        bool Handle(const std::string& line)
+        {
+            std::vector<std::string> t = SplitTokens(line);
+            if (t.empty()) return true;
+            const std::string& cmd = t[0];
+            if (cmd == "quit") return false;
+            if (cmd == "isready") Send("readyok");
+            else if (cmd == "stop") StopSearch();
+            else if (cmd == "hello")
+            {
+                Send("id name AmazonEngine");
+                Send("id protocol " + std::to_string(PROTOCOL_VERSION));
+                Send("hellook");
+            }
+            else if (cmd == "newgame")
+            {
+                StopSearch();
+                engine->NewGame();
+                if (solver) solver->Clear();
+            }
+            else if (cmd == "setoption") SetOption(t);
+            else if (cmd == "position") SetPosition(t);
+            else if (cmd == "go") Go(t);
+            else Send("error unknown command " + cmd);
+            return true;
+        }
+
+    private:
+        // 按当前的置换表大小与内存选项重建引擎（置换表随之清空），保留评估与搜索选项
+        void RebuildEngine()
+        {
+            engine.reset(new Engine(std::make_shared<TranspositionTable>(hashMb, memoryOptions)));
+            engine->SetEvalParams(evalParams);
+            engine->SetNetwork(network);
+            engine->SetOptions(searchOptions);
+            InstallCallback();
+        }
+
+        void InstallCallback()
+        {
+            engine->SetInfoCallback([](const SearchResult& r) { Send(InfoLine(r)); });
+        }
+
+        void SetOption(const std::vector<std::string>& t)
+        {
+            if (t.size() < 3)
+            {
+                Send("error setoption needs a name and a value");
+                return;
+            }
+            StopSearch();
+            const std::string& name = t[1];
+            const std::string& value = t[2];
+            bool on = value == "on" || value == "1" || value == "true";
+            bool off = value == "off" || value == "0" || value == "false";
+            if (name == "hash")
+            {
+                hashMb = std::strtoul(value.c_str(), nullptr, 10);
+                RebuildEngine();
+            }
+            else if (name == "hugepages" && (on || off))
+            {
+                memoryOptions.hugePages = on;
+                RebuildEngine();
+            }
+            else if (name == "numa" && (on || off))
+            {
+                memoryOptions.interleaveNodes = on;
+                RebuildEngine();
+            }
+            else if (name == "eval")
+            {
+                evalParams = LoadEvalParams(value);
+                if (!evalParams) Send("error cannot load weights " + value);
+                engine->SetEvalParams(evalParams);
+            }
+            else if (name == "net")
+            {
+                std::shared_ptr<Network> net = std::make_shared<Network>();
+                if (net->Load(value)) network = net;
+                else
+                {
+                    network.reset();
+                    Send("error cannot load network " + value);
+                }
+                engine->SetNetwork(network);
+            }
+            else if (name == "solver-nodes") solverNodes = std::strtoull(value.c_str(), nullptr, 10);
+            else if (name == "solver-arrows") solverArrows = std::atoi(value.c_str());
+            else if (name == "solver-hash")
+            {
+                solverMb = std::strtoul(value.c_str(), nullptr, 10);
+                solver.reset();
+            }
+            else if (SetSearchOption(searchOptions, name, value)) engine->SetOptions(searchOptions);
+            else Send("error unknown option " + name);
+        }
+
+        // position startpos [w|b] [moves <m> ...]；任一步非法时保持原局面不变
+        void SetPosition(const std::vector<std::string>& t)
+        {
+            StopSearch();
+            std::string error;
+            if (!ParsePosition(t, 1, position, error)) Send("error " + error);
+        }
+
+        void Go(const std::vector<std::string>& t)
+        {
+            StopSearch();
+            SearchLimits limits;
+            limits.maxDepth = MAX_PLY;
+            bool bounded = false;
+            TimeControl clocks[2]; // 按 Player 下标：白、黑
+            bool solveOnly = false;
+            for (size_t i = 1; i < t.size(); ++i)
+            {
+                bool hasValue = i + 1 < t.size();
+                if (t[i] == "solve") solveOnly = true;
+                else if (t[i] == "depth" && hasValue) { limits.maxDepth = std::atoi(t[++i].c_str()); bounded = true; }
+                else if (t[i] == "nodes" && hasValue) { limits.maxNodes = std::strtoull(t[++i].c_str(), nullptr, 10); bounded = true; }
+                else if (t[i] == "movetime" && hasValue) { limits.maxTimeMs = std::atoll(t[++i].c_str()); bounded = true; }
+                else if (t[i] == "wtime" && hasValue) { clocks[0].remainingMs = std::atoll(t[++i].c_str()); bounded = true; }
+                else if (t[i] == "btime" && hasValue) { clocks[1].remainingMs = std::atoll(t[++i].c_str()); bounded = true; }
+                else if (t[i] == "winc" && hasValue) clocks[0].incrementMs = std::atoll(t[++i].c_str());
+                else if (t[i] == "binc" && hasValue) clocks[1].incrementMs = std::atoll(t[++i].c_str());
+                else if (t[i] == "movestogo" && hasValue) clocks[0].movesToGo = clocks[1].movesToGo = std::atoi(t[++i].c_str());
+                else if (t[i] == "infinite") bounded = true;
+                else
+                {
+                    Send("error bad go argument " + t[i]);
+                    return;
+                }
+            }
+            if (solveOnly)
+            {
+                // go solve：只做胜负证明，节点数缺省取 solver-nodes（仍为 0 时不限）
+                SolverLimits solveLimits;
+                solveLimits.maxNodes = limits.maxNodes ? limits.maxNodes : solverNodes;
+                solveLimits.maxTimeMs = limits.maxTimeMs;
+                cancelled.store(false);
+                solveLimits.cancel = &cancelled;
+                ProofNumberSolver* s = Solver();
+                Position root = position;
+                searcher = std::thread([s, root, solveLimits] {
+                    SolverOutcome o = s->Solve(root, solveLimits);
+                    Send(SolveLine(o));
+                    Send(o.hasMove ? "bestmove " + MoveToToken(o.bestMove) : std::string("bestmove none"));
+                });
+                return;
+            }
+            // 未给出任何限制时与界面一致，只搜一层
+            if (!bounded) limits.maxDepth = 1;
+            limits.time = AllocateTime(clocks[static_cast<int>(position.sideToMove)], position);
+            // 每次搜索的取消标志在启动线程前清除：stop 紧跟 go 到达、搜索线程尚未进入 Search / Solve 时也不会丢失
+            cancelled.store(false);
+            limits.cancel = &cancelled;
+
+            // 求解模式：箭数达到 solver-arrows 时先以 solver-nodes 为预算做胜负证明（至多用去本手一半的时间），
+            // 证明走子方必胜即直接走必胜的一手，否则照常搜索
+            SolverLimits solveLimits;
+            solveLimits.maxNodes = solverNodes;
+            solveLimits.maxTimeMs = limits.time.softMs ? limits.time.softMs / 2 : limits.maxTimeMs / 2;
+            solveLimits.cancel = &cancelled;
+            bool trySolve = solverNodes > 0 && PopCount(position.arrows) >= solverArrows;
+            ProofNumberSolver* s = trySolve ? Solver() : nullptr;
+            Engine* e = engine.get();
+            Position root = position;
+            searcher = std::thread([e, s, root, limits, solveLimits]() mutable {
+                if (s)
+                {
+                    SolverOutcome o = s->Solve(root, solveLimits);
+                    Send(SolveLine(o));
+                    if (o.hasMove)
+                    {
+                        Send("bestmove " + MoveToToken(o.bestMove));
+                        return;
+                    }
+                    int64_t used = static_cast<int64_t>(o.timeMs);
+                    if (limits.time.softMs) limits.time.softMs = std::max<int64_t>(1, limits.time.softMs - used);
+                    if (limits.time.hardMs) limits.time.hardMs = std::max<int64_t>(1, limits.time.hardMs - used);
+                    if (limits.maxTimeMs) limits.maxTimeMs = std::max<int64_t>(1, limits.maxTimeMs - used);
+                }
+                SearchResult r = e->Search(root, limits);
+                Send(r.hasMove ? "bestmove " + MoveToToken(r.bestMove) : std::string("bestmove none"));
+            });
+        }
+
+        // 求解器在首次使用时按 solver-hash 分配
+        ProofNumberSolver* Solver()
+        {
+            if (!solver) solver.reset(new ProofNumberSolver(solverMb, memoryOptions));
+            return solver.get();
+        }
+
+        // 中止并等待当前搜索（无搜索时立即返回）
+        void StopSearch()
+        {
+            if (!searcher.joinable()) return;
+            cancelled.store(true);
+            searcher.join();
+        }
+
+        std::unique_ptr<Engine> engine;
+        size_t hashMb;
+        TableMemoryOptions memoryOptions;
+        std::shared_ptr<const EvalParams> evalParams;
+        std::shared_ptr<const Network> network;
+        SearchOptions searchOptions;
+        std::unique_ptr<ProofNumberSolver> solver;
+        size_t solverMb = 64;
+        uint64_t solverNodes = 0;   // 0 = 不启用求解模式
+        int solverArrows = 30;
+        std::atomic<bool> cancelled{ false };  // 当前搜索 / 求解的 SearchLimits::cancel 与 SolverLimits::cancel
+        Position position;
+        std::thread searcher;
+    };
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonEngine [--hash mb] [--eval file] [--net file]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t hashMb = 16;
+    std::vector<std::string> startup;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--hash" || arg == "--eval" || arg == "--net") && i + 1 < argc)
+        {
+            if (arg == "--hash") hashMb = std::strtoul(argv[++i], nullptr, 10);
+            else startup.push_back("setoption " + arg.substr(2) + " " + argv[++i]);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+
+    EngineSession session(hashMb);
+    for (const std::string& cmd : startup) session.Handle(cmd);
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!session.Handle(line)) break;
+    }
+    return 0;
+}
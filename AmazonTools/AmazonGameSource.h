@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AmazonJournal.h"
+#include "AmazonRecord.h"
+
+// 对局库输入：按路径读取单个棋谱（.acj 日志或 .acp 文本）、读取路径列表文件，以及供多个工作线程按批取用的路径来源。
+
+namespace AmazonChess
+{
+    // 按扩展名读取：.acj 为二进制日志（AmazonJournal.h），其余按 .acp 文本棋谱读取
+    inline bool LoadGameFile(const std::string& path, GameRecord& out)
+    {
+        static const char suffix[] = ".acj";
+        size_t n = sizeof(suffix) - 1;
+        if (path.size() >= n && path.compare(path.size() - n, n, suffix) == 0) return ReadJournal(path, out);
+        return LoadRecord(path, out);
+    }
+
+    // 列表文件的一行：去掉行尾空白，空行与 '#' 开头的注释返回 false
+    inline bool ParseListLine(std::string& line)
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+        return !line.empty() && line[0] != '#';
+    }
+
+    // 把列表文件中的路径依次追加到 out；文件打不开时返回 false
+    inline bool ReadPathList(const std::string& path, std::vector<std::string>& out)
+    {
+        std::ifstream ifs(path);
+        if (!ifs.is_open()) return false;
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            if (ParseListLine(line)) out.push_back(line);
+        }
+        return true;
+    }
+
+    // 路径来源：先是直接给出的路径，再依次是各列表文件中的行（'#' 开头为注释）。
+    // 列表文件边读边取，不预先读入内存；每条路径按出现顺序编号（从 0 开始），与取用的线程无关
+    class GameSource
+    {
+    public:
+        static constexpr size_t DEFAULT_BATCH = 64;
+
+        GameSource(std::vector<std::string> paths, std::vector<std::string> lists, size_t batch = DEFAULT_BATCH)
+            : direct(std::move(paths)), listPaths(std::move(lists)), batchSize(batch ? batch : 1)
+        {
+        }
+
+        // 取下一批路径，first 为其中第一条的编号；输入耗尽时返回 false
+        bool NextBatch(std::vector<std::string>& out, uint64_t& first)
+        {
+            out.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            first = next;
+            while (out.size() < batchSize)
+            {
+                if (nextDirect < direct.size())
+                {
+                    out.push_back(direct[nextDirect++]);
+                    continue;
+                }
+                if (!list.is_open())
+                {
+                    if (nextList >= listPaths.size()) break;
+                    const std::string& path = listPaths[nextList++];
+                    list.open(path);
+                    if (!list.is_open())
+                    {
+                        std::fprintf(stderr, "warning: cannot open list %s\n", path.c_str());
+                        continue;
+                    }
+                }
+                std::string line;
+                if (!std::getline(list, line))
+                {
+                    list.close();
+                    list.clear();
+                    continue;
+                }
+                if (ParseListLine(line)) out.push_back(line);
+            }
+            next += out.size();
+            return !out.empty();
+        }
+
+    private:
+        std::mutex mutex;
+        std::vector<std::string> direct;
+        size_t nextDirect = 0;
+        std::vector<std::string> listPaths;
+        size_t nextList = 0;
+        std::ifstream list;
+        size_t batchSize;
+        uint64_t next = 0;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,346 @@
+﻿// AmazonIndex.cpp : 对局库局面索引工具（Linux）
+// 把大量棋谱（.acp / .acj）中出现过的每个局面建成 局面键 -> (对局, 手数) 的有序磁盘索引（见 AmazonPositionIndex.h），
+// 查询“哪些对局走到过这个局面、结果如何”时只需内存映射索引文件做一次栅栏定位加块内二分，不再重放棋谱。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonIndex.cpp -o AmazonIndex
+//
+// 用法：AmazonIndex <子命令> [选项]
+//   build --out <index.aci> [--threads n] [--list file] [game.acp|game.acj ...]
+//        并行重放各棋谱（工作窃取线程池，每线程一段条目、各自排序），k 路归并后顺序写出。
+//        对局编号按输入顺序分配，结果与线程数无关。--list 文件每行一个棋谱路径，'#' 开头为注释。
+//   query <index.aci> (--fen "<board> <side>" | --game <game.acp|game.acj> [--ply n]) [--limit n]
+//        列出到达该局面的对局（路径、手数、胜者），并汇总双方胜局数；--game 省略 --ply 时取终局局面。
+//   bench <index.aci> [--lookups n] [--seed s]
+//        随机查找已存在的键与随机键各 n 次（只定位条目区间，不读出条目），给出每次查找的平均耗时。
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "AmazonGameSource.h"
+#include "AmazonPositionIndex.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const char* WinnerName(Player p)
+    {
+        return p == Player::White ? "white" : p == Player::Black ? "black" : "none";
+    }
+
+    void Usage()
+    {
+        std::fprintf(stderr, "usage: AmazonIndex build --out index.aci [--threads n] [--list file] [game.acp|game.acj ...]\n"
+                             "       AmazonIndex query index.aci (--fen \"board side\" | --game game.acp [--ply n]) [--limit n]\n"
+                             "       AmazonIndex bench index.aci [--lookups n] [--seed s]\n");
+    }
+
+    bool IsHelp(const char* arg)
+    {
+        return !std::strcmp(arg, "--help") || !std::strcmp(arg, "-h");
+    }
+
+    int Build(int argc, char* argv[])
+    {
+        std::string outPath;
+        size_t threads = WorkStealingPool::DefaultThreadCount();
+        std::vector<std::string> paths;
+        for (int i = 0; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--out") && hasValue) outPath = argv[++i];
+            else if (!std::strcmp(argv[i], "--threads") && hasValue) threads = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--list") && hasValue)
+            {
+                if (!ReadPathList(argv[++i], paths))
+                {
+                    std::fprintf(stderr, "cannot open list %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            else if (IsHelp(argv[i]))
+            {
+                Usage();
+                return 0;
+            }
+            else if (argv[i][0] != '-') paths.push_back(argv[i]);
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        if (outPath.empty() || paths.empty())
+        {
+            std::fprintf(stderr, "build needs --out and at least one game\n");
+            return 2;
+        }
+
+        Clock::time_point t0 = Clock::now();
+        std::vector<IndexedGame> games(paths.size());
+        std::vector<char> loaded(paths.size(), 0);
+        std::vector<std::vector<IndexEntry>> runs;
+        {
+            WorkStealingPool pool(threads);
+            runs.resize(pool.Size());
+            // 按块提交，减少任务调度开销；每个任务只写自己的 games / loaded 槽位与所在线程的段
+            const size_t chunk = 64;
+            for (size_t begin = 0; begin < paths.size(); begin += chunk)
+            {
+                size_t end = std::min(paths.size(), begin + chunk);
+                pool.Submit([&, begin, end](size_t worker) {
+                    for (size_t g = begin; g < end; ++g)
+                    {
+                        GameRecord record;
+                        games[g].path = paths[g];
+                        if (!LoadGameFile(paths[g], record)) continue;
+                        games[g].winner = CollectIndexEntries(record, static_cast<uint32_t>(g), runs[worker], games[g].plies);
+                        loaded[g] = 1;
+                    }
+                });
+            }
+            pool.Wait();
+            for (size_t r = 0; r < runs.size(); ++r)
+                pool.Submit([&runs, r](size_t) { std::sort(runs[r].begin(), runs[r].end()); });
+            pool.Wait();
+        }
+        double replaySec = SecondsSince(t0);
+
+        size_t failed = 0;
+        for (size_t g = 0; g < paths.size(); ++g)
+        {
+            if (loaded[g]) continue;
+            std::fprintf(stderr, "warning: cannot read record %s\n", paths[g].c_str());
+            ++failed;
+        }
+        uint64_t written = 0;
+        if (!WriteIndex(outPath, runs, games, &written))
+        {
+            std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+            return 1;
+        }
+        double totalSec = SecondsSince(t0);
+        std::printf("games %zu (%zu unreadable), positions %llu, replay+sort %.2f s, total %.2f s (%.0f positions/s)\n",
+                    paths.size(), failed, static_cast<unsigned long long>(written), replaySec, totalSec,
+                    totalSec > 0 ? written / totalSec : 0.0);
+        return 0;
+    }
+
+    int Query(int argc, char* argv[])
+    {
+        if (argc >= 1 && IsHelp(argv[0]))
+        {
+            Usage();
+            return 0;
+        }
+        if (argc < 1)
+        {
+            std::fprintf(stderr, "query needs an index file\n");
+            return 2;
+        }
+        std::string indexPath = argv[0];
+        std::string fen, gamePath;
+        int ply = -1;
+        size_t limit = 50;
+        for (int i = 1; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--fen") && hasValue) fen = argv[++i];
+            else if (!std::strcmp(argv[i], "--game") && hasValue) gamePath = argv[++i];
+            else if (!std::strcmp(argv[i], "--ply") && hasValue) ply = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i], "--limit") && hasValue) limit = std::strtoul(argv[++i], nullptr, 10);
+            else if (IsHelp(argv[i]))
+            {
+                Usage();
+                return 0;
+            }
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+
+        Position pos;
+        std::string error;
+        if (!fen.empty())
+        {
+            if (!ParseFen(fen, pos, error))
+            {
+                std::fprintf(stderr, "bad position: %s\n", error.c_str());
+                return 2;
+            }
+        }
+        else if (!gamePath.empty())
+        {
+            GameRecord record;
+            if (!LoadGameFile(gamePath, record))
+            {
+                std::fprintf(stderr, "cannot read record %s\n", gamePath.c_str());
+                return 1;
+            }
+            pos = record.start;
+            if (!record.moves.empty()) pos.SetSideToMove(record.moves[0].player);
+            size_t target = ply >= 0 ? std::min(record.moves.size(), static_cast<size_t>(ply)) : record.moves.size();
+            for (size_t i = 0; i < target; ++i)
+            {
+                if (!ApplyRecordedMove(pos, record.moves[i]))
+                {
+                    std::fprintf(stderr, "illegal move at ply %zu in %s\n", i, gamePath.c_str());
+                    return 1;
+                }
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "query needs --fen or --game\n");
+            return 2;
+        }
+
+        PositionIndex index;
+        if (!index.Open(indexPath, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        Clock::time_point t0 = Clock::now();
+        std::vector<IndexEntry> hits;
+        index.Find(pos.hash, hits);
+        double us = 1e6 * SecondsSince(t0);
+
+        std::printf("position %s\n", PositionToFen(pos).c_str());
+        size_t wins[3] = { 0, 0, 0 }; // none / white / black
+        uint32_t lastGame = UINT32_MAX;
+        size_t gameCount = 0, shown = 0;
+        for (const IndexEntry& e : hits)
+        {
+            IndexedGame g = index.Game(e.game);
+            if (e.game != lastGame)
+            {
+                ++gameCount;
+                ++wins[g.winner == Player::White ? 1 : g.winner == Player::Black ? 2 : 0];
+                lastGame = e.game;
+            }
+            if (shown++ < limit) std::printf("  %s ply %u/%u winner %s\n", g.path.c_str(), e.ply, g.plies, WinnerName(g.winner));
+        }
+        if (shown > limit) std::printf("  ... %zu more\n", shown - limit);
+        std::printf("%zu occurrences in %zu games: white won %zu, black won %zu, unfinished %zu (lookup %.1f us)\n",
+                    hits.size(), gameCount, wins[1], wins[2], wins[0], us);
+        return 0;
+    }
+
+    int Bench(int argc, char* argv[])
+    {
+        if (argc >= 1 && IsHelp(argv[0]))
+        {
+            Usage();
+            return 0;
+        }
+        if (argc < 1)
+        {
+            std::fprintf(stderr, "bench needs an index file\n");
+            return 2;
+        }
+        std::string indexPath = argv[0];
+        size_t lookups = 1000000;
+        uint64_t seed = 1;
+        for (int i = 1; i < argc; ++i)
+        {
+            bool hasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--lookups") && hasValue) lookups = std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+            else if (IsHelp(argv[i]))
+            {
+                Usage();
+                return 0;
+            }
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                return 2;
+            }
+        }
+        PositionIndex index;
+        std::string error;
+        if (!index.Open(indexPath, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (index.EntryCount() == 0)
+        {
+            std::fprintf(stderr, "index is empty\n");
+            return 1;
+        }
+        std::printf("entries %llu, games %llu\n", static_cast<unsigned long long>(index.EntryCount()),
+                    static_cast<unsigned long long>(index.GameCount()));
+
+        std::vector<uint64_t> present(lookups), random(lookups);
+        for (size_t i = 0; i < lookups; ++i)
+        {
+            present[i] = index.EntryAt(SplitMix64(seed) % index.EntryCount()).key;
+            random[i] = SplitMix64(seed);
+        }
+        const std::vector<uint64_t>* sets[2] = { &present, &random };
+        const char* names[2] = { "existing keys", "random keys" };
+        for (int s = 0; s < 2; ++s)
+        {
+            size_t found = 0;
+            Clock::time_point t0 = Clock::now();
+            for (uint64_t key : *sets[s])
+            {
+                std::pair<uint64_t, uint64_t> range = index.EqualRange(key);
+                found += static_cast<size_t>(range.second - range.first);
+            }
+            double sec = SecondsSince(t0);
+            std::printf("%-14s %10zu lookups %8.2f us/lookup %12zu entries found\n", names[s], lookups,
+                        lookups ? 1e6 * sec / lookups : 0.0, found);
+        }
+        return 0;
+    }
+
+    struct Command
+    {
+        const char* name;
+        int (*run)(int argc, char* argv[]);
+    };
+
+    const Command g_commands[] = {
+        { "build", Build },
+        { "query", Query },
+        { "bench", Bench },
+    };
+
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        Usage();
+        return 2;
+    }
+    if (IsHelp(argv[1]))
+    {
+        Usage();
+        return 0;
+    }
+    for (const Command& c : g_commands)
+    {
+        if (!std::strcmp(argv[1], c.name)) return c.run(argc - 2, argv + 2);
+    }
+    Usage();
+    return 2;
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <cstdio>
+#include <string>
+
+// 工具输出 JSON / JSONL 时共用的辅助函数。
+
+namespace AmazonChess
+{
+    // 转义为 JSON 字符串内容（不含两侧引号）：引号、反斜杠与控制字符
+    inline std::string JsonEscape(const std::string& s)
+    {
+        std::string out;
+        for (char c : s)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else out += c;
+            }
+        }
+        return out;
+    }
+
+    // 是否为可直接写作 JSON 数值的十进制整数（可带负号，不带前导零）
+    inline bool IsJsonInteger(const std::string& s)
+    {
+        size_t i = !s.empty() && s[0] == '-' ? 1 : 0;
+        if (i >= s.size() || (s[i] == '0' && i + 1 < s.size())) return false;
+        for (; i < s.size(); ++i)
+        {
+            if (s[i] < '0' || s[i] > '9') return false;
+        }
+        return true;
+    }
+} // namespace AmazonChess
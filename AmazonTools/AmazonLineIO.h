@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <cerrno>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+
+// 基于文件描述符的按行收发（POSIX），供子进程管道与套接字共用。
+
+namespace AmazonChess
+{
+    class LineChannel
+    {
+    public:
+        enum ReadStatus { ReadOk, ReadEof, ReadTimeout };
+
+        LineChannel() = default;
+        ~LineChannel() { Close(); }
+
+        LineChannel(const LineChannel&) = delete;
+        LineChannel& operator=(const LineChannel&) = delete;
+
+        // 接管描述符（管道时读写为两个描述符，套接字时为同一个）
+        void Attach(int readDescriptor, int writeDescriptor)
+        {
+            Close();
+            readFd = readDescriptor;
+            writeFd = writeDescriptor;
+            buffer.clear();
+        }
+
+        bool IsOpen() const { return readFd >= 0; }
+
+        bool WriteLine(const std::string& line)
+        {
+            if (writeFd < 0) return false;
+            std::string data = line + "\n";
+            size_t done = 0;
+            while (done < data.size())
+            {
+                ssize_t n = write(writeFd, data.data() + done, data.size() - done);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                done += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        // 读取一行（不含换行）；timeoutMs < 0 表示一直等待
+        ReadStatus ReadLine(std::string& line, int timeoutMs)
+        {
+            for (;;)
+            {
+                size_t nl = buffer.find('\n');
+                if (nl != std::string::npos)
+                {
+                    line.assign(buffer, 0, nl);
+                    buffer.erase(0, nl + 1);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return ReadOk;
+                }
+                if (readFd < 0) return ReadEof;
+                pollfd p = { readFd, POLLIN, 0 };
+                int r = poll(&p, 1, timeoutMs);
+                if (r < 0 && errno == EINTR) continue;
+                if (r == 0) return ReadTimeout;
+                char chunk[4096];
+                ssize_t n = read(readFd, chunk, sizeof(chunk));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return ReadEof;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+        }
+
+        void Close()
+        {
+            if (writeFd >= 0 && writeFd != readFd) close(writeFd);
+            if (readFd >= 0) close(readFd);
+            readFd = writeFd = -1;
+        }
+
+        int ReadDescriptor() const { return readFd; }
+
+    private:
+        int readFd = -1;
+        int writeFd = -1;
+        std::string buffer;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 只读内存映射文件（POSIX），供按需分页读取的大型磁盘表（局面索引等）使用。
+
+namespace AmazonChess
+{
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string& path)
+        {
+            Close();
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0)
+            {
+                close(fd);
+                return false;
+            }
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            close(fd); // 映射在关闭描述符后仍然有效
+            if (p == MAP_FAILED) return false;
+            data = static_cast<const unsigned char*>(p);
+            size = static_cast<size_t>(st.st_size);
+            return true;
+        }
+
+        // 随机访问为主时关闭预读，避免每次查找带入大量无关页
+        void AdviseRandom() const
+        {
+            if (data) madvise(const_cast<unsigned char*>(data), size, MADV_RANDOM);
+        }
+
+        bool IsOpen() const { return data != nullptr; }
+        const unsigned char* Data() const { return data; }
+        size_t Size() const { return size; }
+
+        void Close()
+        {
+            if (data) munmap(const_cast<unsigned char*>(data), size);
+            data = nullptr;
+            size = 0;
+        }
+
+    private:
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,438 @@
+﻿// AmazonMatch.cpp : 引擎对引擎并发对局与 SPRT 检验（Linux）
+// 两个引擎进程（AmazonEngine 协议，见 AmazonProtocol.h）在多个并发槽位上对弈：
+// 每个开局（.acp 棋谱前若干手）下两局并交换先后手，每局写为 .acp，
+// 按结果累计 Elo 与 SPRT 对数似然比，越过上下界即停止分派新对局。
+// 主循环只在引擎管道上阻塞等待，不做任何定时休眠。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonMatch.cpp -o AmazonMatch
+//
+// 用法：AmazonMatch --engine <cmd> --engine <cmd> [选项] [opening.acp ...]
+//   --engine <cmd>         引擎命令行（经 /bin/sh -c 执行），依次为 A、B，必须给出两次
+//   --go <args>            go 命令参数，两引擎共用（默认 "depth 2"）
+//   --go-a / --go-b <args> 分别指定 A / B 的 go 参数
+//   --openings <file>      开局列表文件，每行一个 .acp 路径
+//   --opening-plies <n>    每个开局取棋谱前 n 手（默认全部）
+//   --random-plies <n>     未给出开局时，每对对局从初始局面随机走 n 手合法走法作为开局（默认 4）；
+//                          引擎是确定性的，同一开局下的对局完全相同，若都从初始局面开始，SPRT 会把重复的对局当作独立样本
+//   --seed <s>             随机开局的种子（默认 1）：第 k 对的开局只由种子与 k 决定
+//   --games <n>            最多对局数（默认 1000，按开局成对分派）
+//   --concurrency <n>      并发对局数（默认硬件线程数的一半，每局占用两个引擎进程）
+//   --timeout <ms>         单步应答超时，超时判负（默认 0 = 不限）
+//   --out <dir>            对局 .acp 输出目录（默认不写）
+//   --elo0 / --elo1 <x>    SPRT 假设 H0 / H1 的 Elo 差（默认 0 / 10）
+//   --alpha / --beta <x>   SPRT 第一 / 二类错误率（默认 0.05）
+// 亚马逊棋没有和棋，结果按二项分布处理。
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AmazonProcess.h"
+#include "AmazonProtocol.h"
+#include "AmazonRecord.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    struct EngineSpec
+    {
+        std::string command;
+        std::string go = "depth 2";
+    };
+
+    // 开局：起始局面（含起始走子方）+ 走法序列（必须黑白交替，才能用 "position ... moves ..." 表达）
+    struct Opening
+    {
+        std::string source;
+        Position start = Position::Initial();
+        std::vector<Move> moves;
+    };
+
+    // 随机开局：从初始局面随机走 plies 手（走到已分胜负的局面前为止）
+    Opening RandomOpening(uint64_t seed, uint64_t pairIndex, int plies)
+    {
+        Opening out;
+        out.source = "random";
+        uint64_t rng = seed ^ (pairIndex * 0x9E3779B97F4A7C15ull);
+        Position pos = out.start;
+        MoveList moves;
+        for (int i = 0; i < plies; ++i)
+        {
+            GenerateMoves(pos, moves);
+            if (moves.count == 0) break;
+            Move m = moves[static_cast<int>(SplitMix64(rng) % static_cast<uint64_t>(moves.count))];
+            pos.Play(m);
+            if (WinnerOf(pos) != Player::None)
+            {
+                pos.Undo(m);
+                break;
+            }
+            out.moves.push_back(m);
+        }
+        return out;
+    }
+
+    bool LoadOpening(const std::string& path, int maxPlies, Opening& out)
+    {
+        GameRecord record;
+        if (!LoadRecord(path, record)) return false;
+        out.source = path;
+        out.moves.clear();
+        Position pos = record.start;
+        if (!record.moves.empty()) pos.SetSideToMove(record.moves[0].player);
+        out.start = pos;
+        size_t count = maxPlies >= 0 ? std::min(record.moves.size(), static_cast<size_t>(maxPlies)) : record.moves.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const RecordedMove& rm = record.moves[i];
+            if (i > 0 && rm.player != pos.sideToMove) return false;
+            if (!ApplyRecordedMove(pos, rm)) return false;
+            out.moves.push_back(rm.move);
+        }
+        // 开局本身已分出胜负则无法对弈
+        return WinnerOf(pos) == Player::None;
+    }
+
+    // 协议客户端：一个引擎进程
+    class EnginePlayer
+    {
+    public:
+        bool Start(const EngineSpec& spec, int timeoutMs)
+        {
+            this->spec = spec;
+            this->timeoutMs = timeoutMs;
+            if (!process.Start(spec.command)) return false;
+            return process.WriteLine("hello") && WaitFor("hellook");
+        }
+
+        bool IsRunning() const { return process.IsRunning(); }
+
+        bool NewGame()
+        {
+            return process.WriteLine("newgame") && process.WriteLine("isready") && WaitFor("readyok");
+        }
+
+        // 请求一手；引擎无应答、退出或返回格式错误时返回 false
+        bool BestMove(const std::string& positionCommand, Move& out, bool& none)
+        {
+            if (!process.WriteLine(positionCommand) || !process.WriteLine("go " + spec.go)) return false;
+            std::string line;
+            for (;;)
+            {
+                if (process.ReadLine(line, timeoutMs > 0 ? timeoutMs : -1) != LineChannel::ReadOk) return false;
+                std::vector<std::string> t = SplitTokens(line);
+                if (t.size() < 2 || t[0] != "bestmove") continue;
+                none = t[1] == "none";
+                return none || ParseMoveToken(t[1], out);
+            }
+        }
+
+        void Stop()
+        {
+            process.WriteLine("quit");
+            process.Terminate();
+        }
+
+    private:
+        bool WaitFor(const std::string& expected)
+        {
+            std::string line;
+            for (;;)
+            {
+                if (process.ReadLine(line, timeoutMs > 0 ? timeoutMs : -1) != LineChannel::ReadOk) return false;
+                if (line == expected) return true;
+            }
+        }
+
+        EngineSpec spec;
+        int timeoutMs = 0;
+        ChildProcess process;
+    };
+
+    // 二项 SPRT（无和棋）
+    struct Sprt
+    {
+        double elo0 = 0.0, elo1 = 10.0;
+        double alpha = 0.05, beta = 0.05;
+
+        static double ExpectedScore(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+        double Llr(uint64_t wins, uint64_t losses) const
+        {
+            double p0 = ExpectedScore(elo0), p1 = ExpectedScore(elo1);
+            return wins * std::log(p1 / p0) + losses * std::log((1.0 - p1) / (1.0 - p0));
+        }
+
+        double LowerBound() const { return std::log(beta / (1.0 - alpha)); }
+        double UpperBound() const { return std::log((1.0 - beta) / alpha); }
+    };
+
+    // Elo 估计与 95% 置信半径
+    void EloEstimate(uint64_t wins, uint64_t losses, double& elo, double& margin)
+    {
+        double n = static_cast<double>(wins + losses);
+        double s = n > 0 ? (wins + 0.5) / (n + 1.0) : 0.5; // 避免全胜 / 全负时发散
+        auto toElo = [](double p) { return -400.0 * std::log10(1.0 / p - 1.0); };
+        elo = toElo(s);
+        double se = n > 0 ? std::sqrt(s * (1.0 - s) / n) : 0.0;
+        double hi = std::min(0.999, s + 1.96 * se), lo = std::max(0.001, s - 1.96 * se);
+        margin = (toElo(hi) - toElo(lo)) / 2.0;
+    }
+
+    struct MatchConfig
+    {
+        EngineSpec engines[2];
+        std::vector<Opening> openings;
+        int randomPlies = 4;
+        uint64_t seed = 1;
+        uint64_t maxGames = 1000;
+        int timeoutMs = 0;
+        std::string outDir;
+        Sprt sprt;
+    };
+
+    enum class Verdict { Running, AcceptH0, AcceptH1 };
+
+    class Match
+    {
+    public:
+        explicit Match(const MatchConfig& config) : config(config) {}
+
+        void Run(size_t concurrency)
+        {
+            std::vector<std::thread> slots;
+            for (size_t i = 0; i < concurrency; ++i) slots.emplace_back([this] { SlotLoop(); });
+            for (auto& t : slots) t.join();
+        }
+
+        void Report(bool final) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            double elo, margin;
+            EloEstimate(wins, losses, elo, margin);
+            std::fprintf(stderr, "%sgames %llu  A %llu - %llu B  elo %+.1f +/- %.1f  LLR %.2f [%.2f, %.2f]%s\n",
+                         final ? "final: " : "",
+                         static_cast<unsigned long long>(wins + losses),
+                         static_cast<unsigned long long>(wins), static_cast<unsigned long long>(losses),
+                         elo, margin, config.sprt.Llr(wins, losses),
+                         config.sprt.LowerBound(), config.sprt.UpperBound(),
+                         verdict == Verdict::AcceptH1 ? "  H1 accepted" : verdict == Verdict::AcceptH0 ? "  H0 accepted" : "");
+        }
+
+        bool StartFailed() const { return startFailed.load(); }
+
+    private:
+        // 一个并发槽位：持有 A、B 两个引擎进程，连续领取对局；进程异常时重启
+        void SlotLoop()
+        {
+            EnginePlayer players[2];
+            for (;;)
+            {
+                uint64_t index = nextGame.fetch_add(1, std::memory_order_relaxed);
+                if (index >= config.maxGames || stopping.load(std::memory_order_relaxed)) break;
+                for (int e = 0; e < 2; ++e)
+                {
+                    if (!players[e].IsRunning() && !players[e].Start(config.engines[e], config.timeoutMs))
+                    {
+                        std::cerr << "cannot start engine " << config.engines[e].command << "\n";
+                        startFailed = true;
+                        stopping = true;
+                        return;
+                    }
+                }
+                // 成对分派：第 2k 与 2k+1 局使用同一开局，A 分别执白 / 执黑；未给出开局文件时按种子生成第 k 对的随机开局
+                Opening generated;
+                const Opening* opening = nullptr;
+                if (!config.openings.empty()) opening = &config.openings[(index / 2) % config.openings.size()];
+                else if (config.randomPlies > 0)
+                {
+                    generated = RandomOpening(config.seed, index / 2, config.randomPlies);
+                    opening = &generated;
+                }
+                int whiteEngine = static_cast<int>(index % 2);
+                bool aWon = PlayGame(players, whiteEngine, opening, index);
+                Record(aWon);
+            }
+            for (auto& p : players) p.Stop();
+        }
+
+        // 返回 A 是否获胜；引擎失去响应或走出非法手判负，并重启该引擎
+        bool PlayGame(EnginePlayer players[2], int whiteEngine, const Opening* opening, uint64_t index)
+        {
+            Position pos = opening ? opening->start : Position::Initial();
+            GameRecord record;
+            record.start = pos;
+            std::string command = "position " + PositionSetupTokens(pos) + " moves";
+            if (opening)
+            {
+                for (const Move& m : opening->moves)
+                {
+                    record.moves.push_back({ pos.sideToMove, m });
+                    pos.Play(m);
+                    command += " " + MoveToToken(m);
+                }
+            }
+
+            players[0].NewGame();
+            players[1].NewGame();
+            int loser = -1; // 引擎编号
+            for (;;)
+            {
+                Player winner = WinnerOf(pos);
+                if (winner != Player::None)
+                {
+                    record.finished = true;
+                    loser = (winner == Player::White) ? 1 - whiteEngine : whiteEngine;
+                    break;
+                }
+                int mover = (pos.sideToMove == Player::White) ? whiteEngine : 1 - whiteEngine;
+                Move m;
+                bool none = false;
+                if (!players[mover].BestMove(command, m, none) || none || !IsLegalMove(pos, m))
+                {
+                    std::cerr << "game " << index << ": engine " << (mover == 0 ? "A" : "B") << " failed, scoring as loss\n";
+                    players[mover].Stop();
+                    loser = mover;
+                    break;
+                }
+                record.moves.push_back({ pos.sideToMove, m });
+                pos.Play(m);
+                command += " " + MoveToToken(m);
+            }
+
+            if (!config.outDir.empty())
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/game_%06llu.acp", static_cast<unsigned long long>(index));
+                if (!SaveRecord(config.outDir + name, record))
+                    std::cerr << "warning: cannot write " << config.outDir << name << "\n";
+            }
+            return loser == 1;
+        }
+
+        void Record(bool aWon)
+        {
+            bool report = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (aWon) ++wins; else ++losses;
+                if (verdict == Verdict::Running)
+                {
+                    double llr = config.sprt.Llr(wins, losses);
+                    if (llr >= config.sprt.UpperBound()) verdict = Verdict::AcceptH1;
+                    else if (llr <= config.sprt.LowerBound()) verdict = Verdict::AcceptH0;
+                    if (verdict != Verdict::Running) stopping = true;
+                }
+                report = (wins + losses) % 100 == 0;
+            }
+            if (report) Report(false);
+        }
+
+        const MatchConfig& config;
+        std::atomic<uint64_t> nextGame{ 0 };
+        std::atomic<bool> stopping{ false };
+        std::atomic<bool> startFailed{ false };
+        mutable std::mutex mutex;
+        uint64_t wins = 0;   // A 胜局数
+        uint64_t losses = 0; // A 负局数
+        Verdict verdict = Verdict::Running;
+    };
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonMatch --engine cmd --engine cmd [--go args] [--go-a args] [--go-b args]\n"
+                     "                   [--openings file] [--opening-plies n] [--random-plies n] [--seed s]\n"
+                     "                   [--games n] [--concurrency n]\n"
+                     "                   [--timeout ms] [--out dir] [--elo0 x] [--elo1 x] [--alpha x] [--beta x]\n"
+                     "                   [opening.acp ...]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    MatchConfig config;
+    int engineCount = 0;
+    int openingPlies = -1;
+    size_t concurrency = std::max(1u, std::thread::hardware_concurrency() / 2);
+    std::vector<std::string> openingPaths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--engine")
+        {
+            if (engineCount >= 2) { Usage(); return 2; }
+            config.engines[engineCount++].command = next();
+        }
+        else if (arg == "--go") config.engines[0].go = config.engines[1].go = next();
+        else if (arg == "--go-a") config.engines[0].go = next();
+        else if (arg == "--go-b") config.engines[1].go = next();
+        else if (arg == "--openings")
+        {
+            std::ifstream ifs(next());
+            if (!ifs.is_open())
+            {
+                std::cerr << "cannot open list " << argv[i] << "\n";
+                return 1;
+            }
+            std::string line;
+            while (std::getline(ifs, line))
+            {
+                std::istringstream iss(line);
+                std::string path;
+                if ((iss >> path) && path[0] != '#') openingPaths.push_back(path);
+            }
+        }
+        else if (arg == "--opening-plies") openingPlies = std::atoi(next());
+        else if (arg == "--random-plies") config.randomPlies = std::atoi(next());
+        else if (arg == "--seed") config.seed = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--games") config.maxGames = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--concurrency") concurrency = std::max<size_t>(1, std::strtoul(next(), nullptr, 10));
+        else if (arg == "--timeout") config.timeoutMs = std::atoi(next());
+        else if (arg == "--out") config.outDir = next();
+        else if (arg == "--elo0") config.sprt.elo0 = std::atof(next());
+        else if (arg == "--elo1") config.sprt.elo1 = std::atof(next());
+        else if (arg == "--alpha") config.sprt.alpha = std::atof(next());
+        else if (arg == "--beta") config.sprt.beta = std::atof(next());
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else if (!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+        else openingPaths.push_back(arg);
+    }
+    if (engineCount != 2) { Usage(); return 2; }
+
+    for (const std::string& path : openingPaths)
+    {
+        Opening o;
+        if (LoadOpening(path, openingPlies, o)) config.openings.push_back(o);
+        else std::cerr << "warning: skipping opening " << path << "\n";
+    }
+    if (!openingPaths.empty() && config.openings.empty())
+    {
+        std::cerr << "no usable openings\n";
+        return 1;
+    }
+
+    if (config.openings.empty() && config.randomPlies <= 0)
+        std::cerr << "warning: no openings and --random-plies 0, every game pair starts from the same position\n";
+
+    std::signal(SIGPIPE, SIG_IGN);
+    Match match(config);
+    match.Run(concurrency);
+    match.Report(true);
+    return match.StartFailed() ? 1 : 0;
+}
@@ -0,0 +1,302 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <vector>
+#include "AmazonMappedFile.h"
+#include "AmazonRecord.h"
+
+// 局面索引（.aci）：局面 Zobrist 键 -> (对局编号, 手数) 的有序磁盘表，按需内存映射读取。
+// 文件布局（多字节字段均为小端）：
+//   文件头 64 字节：magic "ACIX"、版本、条目数 u64、对局数 u64、栅栏步长 u32、保留 u32、
+//                   条目 / 栅栏 / 对局表 / 路径区 四段的文件偏移（各 u64）
+//   条目   每条 16 字节：key u64、game u32、ply u16、保留 u16，按 (key, game, ply) 升序
+//   栅栏   每 fenceStride 条取一个 key（u64），打开时整段读入内存，查找先在栅栏上二分定位到一个块
+//   对局表 每局 16 字节：路径在路径区中的偏移 u64、路径长度 u32、手数 u16、胜者 u8（0 未结束 / 1 白 / 2 黑）、保留 u8
+//   路径区 各对局的文件路径（不含结尾 0）
+// 局面键即 Position::hash（含走子方）；每局记录第 0..n 手之前的局面与终局局面。
+
+namespace AmazonChess
+{
+    static constexpr uint32_t INDEX_MAGIC = 0x58494341; // "ACIX"
+    static constexpr uint32_t INDEX_VERSION = 1;
+    static constexpr size_t INDEX_HEADER_BYTES = 64;
+    static constexpr size_t INDEX_ENTRY_BYTES = 16;
+    static constexpr size_t INDEX_GAME_BYTES = 16;
+    static constexpr uint32_t INDEX_FENCE_STRIDE = 256; // 一个块 4 KB，恰为一页
+
+    struct IndexEntry
+    {
+        uint64_t key = 0;
+        uint32_t game = 0;
+        uint16_t ply = 0;
+
+        bool operator<(const IndexEntry& o) const
+        {
+            if (key != o.key) return key < o.key;
+            if (game != o.game) return game < o.game;
+            return ply < o.ply;
+        }
+    };
+
+    struct IndexedGame
+    {
+        std::string path;
+        uint16_t plies = 0;
+        Player winner = Player::None; // None 表示未分出胜负
+    };
+
+    namespace IndexDetail
+    {
+        inline void PutU64(unsigned char* p, uint64_t v)
+        {
+            for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+
+        inline uint64_t GetU64(const unsigned char* p)
+        {
+            uint64_t v = 0;
+            for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        // 任意字节数的小端读写（对局表与文件头中的窄字段）
+        inline uint64_t GetLE(const unsigned char* p, int bytes)
+        {
+            uint64_t v = 0;
+            for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+            return v;
+        }
+
+        inline void PutLE(unsigned char* p, uint64_t v, int bytes)
+        {
+            for (int i = 0; i < bytes; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+
+        inline void EncodeEntry(const IndexEntry& e, unsigned char* out)
+        {
+            PutU64(out, e.key);
+            PutLE(out + 8, e.game, 4);
+            PutLE(out + 12, e.ply, 2);
+            out[14] = out[15] = 0;
+        }
+
+        inline IndexEntry DecodeEntry(const unsigned char* in)
+        {
+            IndexEntry e;
+            e.key = GetU64(in);
+            e.game = static_cast<uint32_t>(GetLE(in + 8, 4));
+            e.ply = static_cast<uint16_t>(GetLE(in + 12, 2));
+            return e;
+        }
+    } // namespace IndexDetail
+
+    // 记谱中出现的全部局面（第 0..n 手之前与终局），追加到 out；返回终局局面的胜者
+    inline Player CollectIndexEntries(const GameRecord& record, uint32_t game, std::vector<IndexEntry>& out, uint16_t& plies)
+    {
+        Position pos = record.start;
+        if (!record.moves.empty()) pos.SetSideToMove(record.moves[0].player);
+        plies = 0;
+        out.push_back({ pos.hash, game, 0 });
+        for (const RecordedMove& rm : record.moves)
+        {
+            if (!ApplyRecordedMove(pos, rm)) break;
+            ++plies;
+            out.push_back({ pos.hash, game, plies });
+        }
+        return WinnerOf(pos);
+    }
+
+    // 写出索引：runs 为各自已排序的条目序列（通常每个构建线程一段），在此 k 路归并后顺序写出
+    inline bool WriteIndex(const std::string& path, const std::vector<std::vector<IndexEntry>>& runs,
+                           const std::vector<IndexedGame>& games, uint64_t* entriesWritten = nullptr)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        unsigned char header[INDEX_HEADER_BYTES] = {};
+        bool ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header); // 占位，最后回填
+
+        // 条目：小顶堆按 (条目, 段号) 归并
+        typedef std::pair<IndexEntry, size_t> Head;
+        auto greater = [](const Head& a, const Head& b) { return b.first < a.first; };
+        std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+        std::vector<size_t> next(runs.size(), 0);
+        for (size_t r = 0; r < runs.size(); ++r)
+            if (!runs[r].empty()) heap.push(Head(runs[r][0], r));
+        std::vector<uint64_t> fences;
+        std::vector<unsigned char> buffer;
+        buffer.reserve(INDEX_ENTRY_BYTES * 65536);
+        uint64_t count = 0;
+        while (ok && !heap.empty())
+        {
+            Head h = heap.top();
+            heap.pop();
+            if (count % INDEX_FENCE_STRIDE == 0) fences.push_back(h.first.key);
+            size_t at = buffer.size();
+            buffer.resize(at + INDEX_ENTRY_BYTES);
+            IndexDetail::EncodeEntry(h.first, &buffer[at]);
+            ++count;
+            if (buffer.size() >= INDEX_ENTRY_BYTES * 65536)
+            {
+                ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+                buffer.clear();
+            }
+            if (++next[h.second] < runs[h.second].size()) heap.push(Head(runs[h.second][next[h.second]], h.second));
+        }
+        if (ok && !buffer.empty()) ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+
+        uint64_t entriesOffset = INDEX_HEADER_BYTES;
+        uint64_t fencesOffset = entriesOffset + count * INDEX_ENTRY_BYTES;
+        buffer.assign(fences.size() * 8, 0);
+        for (size_t i = 0; i < fences.size(); ++i) IndexDetail::PutU64(&buffer[i * 8], fences[i]);
+        if (ok && !buffer.empty()) ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+
+        uint64_t gamesOffset = fencesOffset + fences.size() * 8;
+        uint64_t namesOffset = gamesOffset + games.size() * INDEX_GAME_BYTES;
+        buffer.assign(games.size() * INDEX_GAME_BYTES, 0);
+        uint64_t nameAt = 0;
+        for (size_t g = 0; g < games.size(); ++g)
+        {
+            unsigned char* p = &buffer[g * INDEX_GAME_BYTES];
+            IndexDetail::PutU64(p, nameAt);
+            IndexDetail::PutLE(p + 8, games[g].path.size(), 4);
+            IndexDetail::PutLE(p + 12, games[g].plies, 2);
+            p[14] = games[g].winner == Player::White ? 1 : games[g].winner == Player::Black ? 2 : 0;
+            nameAt += games[g].path.size();
+        }
+        if (ok && !buffer.empty()) ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        for (size_t g = 0; ok && g < games.size(); ++g)
+            ok = std::fwrite(games[g].path.data(), 1, games[g].path.size(), file) == games[g].path.size();
+
+        IndexDetail::PutLE(header, INDEX_MAGIC, 4);
+        IndexDetail::PutLE(header + 4, INDEX_VERSION, 4);
+        IndexDetail::PutU64(header + 8, count);
+        IndexDetail::PutU64(header + 16, games.size());
+        IndexDetail::PutLE(header + 24, INDEX_FENCE_STRIDE, 4);
+        IndexDetail::PutU64(header + 32, entriesOffset);
+        IndexDetail::PutU64(header + 40, fencesOffset);
+        IndexDetail::PutU64(header + 48, gamesOffset);
+        IndexDetail::PutU64(header + 56, namesOffset);
+        if (ok) ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+        ok = (std::fclose(file) == 0) && ok;
+        if (entriesWritten) *entriesWritten = count;
+        return ok;
+    }
+
+    // 只读索引：条目与对局表按需分页，栅栏常驻内存（条目数 / 256 个 u64）
+    class PositionIndex
+    {
+    public:
+        bool Open(const std::string& path, std::string& error)
+        {
+            if (!file.Open(path))
+            {
+                error = "cannot map " + path;
+                return false;
+            }
+            const unsigned char* h = file.Data();
+            if (file.Size() < INDEX_HEADER_BYTES || IndexDetail::GetLE(h, 4) != INDEX_MAGIC
+                || IndexDetail::GetLE(h + 4, 4) != INDEX_VERSION)
+            {
+                error = path + " is not a position index";
+                return false;
+            }
+            entryCount = IndexDetail::GetU64(h + 8);
+            gameCount = IndexDetail::GetU64(h + 16);
+            stride = static_cast<uint32_t>(IndexDetail::GetLE(h + 24, 4));
+            uint64_t entriesOffset = IndexDetail::GetU64(h + 32);
+            uint64_t fencesOffset = IndexDetail::GetU64(h + 40);
+            uint64_t gamesOffset = IndexDetail::GetU64(h + 48);
+            uint64_t namesOffset = IndexDetail::GetU64(h + 56);
+            // 各段须完整落在文件内；文件头可能已损坏，全部按 uint64_t 比较且不做可能溢出的乘加
+            uint64_t size = file.Size();
+            uint64_t fenceCount = stride ? entryCount / stride + (entryCount % stride != 0) : 0;
+            if (stride == 0 || !Fits(entriesOffset, entryCount, INDEX_ENTRY_BYTES, size)
+                || !Fits(fencesOffset, fenceCount, 8, size) || !Fits(gamesOffset, gameCount, INDEX_GAME_BYTES, size)
+                || namesOffset > size)
+            {
+                error = path + " is truncated";
+                return false;
+            }
+            entries = h + entriesOffset;
+            games = h + gamesOffset;
+            names = h + namesOffset;
+            namesBytes = size - namesOffset;
+            fences.resize(fenceCount);
+            for (uint64_t i = 0; i < fenceCount; ++i) fences[i] = IndexDetail::GetU64(h + fencesOffset + i * 8);
+            file.AdviseRandom();
+            return true;
+        }
+
+        uint64_t EntryCount() const { return entryCount; }
+        uint64_t GameCount() const { return gameCount; }
+
+        IndexEntry EntryAt(uint64_t i) const { return IndexDetail::DecodeEntry(entries + i * INDEX_ENTRY_BYTES); }
+
+        // 键为 key 的条目区间 [first, second)：先在栅栏上定位，再在块内二分，只读两三个页
+        std::pair<uint64_t, uint64_t> EqualRange(uint64_t key) const
+        {
+            // 第一个 >= key 的条目不早于最后一个 < key 的栅栏所在块；第一个 > key 的条目不晚于第一个 > key 的栅栏
+            size_t lowFence = static_cast<size_t>(std::lower_bound(fences.begin(), fences.end(), key) - fences.begin());
+            size_t highFence = static_cast<size_t>(std::upper_bound(fences.begin(), fences.end(), key) - fences.begin());
+            uint64_t lo = lowFence == 0 ? 0 : static_cast<uint64_t>(lowFence - 1) * stride;
+            uint64_t hi = std::min<uint64_t>(entryCount, static_cast<uint64_t>(highFence) * stride);
+            uint64_t first = SearchKey(lo, hi, key, false);
+            return std::make_pair(first, SearchKey(first, hi, key, true));
+        }
+
+        // 键为 key 的全部条目（按对局、手数升序）追加到 out，返回条数
+        size_t Find(uint64_t key, std::vector<IndexEntry>& out) const
+        {
+            std::pair<uint64_t, uint64_t> range = EqualRange(key);
+            for (uint64_t i = range.first; i < range.second; ++i) out.push_back(EntryAt(i));
+            return static_cast<size_t>(range.second - range.first);
+        }
+
+        IndexedGame Game(uint32_t id) const
+        {
+            IndexedGame g;
+            if (id >= gameCount) return g;
+            const unsigned char* p = games + static_cast<uint64_t>(id) * INDEX_GAME_BYTES;
+            uint64_t at = IndexDetail::GetU64(p);
+            uint32_t length = static_cast<uint32_t>(IndexDetail::GetLE(p + 8, 4));
+            if (at <= namesBytes && length <= namesBytes - at) g.path.assign(reinterpret_cast<const char*>(names + at), length);
+            g.plies = static_cast<uint16_t>(IndexDetail::GetLE(p + 12, 2));
+            g.winner = p[14] == 1 ? Player::White : p[14] == 2 ? Player::Black : Player::None;
+            return g;
+        }
+
+    private:
+        // 从 offset 起的 count 个 unit 字节的记录是否都在 size 字节的文件内
+        static bool Fits(uint64_t offset, uint64_t count, uint64_t unit, uint64_t size)
+        {
+            return offset <= size && count <= (size - offset) / unit;
+        }
+
+        // [lo, hi) 内第一个 key >= 目标（upper 时为 > 目标）的条目
+        uint64_t SearchKey(uint64_t lo, uint64_t hi, uint64_t key, bool upper) const
+        {
+            while (lo < hi)
+            {
+                uint64_t mid = lo + (hi - lo) / 2;
+                uint64_t k = IndexDetail::GetU64(entries + mid * INDEX_ENTRY_BYTES);
+                if (k < key || (upper && k == key)) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        MappedFile file;
+        const unsigned char* entries = nullptr;
+        const unsigned char* games = nullptr;
+        const unsigned char* names = nullptr;
+        uint64_t namesBytes = 0;      // 路径区到文件末尾的字节数
+        uint64_t entryCount = 0;
+        uint64_t gameCount = 0;
+        uint32_t stride = INDEX_FENCE_STRIDE;
+        std::vector<uint64_t> fences;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "AmazonLineIO.h"
+
+// 子进程（POSIX）：经 /bin/sh -c 启动命令，通过管道按行收发，供驱动 AmazonEngine 的工具使用。
+// 所有管道带 O_CLOEXEC，多线程并发启动子进程时不会把别的子进程的管道泄漏进去。
+// 调用方应忽略 SIGPIPE（signal(SIGPIPE, SIG_IGN)），子进程退出后写入只返回失败。
+
+namespace AmazonChess
+{
+    // 直接 exec 启动进程（不经 shell、不重定向标准输入输出），返回 pid，失败返回 -1；调用方负责 waitpid
+    inline pid_t SpawnProcess(const std::vector<std::string>& args)
+    {
+        if (args.empty()) return -1;
+        std::vector<char*> argv;
+        for (const std::string& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+        return pid;
+    }
+
+    class ChildProcess
+    {
+    public:
+        using ReadStatus = LineChannel::ReadStatus;
+
+        ChildProcess() = default;
+        ~ChildProcess() { Terminate(); }
+
+        ChildProcess(const ChildProcess&) = delete;
+        ChildProcess& operator=(const ChildProcess&) = delete;
+
+        bool Start(const std::string& command)
+        {
+            Terminate();
+            int toChild[2], fromChild[2];
+            if (pipe2(toChild, O_CLOEXEC) != 0) return false;
+            if (pipe2(fromChild, O_CLOEXEC) != 0)
+            {
+                close(toChild[0]);
+                close(toChild[1]);
+                return false;
+            }
+            pid = fork();
+            if (pid < 0)
+            {
+                close(toChild[0]); close(toChild[1]);
+                close(fromChild[0]); close(fromChild[1]);
+                return false;
+            }
+            if (pid == 0)
+            {
+                // 子进程：dup2 得到的 0 / 1 不带 CLOEXEC，其余管道在 exec 时自动关闭
+                dup2(toChild[0], 0);
+                dup2(fromChild[1], 1);
+                execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+                _exit(127);
+            }
+            close(toChild[0]);
+            close(fromChild[1]);
+            channel.Attach(fromChild[0], toChild[1]);
+            return true;
+        }
+
+        bool IsRunning() const { return pid > 0; }
+
+        bool WriteLine(const std::string& line) { return channel.WriteLine(line); }
+
+        // 读取一行（不含换行）；timeoutMs < 0 表示一直等待
+        ReadStatus ReadLine(std::string& line, int timeoutMs) { return channel.ReadLine(line, timeoutMs); }
+
+        // 关闭管道并回收子进程；子进程未在关闭输入后退出时强制结束
+        void Terminate()
+        {
+            channel.Close();
+            if (pid > 0)
+            {
+                int status;
+                if (waitpid(pid, &status, WNOHANG) == 0)
+                {
+                    kill(pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                }
+                pid = -1;
+            }
+        }
+
+    private:
+        pid_t pid = -1;
+        LineChannel channel;
+    };
+} // namespace AmazonChess
@@ -0,0 +1,186 @@
+﻿// AmazonSelfPlay.cpp : 无界面自对弈训练数据生成工具
+// 在工作窃取线程池上并发进行多局自对弈（每个工作线程拥有独立 Engine），
+// 开局前若干手随机走子以增加多样性，其后每一手的（局面、搜索分值、终局胜负）写入二进制分片（见 AmazonShard.h）。
+// 样本按局缓存、按批写盘，分片达到上限后自动切换文件，长时间运行内存不增长；Ctrl+C 时下完当前各局并写盘后退出。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonSelfPlay.cpp -o AmazonSelfPlay
+//
+// 用法：AmazonSelfPlay [选项]
+//   --games <n>          对局数（0 = 不限，直到 Ctrl+C；默认 1000）
+//   --threads <n>        工作线程数（默认硬件线程数）
+//   --depth <d>          搜索深度（默认 2）
+//   --nodes <n>          每手节点上限（0 = 不限）
+//   --movetime <ms>      每手时间上限（0 = 不限）
+//   --hash <mb>          每个工作线程的置换表大小（默认 16）
+//   --net <file>         使用神经网络权重文件评估（默认开放度评估）
+//   --eval <file>        使用评估权重文件（AmazonTune 输出）
+//   --random-plies <k>   开局随机走子手数（默认 6，这些局面不记录）
+//   --seed <s>           随机种子（默认 1；第 i 局使用 seed 与 i 派生的独立序列，结果可复现）
+//   --out <prefix>       分片文件前缀（默认 selfplay，生成 selfplay_00000.bin ...）
+//   --shard-samples <n>  每个分片的样本数（默认 1000000）
+//   --flush-samples <n>  写盘批大小（默认 65536）
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AmazonSelfPlay.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    volatile std::sig_atomic_t g_interrupted = 0;
+
+    void OnInterrupt(int)
+    {
+        g_interrupted = 1;
+    }
+
+    struct SelfPlayConfig
+    {
+        uint64_t games = 1000;
+        SelfPlaySettings settings;
+    };
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonSelfPlay [--games n] [--threads n] [--depth d] [--nodes n] [--movetime ms]\n"
+                     "                      [--hash mb] [--net file] [--eval file] [--random-plies k] [--seed s]\n"
+                     "                      [--out prefix] [--shard-samples n] [--flush-samples n]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    SelfPlayConfig config;
+    config.settings.limits.maxDepth = 2;
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    size_t hashMb = 16;
+    std::string netPath;
+    std::string evalPath;
+    std::string outPrefix = "selfplay";
+    size_t shardSamples = 1000000;
+    size_t flushSamples = 65536;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--games") config.games = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--threads") threads = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--depth") config.settings.limits.maxDepth = std::atoi(next());
+        else if (arg == "--nodes") config.settings.limits.maxNodes = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--movetime") config.settings.limits.maxTimeMs = std::atoll(next());
+        else if (arg == "--hash") hashMb = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--net") netPath = next();
+        else if (arg == "--eval") evalPath = next();
+        else if (arg == "--random-plies") config.settings.randomPlies = std::atoi(next());
+        else if (arg == "--seed") config.settings.seed = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--out") outPrefix = next();
+        else if (arg == "--shard-samples") shardSamples = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--flush-samples") flushSamples = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else { Usage(); return 2; }
+    }
+
+    std::shared_ptr<Network> network;
+    if (!netPath.empty())
+    {
+        network = std::make_shared<Network>();
+        if (!network->Load(netPath))
+        {
+            std::cerr << "cannot load network " << netPath << "\n";
+            return 1;
+        }
+    }
+    std::shared_ptr<const EvalParams> evalParams;
+    if (!evalPath.empty() && !(evalParams = LoadEvalParams(evalPath)))
+    {
+        std::cerr << "cannot load weights " << evalPath << "\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, OnInterrupt);
+    std::signal(SIGTERM, OnInterrupt);
+
+    ShardWriter writer(outPrefix, shardSamples, flushSamples);
+    std::atomic<uint64_t> nextGame{ 0 };
+    std::atomic<uint64_t> finishedGames{ 0 };
+    std::atomic<uint64_t> generatedSamples{ 0 };
+    std::atomic<bool> writeFailed{ false };
+
+    // 每个工作线程一个长期任务，从共享计数器领取对局编号：在途状态只有每线程一局
+    WorkStealingPool pool(threads);
+    for (size_t t = 0; t < pool.Size(); ++t)
+    {
+        pool.Submit([&](size_t) {
+            Engine engine(hashMb);
+            engine.SetNetwork(network);
+            engine.SetEvalParams(evalParams);
+            std::unique_ptr<MoveList> moves(new MoveList());
+            SelfPlayGame game;
+            for (;;)
+            {
+                if (g_interrupted || writeFailed.load(std::memory_order_relaxed)) return;
+                uint64_t index = nextGame.fetch_add(1, std::memory_order_relaxed);
+                if (config.games && index >= config.games) return;
+                PlaySelfPlayGame(engine, *moves, config.settings, index, game);
+                if (!writer.Append(game.samples))
+                {
+                    writeFailed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                finishedGames.fetch_add(1, std::memory_order_relaxed);
+                generatedSamples.fetch_add(game.samples.size(), std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // 主线程定期报告进度，直到所有工作线程退出
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    std::atomic<bool> done{ false };
+    std::thread reporter([&] {
+        Clock::time_point lastReport = Clock::now();
+        while (!done.load(std::memory_order_relaxed))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (Clock::now() - lastReport < std::chrono::seconds(10)) continue;
+            lastReport = Clock::now();
+            double sec = std::chrono::duration<double>(lastReport - start).count();
+            uint64_t samples = generatedSamples.load();
+            std::fprintf(stderr, "games %llu  samples %llu  %.0f samples/s\n",
+                         static_cast<unsigned long long>(finishedGames.load()),
+                         static_cast<unsigned long long>(samples), samples / sec);
+        }
+    });
+    pool.Wait();
+    done = true;
+    reporter.join();
+    writer.Close();
+
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t samples = writer.SamplesWritten();
+    std::fprintf(stderr, "finished: games %llu  samples %llu  %.1f s  %.0f samples/s%s\n",
+                 static_cast<unsigned long long>(finishedGames.load()),
+                 static_cast<unsigned long long>(samples), sec, sec > 0 ? samples / sec : 0.0,
+                 g_interrupted ? "  (interrupted)" : "");
+    if (writeFailed)
+    {
+        std::cerr << "error: failed writing shard " << outPrefix << "\n";
+        return 1;
+    }
+    return 0;
+}
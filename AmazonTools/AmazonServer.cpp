@@ -0,0 +1,469 @@
+﻿// AmazonServer.cpp : 常驻分析服务（Linux）
+// 监听 Unix 域套接字或本机 TCP，每个连接为一个会话，按行请求 / 应答；
+// 所有会话的请求进入同一有界队列，由固定数量的工作线程处理，工作线程的 Engine 共享一张大置换表，
+// 因此重复或相邻的查询可以直接利用之前的搜索结果。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonServer.cpp -o AmazonServer
+//
+// 用法：AmazonServer [--listen unix:<path> | tcp:<port>] [--workers n] [--hash mb] [--numa] [--no-hugepages] [--queue n]
+//                    [--movetime ms] [--max-movetime ms] [--eval file] [--net file]
+//   --listen        监听地址（默认 unix:/tmp/amazon-analysis.sock）
+//   --workers       工作线程数（默认硬件线程数）
+//   --hash          共享置换表大小（默认 256）
+//   --numa          置换表页面在各 NUMA 节点间交错分布（多路服务器）
+//   --no-hugepages  置换表不请求透明大页（默认请求，见 AmazonTableMemory.h）
+//   --queue         排队请求上限，超出时拒绝（默认 1024）
+//   --movetime      请求未给出任何限制时的时间上限（默认 1000）
+//   --max-movetime  单个请求的时间上限（默认 60000，0 = 不限）
+//
+// 会话协议（走法与局面写法同 AmazonProtocol.h）：
+//   analyse <id> [depth d] [nodes n] [movetime ms] position startpos [w|b] [moves <m> ...]
+//       -> result <id> move <m|none> score s depth d nodes n time ms queue ms [stopped]
+//       -> error <id> <原因>（格式错误、队列已满）
+//   cancel <id>  排队中的请求直接移除并应答 "cancelled <id>"；已在搜索的请求立即停止，随后照常输出 result（带 stopped）
+//   metrics      -> metrics sessions .. queued .. running .. completed .. cancelled .. rejected ..
+//                   latency_p50 .. latency_p90 .. latency_p99 .. queue_p50 .. queue_p99 ..（毫秒）
+//   ping         -> pong
+//   quit         关闭会话（未完成的请求被取消）
+// id 由客户端选定，在会话内唯一即可；多个请求可以不等应答连续发送，应答顺序按完成先后。
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include "AmazonLineIO.h"
+#include "AmazonProtocol.h"
+#include "AmazonSearch.h"
+#include "AmazonSocket.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    volatile std::sig_atomic_t g_interrupted = 0;
+
+    void OnInterrupt(int)
+    {
+        g_interrupted = 1;
+    }
+
+    double MillisecondsBetween(Clock::time_point a, Clock::time_point b)
+    {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+
+    // 对数分桶直方图（每倍程 4 桶，微秒），内存固定，分位数取桶上界
+    class LatencyHistogram
+    {
+    public:
+        void Add(double ms)
+        {
+            uint64_t us = static_cast<uint64_t>(std::max(1.0, ms * 1000.0));
+            int octave = 63 - __builtin_clzll(us);
+            int sub = octave >= 2 ? static_cast<int>((us >> (octave - 2)) & 3) : 0;
+            ++buckets[std::min(BUCKETS - 1, octave * 4 + sub)];
+            ++count;
+        }
+
+        double Percentile(double p) const
+        {
+            if (count == 0) return 0.0;
+            uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * count)));
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; ++i)
+            {
+                seen += buckets[i];
+                if (seen >= target)
+                {
+                    int octave = i / 4, sub = i % 4;
+                    double upper = octave >= 2 ? static_cast<double>((4 + sub + 1) << (octave - 2)) : static_cast<double>(2 << octave);
+                    return upper / 1000.0;
+                }
+            }
+            return 0.0;
+        }
+
+    private:
+        static constexpr int BUCKETS = 160;
+        std::array<uint64_t, BUCKETS> buckets{};
+        uint64_t count = 0;
+    };
+
+    class Session
+    {
+    public:
+        explicit Session(int fd) : fd(fd) { channel.Attach(fd, fd); }
+
+        // 工作线程与会话线程都会写，逐行串行化；连接已断开时丢弃
+        void Send(const std::string& line)
+        {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            if (!closed) closed = !channel.WriteLine(line);
+        }
+
+        bool ReadLine(std::string& line) { return channel.ReadLine(line, -1) == LineChannel::ReadOk; }
+
+        // 使阻塞中的 ReadLine 返回（服务关闭时）
+        void Shutdown() { shutdown(fd, SHUT_RDWR); }
+
+        void MarkClosed()
+        {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            closed = true;
+        }
+
+    private:
+        int fd;
+        LineChannel channel;
+        std::mutex writeMutex;
+        bool closed = false;
+    };
+
+    struct Request
+    {
+        std::shared_ptr<Session> session;
+        std::string id;
+        Position position;
+        SearchLimits limits;
+        Clock::time_point received;
+        std::atomic<bool> cancelled{ false };
+    };
+
+    struct ServerConfig
+    {
+        size_t workers = 1;
+        size_t hashMb = 256;
+        TableMemoryOptions memory;
+        size_t queueLimit = 1024;
+        int64_t defaultMoveTimeMs = 1000;
+        int64_t maxMoveTimeMs = 60000;
+        std::shared_ptr<const EvalParams> evalParams;
+        std::shared_ptr<const Network> network;
+    };
+
+    class AnalysisServer
+    {
+    public:
+        explicit AnalysisServer(const ServerConfig& config)
+            : config(config), table(std::make_shared<TranspositionTable>(config.hashMb, config.memory)), running(config.workers)
+        {
+            for (size_t i = 0; i < config.workers; ++i)
+            {
+                engines.emplace_back(new Engine(table));
+                engines.back()->SetEvalParams(config.evalParams);
+                engines.back()->SetNetwork(config.network);
+            }
+            for (size_t i = 0; i < config.workers; ++i) workers.emplace_back([this, i] { WorkerLoop(i); });
+        }
+
+        ~AnalysisServer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                for (auto& r : queue) r->cancelled = true;
+                for (auto& r : running) if (r) r->cancelled = true;
+            }
+            workCv.notify_all();
+            for (auto& t : workers) t.join();
+        }
+
+        // 在启动会话线程之前登记，保证 ShutdownSessions 能看到所有会话
+        void Register(const std::shared_ptr<Session>& session)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sessions.push_back(session);
+        }
+
+        // 一个连接的完整生命周期（在会话线程中运行）
+        void Serve(std::shared_ptr<Session> session)
+        {
+            std::string line;
+            while (session->ReadLine(line))
+            {
+                std::vector<std::string> t = SplitTokens(line);
+                if (t.empty()) continue;
+                if (t[0] == "quit") break;
+                if (t[0] == "ping") session->Send("pong");
+                else if (t[0] == "analyse") Analyse(session, t);
+                else if (t[0] == "cancel" && t.size() == 2) Cancel(session, t[1]);
+                else if (t[0] == "metrics") session->Send(Metrics());
+                else session->Send("error - unknown command " + t[0]);
+            }
+            session->MarkClosed();
+            CancelSession(session);
+            std::lock_guard<std::mutex> lock(mutex);
+            sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+            if (sessions.empty()) sessionsCv.notify_all();
+        }
+
+        // 关闭所有连接并等待会话线程结束
+        void ShutdownSessions()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (auto& s : sessions) s->Shutdown();
+            sessionsCv.wait(lock, [this] { return sessions.empty(); });
+        }
+
+    private:
+        void Analyse(const std::shared_ptr<Session>& session, const std::vector<std::string>& t)
+        {
+            if (t.size() < 2)
+            {
+                session->Send("error - analyse needs an id");
+                return;
+            }
+            std::shared_ptr<Request> req = std::make_shared<Request>();
+            req->session = session;
+            req->id = t[1];
+            req->received = Clock::now();
+            req->limits.maxDepth = MAX_PLY;
+            req->limits.cancel = &req->cancelled;
+            bool bounded = false;
+            size_t i = 2;
+            for (; i < t.size() && t[i] != "position"; ++i)
+            {
+                bool hasValue = i + 1 < t.size();
+                if (t[i] == "depth" && hasValue) { req->limits.maxDepth = std::max(1, std::atoi(t[++i].c_str())); bounded = true; }
+                else if (t[i] == "nodes" && hasValue) { req->limits.maxNodes = std::strtoull(t[++i].c_str(), nullptr, 10); bounded = true; }
+                else if (t[i] == "movetime" && hasValue) { req->limits.maxTimeMs = std::atoll(t[++i].c_str()); bounded = true; }
+                else
+                {
+                    session->Send("error " + req->id + " bad argument " + t[i]);
+                    return;
+                }
+            }
+            std::string error;
+            if (i >= t.size() || !ParsePosition(t, i + 1, req->position, error))
+            {
+                session->Send("error " + req->id + " " + (error.empty() ? "missing position" : error));
+                return;
+            }
+            if (!bounded) req->limits.maxTimeMs = config.defaultMoveTimeMs;
+            if (config.maxMoveTimeMs > 0)
+            {
+                req->limits.maxTimeMs = req->limits.maxTimeMs > 0
+                    ? std::min(req->limits.maxTimeMs, config.maxMoveTimeMs) : config.maxMoveTimeMs;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (queue.size() >= config.queueLimit)
+                {
+                    ++rejected;
+                }
+                else
+                {
+                    queue.push_back(req);
+                    req.reset();
+                }
+            }
+            if (req)
+            {
+                session->Send("error " + req->id + " busy");
+                return;
+            }
+            workCv.notify_one();
+        }
+
+        void Cancel(const std::shared_ptr<Session>& session, const std::string& id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (auto it = queue.begin(); it != queue.end(); ++it)
+            {
+                if ((*it)->session == session && (*it)->id == id)
+                {
+                    queue.erase(it);
+                    ++cancelled;
+                    lock.unlock();
+                    session->Send("cancelled " + id);
+                    return;
+                }
+            }
+            for (auto& r : running)
+            {
+                if (r && r->session == session && r->id == id)
+                {
+                    r->cancelled = true;
+                    return;
+                }
+            }
+            lock.unlock();
+            session->Send("error " + id + " unknown request");
+        }
+
+        void CancelSession(const std::shared_ptr<Session>& session)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t before = queue.size();
+            queue.erase(std::remove_if(queue.begin(), queue.end(),
+                [&](const std::shared_ptr<Request>& r) { return r->session == session; }), queue.end());
+            cancelled += before - queue.size();
+            for (auto& r : running)
+                if (r && r->session == session) r->cancelled = true;
+        }
+
+        void WorkerLoop(size_t index)
+        {
+            Engine& engine = *engines[index];
+            for (;;)
+            {
+                std::shared_ptr<Request> req;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    workCv.wait(lock, [this] { return stopping || !queue.empty(); });
+                    if (stopping) return;
+                    req = queue.front();
+                    queue.pop_front();
+                    running[index] = req;
+                }
+
+                Clock::time_point start = Clock::now();
+                SearchResult r = engine.Search(req->position, req->limits);
+                Clock::time_point end = Clock::now();
+                bool stopped = req->cancelled.load();
+
+                char buf[160];
+                std::snprintf(buf, sizeof(buf), " score %d depth %d nodes %llu time %.1f queue %.1f%s",
+                              r.score, r.depth, static_cast<unsigned long long>(r.nodes),
+                              r.timeMs, MillisecondsBetween(req->received, start), stopped ? " stopped" : "");
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    running[index].reset();
+                    ++completed;
+                    queueLatency.Add(MillisecondsBetween(req->received, start));
+                    totalLatency.Add(MillisecondsBetween(req->received, end));
+                }
+                req->session->Send("result " + req->id + " move "
+                                   + (r.hasMove ? MoveToToken(r.bestMove) : std::string("none")) + buf);
+            }
+        }
+
+        std::string Metrics()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t busy = 0;
+            for (auto& r : running) if (r) ++busy;
+            char buf[320];
+            std::snprintf(buf, sizeof(buf),
+                          "metrics sessions %zu queued %zu running %zu completed %llu cancelled %llu rejected %llu"
+                          " latency_p50 %.2f latency_p90 %.2f latency_p99 %.2f queue_p50 %.2f queue_p99 %.2f",
+                          sessions.size(), queue.size(), busy,
+                          static_cast<unsigned long long>(completed), static_cast<unsigned long long>(cancelled),
+                          static_cast<unsigned long long>(rejected),
+                          totalLatency.Percentile(0.5), totalLatency.Percentile(0.9), totalLatency.Percentile(0.99),
+                          queueLatency.Percentile(0.5), queueLatency.Percentile(0.99));
+            return buf;
+        }
+
+        ServerConfig config;
+        std::shared_ptr<TranspositionTable> table;
+        std::vector<std::unique_ptr<Engine>> engines;
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable workCv;
+        std::condition_variable sessionsCv;
+        std::deque<std::shared_ptr<Request>> queue;
+        std::vector<std::shared_ptr<Request>> running; // 按工作线程编号
+        std::vector<std::shared_ptr<Session>> sessions;
+        bool stopping = false;
+        uint64_t completed = 0;
+        uint64_t cancelled = 0;
+        uint64_t rejected = 0;
+        LatencyHistogram queueLatency;
+        LatencyHistogram totalLatency;
+    };
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonServer [--listen unix:path|tcp:port] [--workers n] [--hash mb] [--numa] [--no-hugepages] [--queue n]\n"
+                     "                    [--movetime ms] [--max-movetime ms] [--eval file] [--net file]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ServerConfig config;
+    config.workers = std::max(1u, std::thread::hardware_concurrency());
+    std::string address = "unix:/tmp/amazon-analysis.sock";
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--listen") address = next();
+        else if (arg == "--workers") config.workers = std::max<size_t>(1, std::strtoul(next(), nullptr, 10));
+        else if (arg == "--hash") config.hashMb = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--numa") config.memory.interleaveNodes = true;
+        else if (arg == "--no-hugepages") config.memory.hugePages = false;
+        else if (arg == "--queue") config.queueLimit = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--movetime") config.defaultMoveTimeMs = std::atoll(next());
+        else if (arg == "--max-movetime") config.maxMoveTimeMs = std::atoll(next());
+        else if (arg == "--eval")
+        {
+            if (!(config.evalParams = LoadEvalParams(next())))
+            {
+                std::cerr << "cannot load weights " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--net")
+        {
+            std::shared_ptr<Network> net = std::make_shared<Network>();
+            if (!net->Load(next()))
+            {
+                std::cerr << "cannot load network " << argv[i] << "\n";
+                return 1;
+            }
+            config.network = net;
+        }
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else { Usage(); return 2; }
+    }
+
+    int listenFd = ListenOn(address);
+    if (listenFd < 0)
+    {
+        std::cerr << "cannot listen on " << address << "\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, OnInterrupt);
+    std::signal(SIGTERM, OnInterrupt);
+    std::cerr << "listening on " << address << " with " << config.workers << " workers\n";
+
+    AnalysisServer server(config);
+    // poll 被信号打断时返回 EINTR，借此检查退出标志
+    while (!g_interrupted)
+    {
+        pollfd p = { listenFd, POLLIN, 0 };
+        if (poll(&p, 1, -1) <= 0) continue;
+        int fd = AcceptOn(listenFd);
+        if (fd < 0) continue;
+        std::shared_ptr<Session> session = std::make_shared<Session>(fd);
+        server.Register(session);
+        std::thread([&server, session] { server.Serve(session); }).detach();
+    }
+    close(listenFd);
+    if (address.compare(0, 5, "unix:") == 0) unlink(address.c_str() + 5);
+    server.ShutdownSessions();
+    return 0;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 本机套接字（POSIX）：Unix 域套接字或仅监听 127.0.0.1 的 TCP。
+// 地址写法："unix:<path>" 或 "tcp:<port>"；失败时返回 -1。
+
+namespace AmazonChess
+{
+    // 请求 / 应答都是短行，关闭 Nagle 以免每条应答多等一个 RTT（Unix 域套接字上忽略失败）
+    inline void SetNoDelay(int fd)
+    {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    inline bool ParseUnixAddress(const std::string& address, sockaddr_un& out)
+    {
+        if (address.compare(0, 5, "unix:") != 0) return false;
+        std::string path = address.substr(5);
+        if (path.empty() || path.size() >= sizeof(out.sun_path)) return false;
+        std::memset(&out, 0, sizeof(out));
+        out.sun_family = AF_UNIX;
+        std::memcpy(out.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    inline bool ParseTcpAddress(const std::string& address, sockaddr_in& out)
+    {
+        if (address.compare(0, 4, "tcp:") != 0) return false;
+        int port = std::atoi(address.c_str() + 4);
+        if (port <= 0 || port > 65535) return false;
+        std::memset(&out, 0, sizeof(out));
+        out.sin_family = AF_INET;
+        out.sin_port = htons(static_cast<uint16_t>(port));
+        out.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return true;
+    }
+
+    // 开始监听；Unix 域套接字会先删除残留的同名文件
+    inline int ListenOn(const std::string& address, int backlog = 64)
+    {
+        sockaddr_un un;
+        sockaddr_in in;
+        int fd = -1;
+        if (ParseUnixAddress(address, un))
+        {
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) return -1;
+            unlink(un.sun_path);
+            if (bind(fd, reinterpret_cast<sockaddr*>(&un), sizeof(un)) != 0) { close(fd); return -1; }
+        }
+        else if (ParseTcpAddress(address, in))
+        {
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) return -1;
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(fd, reinterpret_cast<sockaddr*>(&in), sizeof(in)) != 0) { close(fd); return -1; }
+        }
+        else return -1;
+        if (listen(fd, backlog) != 0) { close(fd); return -1; }
+        return fd;
+    }
+
+    inline int ConnectTo(const std::string& address)
+    {
+        sockaddr_un un;
+        sockaddr_in in;
+        int fd = -1;
+        if (ParseUnixAddress(address, un))
+        {
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&un), sizeof(un)) != 0) { close(fd); fd = -1; }
+        }
+        else if (ParseTcpAddress(address, in))
+        {
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&in), sizeof(in)) != 0) { close(fd); fd = -1; }
+        }
+        if (fd >= 0) SetNoDelay(fd);
+        return fd;
+    }
+
+    inline int AcceptOn(int listenFd)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) SetNoDelay(fd);
+        return fd;
+    }
+} // namespace AmazonChess
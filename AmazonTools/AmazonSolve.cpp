@@ -0,0 +1,260 @@
+﻿// AmazonSolve.cpp : 中后盘局面胜负求解工具
+// 对棋谱中的局面（或直接给出的局面）运行 df-pn 求解器（AmazonDfpn.h），输出走子方必胜 / 必败 / 未解出及必胜的一手。
+// 每个棋谱作为一个任务交给工作线程，线程各自持有求解器；--all 时同一局内从后往前求解，
+// 较早局面的搜索可直接命中已证明的后续局面。结果按输入顺序逐行输出 JSONL，汇总写到 stderr。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonSolve.cpp -o AmazonSolve
+//
+// 用法：AmazonSolve [选项] [game.acp|game.acj ...]
+//   --list <file>        每行一个棋谱路径（'#' 开头为注释）
+//   --fen <board> <side> 直接给出局面（记号见 AmazonNotation.h，可重复）
+//   --ply <n>            求解第 n 手之前的局面（默认取箭数首次达到 --min-arrows 的局面）
+//   --min-arrows <a>     默认 34
+//   --all                求解从该局面起直到终局的每个局面，并标出把必胜局面走成必败的一手（"lost":true）
+//   --nodes <n>          每个局面的节点上限（默认 1000000，0 = 不限）
+//   --movetime <ms>      每个局面的时间上限（默认 0 = 不限）
+//   --hash <mb>          每个工作线程的证明数表大小（默认 64）
+//   --threads <n>        工作线程数（默认硬件线程数）
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AmazonDfpn.h"
+#include "AmazonGameSource.h"
+#include "AmazonJson.h"
+#include "AmazonNotation.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        std::string source;   // 棋谱路径，直接给出的局面为 "FEN <board> <side>"
+        bool direct = false;
+        Position position;
+    };
+
+    struct Settings
+    {
+        int ply = -1;         // -1 表示按箭数选取
+        int minArrows = 34;
+        bool all = false;
+        SolverLimits limits;
+    };
+
+    struct Totals
+    {
+        std::atomic<uint64_t> positions{ 0 };
+        std::atomic<uint64_t> wins{ 0 };
+        std::atomic<uint64_t> losses{ 0 };
+        std::atomic<uint64_t> nodes{ 0 };
+        std::atomic<uint64_t> lostWins{ 0 };
+    };
+
+    struct Solved
+    {
+        int ply;
+        Position position;
+        bool hasPlayed;
+        Move played;
+        SolverOutcome outcome;
+    };
+
+    std::string FormatLine(const std::string& source, const Solved& s, bool lostWin)
+    {
+        std::ostringstream ss;
+        ss << "{\"source\":\"" << JsonEscape(source) << "\""
+           << ",\"ply\":" << s.ply
+           << ",\"side\":\"" << (s.position.sideToMove == Player::White ? "W" : "B") << "\""
+           << ",\"arrows\":" << PopCount(s.position.arrows)
+           << ",\"result\":\"" << SolveResultName(s.outcome.result) << "\"";
+        if (s.outcome.hasMove) ss << ",\"move\":\"" << MoveToString(s.outcome.bestMove) << "\"";
+        else ss << ",\"move\":null";
+        if (s.hasPlayed) ss << ",\"played\":\"" << MoveToString(s.played) << "\"";
+        if (lostWin) ss << ",\"lost\":true";
+        char timeBuf[32];
+        std::snprintf(timeBuf, sizeof(timeBuf), "%.3f", s.outcome.timeMs);
+        ss << ",\"pn\":" << s.outcome.phi
+           << ",\"dn\":" << s.outcome.delta
+           << ",\"nodes\":" << s.outcome.nodes
+           << ",\"timeMs\":" << timeBuf << "}";
+        return ss.str();
+    }
+
+    // 重放棋谱，取出要求解的局面（按手数升序）；读取失败或没有符合条件的局面时返回空
+    std::vector<Solved> SelectPositions(const Task& task, const Settings& settings)
+    {
+        std::vector<Solved> out;
+        if (task.direct)
+        {
+            out.push_back({ 0, task.position, false, MoveOf(0, 0, 0), SolverOutcome() });
+            return out;
+        }
+        GameRecord record;
+        if (!LoadGameFile(task.source, record))
+        {
+            std::fprintf(stderr, "warning: cannot read record %s\n", task.source.c_str());
+            return out;
+        }
+        Position pos = record.start;
+        int last = static_cast<int>(record.moves.size());
+        for (int i = 0; i <= last; ++i)
+        {
+            if (i < last) pos.SetSideToMove(record.moves[i].player);
+            // 第一个局面按 --ply / --min-arrows 选取，--all 时其后每个局面都要
+            bool selected = !out.empty() ? settings.all
+                : settings.ply >= 0 ? i == settings.ply : PopCount(pos.arrows) >= settings.minArrows;
+            if (selected) out.push_back({ i, pos, i < last, i < last ? record.moves[i].move : MoveOf(0, 0, 0), SolverOutcome() });
+            else if (!out.empty()) break;
+            if (i == last) break;
+            if (!ApplyRecordedMove(pos, record.moves[i]))
+            {
+                std::fprintf(stderr, "warning: illegal move at ply %d in %s\n", i, task.source.c_str());
+                break;
+            }
+        }
+        return out;
+    }
+
+    std::string SolveTask(const Task& task, const Settings& settings, ProofNumberSolver& solver, Totals& totals)
+    {
+        std::vector<Solved> positions = SelectPositions(task, settings);
+        solver.Clear();
+        // 从后往前：后续局面的证明留在表中，较早局面的搜索可直接命中
+        for (size_t i = positions.size(); i-- > 0;)
+        {
+            positions[i].outcome = solver.Solve(positions[i].position, settings.limits);
+            const SolverOutcome& o = positions[i].outcome;
+            ++totals.positions;
+            totals.nodes += o.nodes;
+            if (o.result == SolveResult::Win) ++totals.wins;
+            else if (o.result == SolveResult::Loss) ++totals.losses;
+        }
+        std::string lines;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            // 走子方必胜，而实际走出这一手后对方必胜（--all 时下一个局面即走完这一手之后）
+            bool lostWin = i + 1 < positions.size()
+                && positions[i].outcome.result == SolveResult::Win
+                && positions[i + 1].outcome.result == SolveResult::Win
+                && positions[i + 1].ply == positions[i].ply + 1
+                && positions[i + 1].position.sideToMove != positions[i].position.sideToMove;
+            if (lostWin) ++totals.lostWins;
+            lines += FormatLine(task.source, positions[i], lostWin);
+            lines += '\n';
+        }
+        return lines;
+    }
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonSolve [--list file] [--fen board side ...] [--ply n] [--min-arrows a] [--all]\n"
+                     "                   [--nodes n] [--movetime ms] [--hash mb] [--threads n] [game.acp ...]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    settings.limits.maxNodes = 1000000;
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    size_t hashMb = 64;
+    std::vector<Task> tasks;
+    std::vector<std::string> lists;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--list") lists.push_back(next());
+        else if (arg == "--fen")
+        {
+            Task task;
+            std::string board = next();
+            std::string side = next();
+            std::string error;
+            if (!ParseFen(board, side, task.position, error))
+            {
+                std::cerr << "bad position " << board << " " << side << " (" << error << ")\n";
+                return 2;
+            }
+            task.source = "FEN " + board + " " + side;
+            task.direct = true;
+            tasks.push_back(task);
+        }
+        else if (arg == "--ply") settings.ply = std::atoi(next());
+        else if (arg == "--min-arrows") settings.minArrows = std::atoi(next());
+        else if (arg == "--all") settings.all = true;
+        else if (arg == "--nodes") settings.limits.maxNodes = std::strtoull(next(), nullptr, 10);
+        else if (arg == "--movetime") settings.limits.maxTimeMs = std::atoll(next());
+        else if (arg == "--hash") hashMb = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--threads") threads = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else if (!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+        else
+        {
+            Task task;
+            task.source = arg;
+            tasks.push_back(task);
+        }
+    }
+    for (const auto& listPath : lists)
+    {
+        std::vector<std::string> paths;
+        if (!ReadPathList(listPath, paths))
+        {
+            std::cerr << "cannot open list " << listPath << "\n";
+            return 1;
+        }
+        for (const std::string& path : paths)
+        {
+            Task task;
+            task.source = path;
+            tasks.push_back(task);
+        }
+    }
+    if (tasks.empty()) { Usage(); return 2; }
+
+    Clock::time_point start = Clock::now();
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<ProofNumberSolver>> solvers;
+    for (size_t i = 0; i < pool.Size(); ++i) solvers.emplace_back(new ProofNumberSolver(hashMb));
+
+    Totals totals;
+    std::vector<std::string> results(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        pool.Submit([&, i](size_t worker) {
+            results[i] = SolveTask(tasks[i], settings, *solvers[worker], totals);
+        });
+    }
+    pool.Wait();
+    for (const std::string& r : results) std::fwrite(r.data(), 1, r.size(), stdout);
+    std::fflush(stdout);
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t positions = totals.positions;
+    uint64_t solved = totals.wins + totals.losses;
+    std::fprintf(stderr, "positions %llu  solved %llu (%.1f%%: win %llu, loss %llu)  lost wins %llu\n",
+                 static_cast<unsigned long long>(positions), static_cast<unsigned long long>(solved),
+                 positions ? 100.0 * solved / positions : 0.0,
+                 static_cast<unsigned long long>(totals.wins.load()), static_cast<unsigned long long>(totals.losses.load()),
+                 static_cast<unsigned long long>(totals.lostWins.load()));
+    std::fprintf(stderr, "nodes %llu  %.2f s  %.0f nodes/s\n", static_cast<unsigned long long>(totals.nodes.load()),
+                 seconds, seconds > 0 ? totals.nodes / seconds : 0.0);
+    return 0;
+}
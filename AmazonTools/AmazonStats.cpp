@@ -0,0 +1,318 @@
+﻿// AmazonStats.cpp : 对局库统计报表工具（Linux）
+// 流式读取大量棋谱（.acp 文本或 .acj 日志），在位棋盘上重放并汇总：
+//   - 双方胜率与按第一手分组的胜率；
+//   - 对局长度（平均、分布）；
+//   - 按手数的开放度 / 后式领地曲线（双方平均值）；
+//   - 可选：胜方每一手与 AI 在同一局面下的选择是否一致。
+// 每个工作线程持有自己的统计累加器（固定大小，与对局数无关），全部读完后再逐个合并，线程间不共享计数；
+// 路径按小批从参数 / 列表文件中取出，不预先读入整个列表，内存占用与对局库大小无关。
+//
+// 构建（Linux）：g++ -std=c++14 -O2 -pthread -I"../AmazonChess!" AmazonStats.cpp -o AmazonStats
+//
+// 用法：AmazonStats [选项] [game.acp|game.acj ...]
+//   --list <file>      每行一个棋谱路径（'#' 开头为注释），可与命令行路径混用
+//   --threads <n>      工作线程数（默认硬件线程数）
+//   --ai-depth <d>     对胜方的每一手做 d 层搜索并比较选择（默认 0 = 不比较；耗时远大于重放）
+//   --hash <mb>        --ai-depth 时每个线程的置换表大小（默认 4）
+//   --top <n>          第一手表格显示的行数（默认 10）
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AmazonEvalParams.h"
+#include "AmazonGameSource.h"
+#include "AmazonSearch.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 一局最多走 SQUARE_COUNT 手（每手射出一支箭），曲线按 0..SQUARE_COUNT 手索引
+    static constexpr int MAX_STATS_PLIES = SQUARE_COUNT;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct FirstMoveStats
+    {
+        uint64_t games = 0;
+        uint64_t wins[2] = { 0, 0 }; // 白胜 / 黑胜
+    };
+
+    struct PlyStats
+    {
+        uint64_t positions = 0;
+        uint64_t mobility[2] = { 0, 0 };
+        uint64_t territory[2] = { 0, 0 };
+    };
+
+    // 单线程的统计累加器；Merge 把另一个累加器加到本累加器上
+    struct StatsReducer
+    {
+        uint64_t games = 0;
+        uint64_t unreadable = 0;
+        uint64_t illegal = 0;     // 重放中途遇到非法着法（统计截至该手）
+        uint64_t customStart = 0; // 不从初始局面开始（不计入第一手表格）
+        uint64_t wins[3] = { 0, 0, 0 }; // 未结束 / 白胜 / 黑胜
+        uint64_t totalPlies = 0;
+        std::array<uint64_t, MAX_STATS_PLIES + 1> lengths{};
+        std::array<PlyStats, MAX_STATS_PLIES + 1> byPly{};
+        std::unordered_map<uint32_t, FirstMoveStats> firstMoves; // Move::Code() -> 统计；键数不超过第一手的合法着法数
+        uint64_t winnerMoves = 0;  // 参与比较的胜方着法
+        uint64_t aiMatches = 0;    // 其中与 AI 选择相同的
+        uint64_t nodes = 0;
+
+        void AddGame(const GameRecord& record, Engine* engine, const SearchLimits& limits)
+        {
+            ++games;
+            Position pos = record.start;
+            if (!record.moves.empty()) pos.SetSideToMove(record.moves[0].player);
+            bool custom = HasCustomStart(record);
+            if (custom) ++customStart;
+
+            // 先在位棋盘上重放一遍得到胜者与长度，同时记录曲线
+            std::vector<Position> line; // 仅 --ai-depth 时保留每手之前的局面
+            if (engine) line.reserve(record.moves.size());
+            int plies = 0;
+            AddPosition(pos, 0);
+            for (const RecordedMove& rm : record.moves)
+            {
+                if (engine)
+                {
+                    line.push_back(pos);
+                    line.back().SetSideToMove(rm.player);
+                }
+                if (!ApplyRecordedMove(pos, rm))
+                {
+                    ++illegal;
+                    if (engine) line.pop_back();
+                    break;
+                }
+                ++plies;
+                AddPosition(pos, plies);
+            }
+            Player winner = WinnerOf(pos);
+            ++wins[winner == Player::White ? 1 : winner == Player::Black ? 2 : 0];
+            totalPlies += plies;
+            ++lengths[std::min(plies, MAX_STATS_PLIES)];
+
+            if (!custom && plies > 0)
+            {
+                FirstMoveStats& f = firstMoves[record.moves[0].move.Code()];
+                ++f.games;
+                if (winner != Player::None) ++f.wins[winner == Player::White ? 0 : 1];
+            }
+
+            if (!engine || winner == Player::None) return;
+            engine->NewGame();
+            for (size_t i = 0; i < line.size(); ++i)
+            {
+                if (record.moves[i].player != winner) continue;
+                SearchResult r = engine->Search(line[i], limits);
+                nodes += r.nodes;
+                ++winnerMoves;
+                if (r.hasMove && r.bestMove == record.moves[i].move) ++aiMatches;
+            }
+        }
+
+        void AddPosition(const Position& pos, int ply)
+        {
+            PlyStats& s = byPly[std::min(ply, MAX_STATS_PLIES)];
+            ++s.positions;
+            int mine, theirs;
+            QueenTerritory(pos, Player::White, mine, theirs);
+            s.territory[0] += mine;
+            s.territory[1] += theirs;
+            s.mobility[0] += Mobility(pos, Player::White);
+            s.mobility[1] += Mobility(pos, Player::Black);
+        }
+
+        void Merge(const StatsReducer& o)
+        {
+            games += o.games;
+            unreadable += o.unreadable;
+            illegal += o.illegal;
+            customStart += o.customStart;
+            for (int i = 0; i < 3; ++i) wins[i] += o.wins[i];
+            totalPlies += o.totalPlies;
+            for (int i = 0; i <= MAX_STATS_PLIES; ++i)
+            {
+                lengths[i] += o.lengths[i];
+                byPly[i].positions += o.byPly[i].positions;
+                for (int s = 0; s < 2; ++s)
+                {
+                    byPly[i].mobility[s] += o.byPly[i].mobility[s];
+                    byPly[i].territory[s] += o.byPly[i].territory[s];
+                }
+            }
+            for (const auto& kv : o.firstMoves)
+            {
+                FirstMoveStats& f = firstMoves[kv.first];
+                f.games += kv.second.games;
+                f.wins[0] += kv.second.wins[0];
+                f.wins[1] += kv.second.wins[1];
+            }
+            winnerMoves += o.winnerMoves;
+            aiMatches += o.aiMatches;
+            nodes += o.nodes;
+        }
+    };
+
+    double Percent(uint64_t part, uint64_t whole)
+    {
+        return whole ? 100.0 * part / whole : 0.0;
+    }
+
+    void PrintReport(const StatsReducer& s, size_t top, int aiDepth)
+    {
+        uint64_t finished = s.wins[1] + s.wins[2];
+        std::printf("games %llu (unreadable %llu, illegal move %llu, custom start %llu)\n",
+                    static_cast<unsigned long long>(s.games), static_cast<unsigned long long>(s.unreadable),
+                    static_cast<unsigned long long>(s.illegal), static_cast<unsigned long long>(s.customStart));
+        std::printf("results: white %llu (%.1f%%), black %llu (%.1f%%), unfinished %llu\n",
+                    static_cast<unsigned long long>(s.wins[1]), Percent(s.wins[1], finished),
+                    static_cast<unsigned long long>(s.wins[2]), Percent(s.wins[2], finished),
+                    static_cast<unsigned long long>(s.wins[0]));
+
+        int minLen = -1, maxLen = 0, median = 0;
+        uint64_t seen = 0;
+        for (int i = 0; i <= MAX_STATS_PLIES; ++i)
+        {
+            if (!s.lengths[i]) continue;
+            if (minLen < 0) minLen = i;
+            maxLen = i;
+            if (seen < (s.games + 1) / 2 && seen + s.lengths[i] >= (s.games + 1) / 2) median = i;
+            seen += s.lengths[i];
+        }
+        std::printf("length: average %.2f plies, min %d, median %d, max %d\n",
+                    s.games ? static_cast<double>(s.totalPlies) / s.games : 0.0, std::max(minLen, 0), median, maxLen);
+
+        std::vector<std::pair<uint32_t, FirstMoveStats>> moves(s.firstMoves.begin(), s.firstMoves.end());
+        std::sort(moves.begin(), moves.end(), [](const std::pair<uint32_t, FirstMoveStats>& a, const std::pair<uint32_t, FirstMoveStats>& b) {
+            return a.second.games != b.second.games ? a.second.games > b.second.games : a.first < b.first;
+        });
+        std::printf("first moves (%zu distinct):\n", moves.size());
+        std::printf("  %-12s %10s %8s %8s\n", "move", "games", "white%", "black%");
+        for (size_t i = 0; i < moves.size() && i < top; ++i)
+        {
+            const FirstMoveStats& f = moves[i].second;
+            uint64_t decided = f.wins[0] + f.wins[1];
+            std::printf("  %-12s %10llu %7.1f%% %7.1f%%\n", MoveToString(Move::FromCode(moves[i].first)).c_str(),
+                        static_cast<unsigned long long>(f.games), Percent(f.wins[0], decided), Percent(f.wins[1], decided));
+        }
+
+        std::printf("by ply (averages over games still running at that ply):\n");
+        std::printf("  %4s %10s %9s %9s %9s %9s\n", "ply", "positions", "mob W", "mob B", "terr W", "terr B");
+        for (int i = 0; i <= MAX_STATS_PLIES; ++i)
+        {
+            const PlyStats& p = s.byPly[i];
+            if (!p.positions) continue;
+            double n = static_cast<double>(p.positions);
+            std::printf("  %4d %10llu %9.2f %9.2f %9.2f %9.2f\n", i, static_cast<unsigned long long>(p.positions),
+                        p.mobility[0] / n, p.mobility[1] / n, p.territory[0] / n, p.territory[1] / n);
+        }
+
+        if (aiDepth > 0)
+        {
+            std::printf("winner moves matching depth-%d search: %llu / %llu (%.1f%%), %llu nodes\n", aiDepth,
+                        static_cast<unsigned long long>(s.aiMatches), static_cast<unsigned long long>(s.winnerMoves),
+                        Percent(s.aiMatches, s.winnerMoves), static_cast<unsigned long long>(s.nodes));
+        }
+    }
+
+    void Usage()
+    {
+        std::fprintf(stderr, "usage: AmazonStats [--list file] [--threads n] [--ai-depth d] [--hash mb] [--top n] [game.acp|game.acj ...]\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    int aiDepth = 0;
+    size_t hashMb = 4;
+    size_t top = 10;
+    std::vector<std::string> paths, lists;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--list") && hasValue) lists.push_back(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue) threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--ai-depth") && hasValue) aiDepth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--hash") && hasValue) hashMb = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--top") && hasValue) top = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--help") || !std::strcmp(argv[i], "-h"))
+        {
+            Usage();
+            return 0;
+        }
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            Usage();
+            return 2;
+        }
+    }
+    if (paths.empty() && lists.empty())
+    {
+        Usage();
+        return 2;
+    }
+
+    SearchLimits limits;
+    limits.maxDepth = aiDepth;
+    GameSource source(std::move(paths), std::move(lists));
+    Clock::time_point t0 = Clock::now();
+    std::vector<StatsReducer> reducers;
+    {
+        WorkStealingPool pool(threads);
+        reducers.resize(pool.Size());
+        // 每个线程一个任务，循环取批直到输入耗尽；只写自己的累加器
+        for (size_t w = 0; w < pool.Size(); ++w)
+        {
+            pool.Submit([&](size_t worker) {
+                StatsReducer& stats = reducers[worker];
+                std::unique_ptr<Engine> engine;
+                if (aiDepth > 0) engine.reset(new Engine(hashMb));
+                std::vector<std::string> batch;
+                uint64_t first;
+                GameRecord record;
+                while (source.NextBatch(batch, first))
+                {
+                    for (const std::string& path : batch)
+                    {
+                        if (!LoadGameFile(path, record))
+                        {
+                            ++stats.unreadable;
+                            continue;
+                        }
+                        stats.AddGame(record, engine.get(), limits);
+                    }
+                }
+            });
+        }
+        pool.Wait();
+    }
+    StatsReducer total;
+    for (const StatsReducer& r : reducers) total.Merge(r);
+    double sec = SecondsSince(t0);
+
+    PrintReport(total, top, aiDepth);
+    std::printf("scanned %llu games, %llu positions in %.2f s (%.0f games/s, %zu threads)\n",
+                static_cast<unsigned long long>(total.games), static_cast<unsigned long long>(total.totalPlies + total.games),
+                sec, sec > 0 ? total.games / sec : 0.0, reducers.size());
+    return 0;
+}
@@ -0,0 +1,362 @@
+﻿// AmazonTune.cpp : 评估权重调优工具（Texel 方法）
+// 从 .acp 棋谱或自对弈分片（.bin）读入局面与终局胜负，计算评估特征（AmazonEvalParams.h），
+// 以结构数组（每个特征一条连续 float 数组）保存；最小化 sigmoid(K * 评估) 与胜负之间的均方误差，
+// 梯度在线程池上按数据块并行计算，块内为可向量化的连续循环。结果写为引擎启动时读取的权重文件。
+//
+// 构建（Linux）：g++ -std=c++14 -O3 -march=native -ffast-math -pthread -I"../AmazonChess!" AmazonTune.cpp -o AmazonTune
+// （-ffast-math 允许编译器向量化浮点归约与 exp）
+//
+// 用法：AmazonTune [选项] <game.acp | shard.bin> ...
+//   --list <file>        输入文件列表，每行一个路径，'#' 开头为注释
+//   --threads <n>        工作线程数（默认硬件线程数）
+//   --iterations <n>     梯度下降迭代次数（默认 1000）
+//   --lr <x>             Adam 学习率（默认 0.05）
+//   --k <x>              sigmoid 缩放系数（默认按初始权重自动拟合）
+//   --init <file>        初始权重文件（默认 mobility = 1）
+//   --skip-plies <n>     跳过每局前 n 手（开局局面，默认 0）
+//   --out <file>         输出权重文件（默认 AmazonEval.txt）
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AmazonEvalParams.h"
+#include "AmazonRecord.h"
+#include "AmazonShard.h"
+#include "AmazonThreadPool.h"
+
+using namespace AmazonChess;
+
+namespace
+{
+    // 结构数组：features[i][j] 为第 j 个局面的第 i 个特征，result[j] 为走子方最终胜负（1 / 0）
+    struct TuningSet
+    {
+        std::vector<float> features[EVAL_FEATURE_COUNT];
+        std::vector<float> result;
+
+        size_t Size() const { return result.size(); }
+
+        void Add(const Position& pos, bool sideToMoveWon)
+        {
+            EvalFeatures f = ComputeFeatures(pos);
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i) features[i].push_back(static_cast<float>(f[i]));
+            result.push_back(sideToMoveWon ? 1.0f : 0.0f);
+        }
+
+        void Append(const TuningSet& other)
+        {
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+                features[i].insert(features[i].end(), other.features[i].begin(), other.features[i].end());
+            result.insert(result.end(), other.result.begin(), other.result.end());
+        }
+    };
+
+    bool EndsWith(const std::string& s, const std::string& suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // 棋谱：只使用已分出胜负的对局，标注为终局胜负
+    bool LoadRecordPositions(const std::string& path, int skipPlies, TuningSet& out)
+    {
+        GameRecord record;
+        if (!LoadRecord(path, record)) return false;
+        std::vector<Position> positions;
+        Position pos = record.start;
+        for (size_t i = 0; i < record.moves.size(); ++i)
+        {
+            pos.SetSideToMove(record.moves[i].player);
+            if (static_cast<int>(i) >= skipPlies) positions.push_back(pos);
+            if (!ApplyRecordedMove(pos, record.moves[i])) return false;
+        }
+        Player winner = WinnerOf(pos);
+        if (winner == Player::None) return true;
+        for (const Position& p : positions) out.Add(p, p.sideToMove == winner);
+        return true;
+    }
+
+    bool LoadShardPositions(const std::string& path, int skipPlies, TuningSet& out)
+    {
+        ShardReader reader(path);
+        if (!reader.IsOpen()) return false;
+        TrainingSample s;
+        while (reader.Next(s))
+        {
+            if (s.ply >= skipPlies) out.Add(s.position, s.sideToMoveWon);
+        }
+        return true;
+    }
+
+    // 分块计算误差与梯度。s 为每块的临时缓冲（评估值，随后复用为残差项）
+    class Tuner
+    {
+    public:
+        Tuner(const TuningSet& data, WorkStealingPool& pool)
+            : data(data), pool(pool)
+        {
+            // 块不宜过大：块内以 float 累加，块间以 double 合并
+            size_t chunks = std::max<size_t>(1, pool.Size() * 4);
+            chunkSize = std::min<size_t>(65536, std::max<size_t>(4096, (data.Size() + chunks - 1) / chunks));
+            chunkCount = (data.Size() + chunkSize - 1) / chunkSize;
+            scratch.resize(pool.Size());
+            for (auto& v : scratch) v.resize(chunkSize);
+            partial.resize(chunkCount);
+        }
+
+        // 返回均方误差；gradient 非空时同时计算对各权重的梯度
+        double Compute(const double* weights, double k, double* gradient)
+        {
+            bool withGradient = gradient != nullptr;
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                pool.Submit([this, c, weights, k, withGradient](size_t worker) {
+                    ComputeChunk(c, worker, weights, k, withGradient);
+                });
+            }
+            pool.Wait();
+
+            double error = 0.0;
+            double grad[EVAL_FEATURE_COUNT] = {};
+            for (const Partial& p : partial)
+            {
+                error += p.error;
+                for (int i = 0; i < EVAL_FEATURE_COUNT; ++i) grad[i] += p.gradient[i];
+            }
+            double n = static_cast<double>(data.Size());
+            if (withGradient)
+                for (int i = 0; i < EVAL_FEATURE_COUNT; ++i) gradient[i] = grad[i] / n;
+            return error / n;
+        }
+
+    private:
+        struct Partial
+        {
+            double error = 0.0;
+            double gradient[EVAL_FEATURE_COUNT] = {};
+        };
+
+        void ComputeChunk(size_t c, size_t worker, const double* weights, double k, bool withGradient)
+        {
+            size_t begin = c * chunkSize;
+            size_t count = std::min(chunkSize, data.Size() - begin);
+            float* s = scratch[worker].data();
+            const float* r = data.result.data() + begin;
+
+            // 线性评估：逐特征累加，每个循环都是连续内存上的乘加
+            std::fill(s, s + count, 0.0f);
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+            {
+                float w = static_cast<float>(weights[i]);
+                const float* f = data.features[i].data() + begin;
+                for (size_t j = 0; j < count; ++j) s[j] += w * f[j];
+            }
+
+            // sigmoid 与误差；s 改写为 dE/d评估 的系数 2 * (p - r) * p * (1 - p) * K
+            float kf = static_cast<float>(k);
+            float error = 0.0f;
+            for (size_t j = 0; j < count; ++j)
+            {
+                float p = 1.0f / (1.0f + std::exp(-kf * s[j]));
+                float d = p - r[j];
+                error += d * d;
+                s[j] = 2.0f * d * p * (1.0f - p) * kf;
+            }
+
+            Partial& out = partial[c];
+            out.error = error;
+            if (!withGradient) return;
+            for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+            {
+                const float* f = data.features[i].data() + begin;
+                float g = 0.0f;
+                for (size_t j = 0; j < count; ++j) g += s[j] * f[j];
+                out.gradient[i] = g;
+            }
+        }
+
+        const TuningSet& data;
+        WorkStealingPool& pool;
+        size_t chunkSize = 0;
+        size_t chunkCount = 0;
+        std::vector<std::vector<float>> scratch; // 每个工作线程一块
+        std::vector<Partial> partial;            // 每个数据块一份，合并顺序固定，结果可复现
+    };
+
+    // 在对数尺度上粗扫再细化，求使误差最小的 K
+    double FitK(Tuner& tuner, const double* weights)
+    {
+        double best = 0.1;
+        double bestError = tuner.Compute(weights, best, nullptr);
+        double lo = 1e-4, hi = 10.0;
+        for (int round = 0; round < 3; ++round)
+        {
+            double step = std::pow(hi / lo, 1.0 / 20.0);
+            for (double k = lo; k <= hi * 1.0001; k *= step)
+            {
+                double e = tuner.Compute(weights, k, nullptr);
+                if (e < bestError)
+                {
+                    bestError = e;
+                    best = k;
+                }
+            }
+            lo = best / step;
+            hi = best * step;
+        }
+        return best;
+    }
+
+    void Usage()
+    {
+        std::cerr << "usage: AmazonTune [--list file] [--threads n] [--iterations n] [--lr x] [--k x]\n"
+                     "                  [--init file] [--skip-plies n] [--out file] <game.acp | shard.bin> ...\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads = WorkStealingPool::DefaultThreadCount();
+    int iterations = 1000;
+    double learningRate = 0.05;
+    double k = 0.0;
+    int skipPlies = 0;
+    std::string initPath;
+    std::string outPath = "AmazonEval.txt";
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { Usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (arg == "--list")
+        {
+            std::ifstream ifs(next());
+            if (!ifs.is_open())
+            {
+                std::cerr << "cannot open list " << argv[i] << "\n";
+                return 1;
+            }
+            std::string line;
+            while (std::getline(ifs, line))
+            {
+                std::istringstream iss(line);
+                std::string path;
+                if ((iss >> path) && path[0] != '#') inputs.push_back(path);
+            }
+        }
+        else if (arg == "--threads") threads = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--iterations") iterations = std::atoi(next());
+        else if (arg == "--lr") learningRate = std::atof(next());
+        else if (arg == "--k") k = std::atof(next());
+        else if (arg == "--init") initPath = next();
+        else if (arg == "--skip-plies") skipPlies = std::atoi(next());
+        else if (arg == "--out") outPath = next();
+        else if (arg == "--help" || arg == "-h") { Usage(); return 0; }
+        else if (!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty()) { Usage(); return 2; }
+
+    EvalParams initial = EvalParams::Default();
+    if (!initPath.empty() && !initial.Load(initPath))
+    {
+        std::cerr << "cannot load weights " << initPath << "\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    WorkStealingPool pool(threads);
+
+    // 每个输入文件一个任务（特征计算是载入的主要开销），按输入顺序合并
+    Clock::time_point t0 = Clock::now();
+    std::vector<TuningSet> perFile(inputs.size());
+    std::mutex errorMutex;
+    for (size_t f = 0; f < inputs.size(); ++f)
+    {
+        pool.Submit([&, f](size_t) {
+            const std::string& path = inputs[f];
+            bool ok = EndsWith(path, ".bin") ? LoadShardPositions(path, skipPlies, perFile[f])
+                                             : LoadRecordPositions(path, skipPlies, perFile[f]);
+            if (!ok)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                std::cerr << "warning: cannot read " << path << "\n";
+            }
+        });
+    }
+    pool.Wait();
+    TuningSet data;
+    for (TuningSet& s : perFile)
+    {
+        data.Append(s);
+        s = TuningSet();
+    }
+    double loadSec = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (data.Size() == 0)
+    {
+        std::cerr << "no labelled positions\n";
+        return 1;
+    }
+    std::fprintf(stderr, "loaded %zu positions in %.2f s\n", data.Size(), loadSec);
+
+    // 优化在“评估分值单位”的浮点权重上进行，写出时再转为定点
+    double weights[EVAL_FEATURE_COUNT];
+    for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+        weights[i] = static_cast<double>(initial.weights[i]) / EVAL_WEIGHT_SCALE;
+
+    Tuner tuner(data, pool);
+    if (k <= 0.0) k = FitK(tuner, weights);
+    double initialError = tuner.Compute(weights, k, nullptr);
+    std::fprintf(stderr, "K = %.6f  initial error %.6f\n", k, initialError);
+
+    // Adam
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    double m[EVAL_FEATURE_COUNT] = {};
+    double v[EVAL_FEATURE_COUNT] = {};
+    double error = initialError;
+    t0 = Clock::now();
+    for (int it = 1; it <= iterations; ++it)
+    {
+        double gradient[EVAL_FEATURE_COUNT];
+        error = tuner.Compute(weights, k, gradient);
+        for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+        {
+            m[i] = beta1 * m[i] + (1.0 - beta1) * gradient[i];
+            v[i] = beta2 * v[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+            double mh = m[i] / (1.0 - std::pow(beta1, it));
+            double vh = v[i] / (1.0 - std::pow(beta2, it));
+            weights[i] -= learningRate * mh / (std::sqrt(vh) + epsilon);
+        }
+        if (it % 100 == 0 || it == iterations)
+            std::fprintf(stderr, "iteration %d  error %.6f\n", it, error);
+    }
+    double tuneSec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::fprintf(stderr, "%.2f s, %.1f M position-gradients/s\n", tuneSec,
+                 tuneSec > 0 ? data.Size() * static_cast<double>(iterations) / tuneSec / 1e6 : 0.0);
+
+    EvalParams tuned;
+    for (int i = 0; i < EVAL_FEATURE_COUNT; ++i)
+    {
+        tuned.weights[i] = static_cast<int>(std::lround(weights[i] * EVAL_WEIGHT_SCALE));
+        std::printf("%-16s %10.4f\n", EvalFeatureName(i), weights[i]);
+    }
+    std::printf("error %.6f -> %.6f\n", initialError, error);
+    if (!tuned.Save(outPath))
+    {
+        std::cerr << "cannot write " << outPath << "\n";
+        return 1;
+    }
+    return 0;
+}